@@ -4,8 +4,17 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#pragma once
 
-#include "math.hpp"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NOISE_X86_SIMD
+#include <immintrin.h>
+#endif
 
 //double InversePersistence=NoiseFactor.a;    // for fBms. Persistence indicates how the frequencies are scaled when adding.  Normally a value of 2.0 is used for InversePersistance so that scale goes as 1/pow(invpersistence,i) or 1/pow(2,i). if ip=1->equal low and high noise.  if ip<1,more high noise.
 //double Lacunarity=(INT)(NoiseFactor.b);     // for fBms. Lacunarity indicates how the frequency is changed for each iteration.  Normally a value of 2.0xxxx is used so frequency ~doubles at each iteration.  A value of 1 is the same as 1 octave since no harmonics.
@@ -18,7 +27,6 @@ You should have received a copy of the GNU General Public License along with thi
 #define BM 0xff
 #define NN 0x1000000     // This needs to be a very large value so that when setup adds a value to it it is always positive, regardless of size of argument which may get quite large in fracal sums
 
-int pp[512];  // used by npnoise functions
 int permutation[] = { 151,160,137,91,90,15,
    131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
    190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
@@ -34,14 +42,34 @@ int permutation[] = { 151,160,137,91,90,15,
    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
    };
 
-int p[B + B + 2];   // used by pnoise functions
-     
-// gradients
-double g1[B + B + 2];     // 1D
-double g2[B + B + 2][2];  // 2D
-double g3[B + B + 2][3];  // 3D 
+// gradients, one set per precision the noise is computed in.  The float tables are half the size of the double
+// ones and float callers never convert to double and back.
+template <typename T>
+struct NoiseGradients
+{
+	static T g1[B + B + 2];     // 1D
+	static T g2[B + B + 2][2];  // 2D
+	static T g3[B + B + 2][3];  // 3D 
+};
+template <typename T> T NoiseGradients<T>::g1[B + B + 2];
+template <typename T> T NoiseGradients<T>::g2[B + B + 2][2];
+template <typename T> T NoiseGradients<T>::g3[B + B + 2][3];
+
+// lattice cell b0,b1 and the offsets from its two ends r0,r1.  double keeps the original NN offset arithmetic so
+// its noise is unchanged, but a float has no fraction bits left after adding NN, so it floors instead (by
+// truncating and stepping down, floorf is a library call without SSE4.1)
+static inline void noiseLattice(double v, int &b0, int &b1, double &r0, double &r1)
+{
+	double t = v + NN;
+	b0 = ((int)t) & BM; b1 = (b0+1) & BM; r0 = t - (int)t; r1 = r0 - 1.;
+}
 
-#define setup(i,b0,b1,r0,r1) t = vec[i] + NN; b0 = ((int)t) & BM; b1 = (b0+1) & BM; r0 = t - (int)t; r1 = r0 - 1.;
+static inline void noiseLattice(float v, int &b0, int &b1, float &r0, float &r1)
+{
+	float t = (float)(int)v;
+	t -= (t > v) ? 1.f : 0.f;
+	b0 = ((int)t) & BM; b1 = (b0+1) & BM; r0 = v - t; r1 = r0 - 1.f;
+}
 
 
 static double g_precomputed[][3]= {
@@ -588,42 +616,164 @@ static void normalize3(double v[3])
 */
 //double pnoise1(double vec[]);
 
+/* --- noise context -----------------------------------------------------*/
+// The permutation tables that hash lattice points to gradients, owned by whatever computes the noise, so each Meander
+// instance hashes with its own.  The tables are one allocation, each starting on a cache line, and a context is only
+// written by its own reseed(): building or seeding one never touches tables another instance is reading.  Seed 0 is
+// Ken Perlin's reference permutation, the noise these functions have always made; any other seed shuffles it.  The
+// gradients are the same for every seed, so they stay shared in NoiseGradients and are built once, on first use.
+
+static bool buildNoiseGradients()
+{
+   int i, j;
+   double *g1 = NoiseGradients<double>::g1;
+   double (*g2)[2] = NoiseGradients<double>::g2;
+   double (*g3)[3] = NoiseGradients<double>::g3;
+
+   for (i = 0 ; i < B ; i++)
+   {
+      g1[i] = g_precomputed[i][0];
+      for (j = 0 ; j < 2 ; j++)
+         g2[i][j] = g_precomputed[i][j];
+      normalize2(g2[i]);
+      for (j = 0 ; j < 3 ; j++)
+         g3[i][j] = g_precomputed[i][j];  // already normalized
+   }
+
+   for (i = 0 ; i < B + 2 ; i++)
+   {
+      g1[B + i] = g1[i];
+      for (j = 0 ; j < 2 ; j++)
+         g2[B + i][j] = g2[i][j];
+      for (j = 0 ; j < 3 ; j++)
+         g3[B + i][j] = g3[i][j];
+   }
+
+   for (i = 0 ; i < B + B + 2 ; i++)
+   {
+      NoiseGradients<float>::g1[i] = (float)g1[i];
+      for (j = 0 ; j < 2 ; j++)
+         NoiseGradients<float>::g2[i][j] = (float)g2[i][j];
+      for (j = 0 ; j < 3 ; j++)
+         NoiseGradients<float>::g3[i][j] = (float)g3[i][j];
+   }
+   return true;
+}
+
+static inline void initNoiseGradients()
+{
+   static const bool built = buildNoiseGradients();  // once, and thread safe
+   (void)built;
+}
+
+struct NoiseContext
+{
+   static const int CACHE_LINE=64;
+
+   int *p=nullptr;        // [B+B+2] pnoise permutation, p[B+i]=p[i] so p[b+1] needs no wrap
+   int *pp=nullptr;       // [B+B] npnoise permutation, twice over
+   double *g1p=nullptr;   // [B+B+2] g1[p[i]], so the batch fBm needs one lookup per lattice point
+   float *g1pf=nullptr;   // the same in float
+   uint64_t seed=0;
+
+   explicit NoiseContext(uint64_t newSeed=0)
+   {
+      size_t sizes[4]={(B+B+2)*sizeof(int), (B+B)*sizeof(int), (B+B+2)*sizeof(double), (B+B+2)*sizeof(float)};
+      size_t offsets[4], total=0;
+      for (int i=0;i<4;i++)
+      {
+         offsets[i]=total;
+         total+=(sizes[i]+CACHE_LINE-1)/CACHE_LINE*CACHE_LINE;
+      }
+      storage.resize(total+CACHE_LINE);  // new only aligns to 16 bytes before C++17
+      char *base=storage.data()+(CACHE_LINE-(uintptr_t)storage.data()%CACHE_LINE)%CACHE_LINE;
+      p=(int*)(base+offsets[0]);
+      pp=(int*)(base+offsets[1]);
+      g1p=(double*)(base+offsets[2]);
+      g1pf=(float*)(base+offsets[3]);
+      reseed(newSeed);
+   }
+
+   NoiseContext(const NoiseContext&)=delete;
+   NoiseContext& operator=(const NoiseContext&)=delete;
+
+   // a Fisher-Yates shuffle of the reference permutation driven by splitmix64.  Every entry stays a valid index while
+   // the tables are rewritten.
+   void reseed(uint64_t newSeed)
+   {
+      initNoiseGradients();
+      seed=newSeed;
+      int perm[B];
+      for (int i=0;i<B;i++)
+         perm[i]=permutation[i];
+      uint64_t state=newSeed;
+      for (int i=B-1;(newSeed!=0)&&(i>0);i--)
+      {
+         uint64_t z=(state+=0x9e3779b97f4a7c15ULL);
+         z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+         z=(z^(z>>27))*0x94d049bb133111ebULL;
+         z^=z>>31;
+         std::swap(perm[i], perm[(int)(z%(uint64_t)(i+1))]);
+      }
+      for (int i=0;i<B+B;i++)
+         pp[i]=perm[i&BM];
+      for (int i=0;i<B+B+2;i++)
+      {
+         p[i]=perm[i&BM];
+         g1p[i]=NoiseGradients<double>::g1[p[i]];
+         g1pf[i]=NoiseGradients<float>::g1[p[i]];
+      }
+   }
+
+   const double *gradient1p(double) const { return g1p; }
+   const float *gradient1p(float) const { return g1pf; }
+
+private:
+   std::vector<char> storage;
+};
+
+// the context for callers that do not have their own
+NoiseContext theDefaultNoiseContext;
+
 /* Coherent Perlin noise function over 1, 2 or 3 dimensions */
 // actually lattice noise of the gradient variety
 
-static double pnoise1(double vec[])
+template <typename T>
+static T pnoise1(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
 {  
     int bx0=0, bx1=0;
-    double rx0=0., rx1=0., sx=0., t=0., u=0., v=0.;
+    T rx0=0., rx1=0., sx=0., u=0., v=0.;
+    const T *g1 = NoiseGradients<T>::g1;
 
-    //  #define setup(i,b0,b1,r0,r1) t = vec[i] + NN; b0 = ((int)t) & BM; b1 = (b0+1) & BM; r0 = t - (int)t; r1 = r0 - 1.;
-
-	setup(0, bx0,bx1, rx0,rx1);  // by define this is dependent on vec[0]
+	noiseLattice(vec[0], bx0,bx1, rx0,rx1);
        
     sx = fade(rx0);
    
-	u = rx0 * g1[ p[ bx0 ] ];
-	v = rx1 * g1[ p[ bx1 ] ];
+	u = rx0 * g1[ noise.p[ bx0 ] ];
+	v = rx1 * g1[ noise.p[ bx1 ] ];
        
-    return 2.1*lerp(sx, u, v);      // essentially scales a -.5 to +.5 distribution to -1 to 1
+    return T(2.1)*lerp(sx, u, v);      // essentially scales a -.5 to +.5 distribution to -1 to 1
 }
 
-static double pnoise2(double vec[])
+template <typename T>
+static T pnoise2(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
 {
 	int bx0, bx1, by0, by1, b00, b10, b01, b11;
-        double rx0, rx1, ry0, ry1, *q, sx, sy, a, b, t, u, v;
+        T rx0, rx1, ry0, ry1, sx, sy, a, b, u, v;
+	const T *q;
+	const T (*g2)[2] = NoiseGradients<T>::g2;
 	int  i, j;
 
-    setup(0, bx0,bx1, rx0,rx1);
-    setup(1, by0,by1, ry0,ry1);
+    noiseLattice(vec[0], bx0,bx1, rx0,rx1);
+    noiseLattice(vec[1], by0,by1, ry0,ry1);
 
-    i = p[ bx0 ];
-    j = p[ bx1 ];
+    i = noise.p[ bx0 ];
+    j = noise.p[ bx1 ];
 
-    b00 = p[ i + by0 ];
-    b10 = p[ j + by0 ];
-    b01 = p[ i + by1 ];
-    b11 = p[ j + by1 ];
+    b00 = noise.p[ i + by0 ];
+    b10 = noise.p[ j + by0 ];
+    b01 = noise.p[ i + by1 ];
+    b11 = noise.p[ j + by1 ];
 
     sx = fade(rx0);
     sy = fade(ry0);
@@ -638,28 +788,31 @@ static double pnoise2(double vec[])
 	q = g2[ b11 ] ; v = at2(rx1,ry1);
 	b = lerp(sx, u, v);
 
-    return 1.5*lerp(sy, a, b);       // essentially scales a gaussian -.7 to +.7 distribution to -1 to 1
+    return T(1.5)*lerp(sy, a, b);       // essentially scales a gaussian -.7 to +.7 distribution to -1 to 1
 }
 
 int test_count=0;
 
-static double pnoise3(double vec[])
+template <typename T>
+static T pnoise3(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
 {
 	int bx0, bx1, by0, by1, bz0, bz1, b00, b10, b01, b11;
-        double rx0, rx1, ry0, ry1, rz0, rz1, *q, sy, sz, a, b, c, d, t, u, v;
+        T rx0, rx1, ry0, ry1, rz0, rz1, sy, sz, a, b, c, d, t, u, v;
+	const T *q;
+	const T (*g3)[3] = NoiseGradients<T>::g3;
 	int i, j;
 
-	setup(0, bx0,bx1, rx0,rx1);
-	setup(1, by0,by1, ry0,ry1);
-	setup(2, bz0,bz1, rz0,rz1);
+	noiseLattice(vec[0], bx0,bx1, rx0,rx1);
+	noiseLattice(vec[1], by0,by1, ry0,ry1);
+	noiseLattice(vec[2], bz0,bz1, rz0,rz1);
 
-        i = p[ bx0 ];
-        j = p[ bx1 ];
+        i = noise.p[ bx0 ];
+        j = noise.p[ bx1 ];
 
-        b00 = p[ i + by0 ];
-        b10 = p[ j + by0 ];
-        b01 = p[ i + by1 ];
-        b11 = p[ j + by1 ];
+        b00 = noise.p[ i + by0 ];
+        b10 = noise.p[ j + by0 ];
+        b01 = noise.p[ i + by1 ];
+        b11 = noise.p[ j + by1 ];
 
         t  = fade(rx0);
         sy = fade(ry0);
@@ -688,7 +841,7 @@ static double pnoise3(double vec[])
 
         d = lerp(sy, a, b);
 
-        return 1.5*lerp(sz, c, d);       // essentially scales a gaussian -.7 to +.7 distribution to -1 to 1
+        return T(1.5)*lerp(sz, c, d);       // essentially scales a gaussian -.7 to +.7 distribution to -1 to 1
 }
 
 
@@ -696,7 +849,8 @@ static double pnoise3(double vec[])
 // actually these are fBM (fractional Brownian motion) functions
 
 // -1 to +1 noise
-double fBm1DNoise(double x,double InversePersistence,double Lacunarity,int n_octaves)
+template <typename T>
+T fBm1DNoise(T x,T InversePersistence,T Lacunarity,int n_octaves, const NoiseContext& noise=theDefaultNoiseContext)
 {
   
    if (n_octaves<1) n_octaves=1;
@@ -707,13 +861,13 @@ double fBm1DNoise(double x,double InversePersistence,double Lacunarity,int n_oct
    if (Lacunarity>4.0) Lacunarity=4.0;
 
    int i;
-   double val,sum = 0;
-   double p[1],scale = 1;
+   T val,sum = 0;
+   T p[1],scale = 1;
 
    p[0] = x;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise1(p);
+      val = pnoise1(p, noise);
       sum += val / scale;
       scale *= InversePersistence;
       p[0] *= Lacunarity;
@@ -721,28 +875,632 @@ double fBm1DNoise(double x,double InversePersistence,double Lacunarity,int n_oct
    return(sum);
 }
 
-double FastfBm1DNoise(double x,int n_octaves)  // fixed invpersistence=2. and lacunarity=2.
+template <typename T>
+T FastfBm1DNoise(T x,int n_octaves, const NoiseContext& noise=theDefaultNoiseContext)  // fixed invpersistence=2. and lacunarity=2.
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
    
    int i;
-   double val,sum = 0;
-   double p[1],scale = 1;
+   T val,sum = 0;
+   T p[1],scale = 1;
 
    p[0] = x;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise1(p);
+      val = pnoise1(p, noise);
       sum += val / scale;
-      scale *= 2.;
-      p[0] *= 2.02345;
+      scale *= T(2.);
+      p[0] *= T(2.02345);
+   }
+   return(sum);
+}
+
+/* --- table-free hash noise ---------------------------------------------*/
+// pnoise1 with its gradients made by hashing the lattice point with a seed instead of looked up through a
+// permutation: no tables to load or to keep per instance, any 32 bit seed is its own noise, and the lattice does
+// not wrap every 256.  A gradient is uniform on [-1,1), as pnoise1's are (they are the x of unit vectors), so the
+// noise has the same distribution and spectrum; bench_noise compares the two.  All integer multiply, shift and
+// xor, so a block of it vectorizes.
+
+static inline uint32_t noiseHash(uint32_t x, uint32_t seed)  // the lowbias32 finalizer of the point and seed
+{
+   x ^= seed * 0x9e3779b9u;
+   x ^= x >> 16;
+   x *= 0x7feb352du;
+   x ^= x >> 15;
+   x *= 0x846ca68bu;
+   x ^= x >> 16;
+   return x;
+}
+
+template <typename T>
+static inline T hashGradient1(int32_t b, uint32_t seed)
+{
+   return T((int32_t)noiseHash((uint32_t)b, seed)) * T(1./2147483648.);
+}
+
+template <typename T>
+static inline T hashNoise1(T x, uint32_t seed)
+{
+   int32_t b0 = (int32_t)x;  // floor by truncating and stepping down, in integers: a float select would not vectorize
+   b0 -= (x < T(b0));
+   T rx0 = x - T(b0), rx1 = rx0 - T(1.);
+
+   T u = rx0 * hashGradient1<T>(b0, seed);
+   T v = rx1 * hashGradient1<T>(b0+1, seed);
+   return T(2.1)*lerp(fade(rx0), u, v);  // the same kernel and scale as pnoise1
+}
+
+template <typename T>
+static T hnoise1(const T vec[], uint32_t seed=0)
+{
+   return hashNoise1(vec[0], seed);
+}
+
+template <typename T>
+T FastfBm1DHashNoise(T x,int n_octaves, uint32_t seed=0)  // FastfBm1DNoise on hnoise1
+{
+   if (n_octaves<1) n_octaves=1;
+   if (n_octaves>6) n_octaves=6;
+
+   T sum = 0, scale = 1;
+   T p[1] = {x};
+   for (int i=0;i<n_octaves;i++)
+   {
+      sum += hashNoise1(p[0], seed) / scale;
+      scale *= T(2.);
+      p[0] *= T(2.02345);
    }
    return(sum);
 }
 
+// out[i]=FastfBm1DHashNoise(x[i], n_octaves, seed) for count points, bit for bit.  The octaves run over fixed 8 point
+// chunks, so they vectorize at -O2 as well as -O3.
+template <typename T>
+void FastfBm1DHashNoiseBlock(const T *x, int n_octaves, T *out, int count, uint32_t seed=0)
+{
+   if (n_octaves<1) n_octaves=1;
+   if (n_octaves>6) n_octaves=6;
+
+   int i=0;
+   for (;i+8<=count;i+=8)
+   {
+      T p[8], sum[8];
+      for (int k=0;k<8;k++)
+      {
+         p[k] = x[i+k];
+         sum[k] = 0;
+      }
+      T scale = 1;
+      for (int o=0;o<n_octaves;o++)
+      {
+         for (int k=0;k<8;k++)
+         {
+            sum[k] += hashNoise1(p[k], seed) / scale;
+            p[k] *= T(2.02345);
+         }
+         scale *= T(2.);
+      }
+      for (int k=0;k<8;k++)
+         out[i+k] = sum[k];
+   }
+   for (;i<count;i++)
+      out[i]=FastfBm1DHashNoise(x[i], n_octaves, seed);
+}
+
+/* --- batch fBm --------------------------------------------------------*/
+// out[i]=FastfBm1DNoise(x[i], n_octaves[i]) for count points, bit for bit the same as the scalar calls: the same
+// operations in the same order, a lane just adds nothing once it is past its own octave count.
+// FastfBm1DNoiseBatch() picks the AVX2 or SSE2 version once, by what the CPU has.  A vector holds 4 doubles or
+// 8 floats with AVX2, 2 doubles or 4 floats with SSE2.  All hash with the context's permutation.
+
+template <typename T>
+using fBm1DBatchFunction = void (*)(const T *x, const int *n_octaves, T *out, int count, const NoiseContext& noise);
+
+static inline int clampOctaves(int n_octaves)
+{
+   return (n_octaves<1) ? 1 : (n_octaves>6) ? 6 : n_octaves;
+}
+
+void FastfBm1DNoiseBatchScalar(const double *x, const int *n_octaves, double *out, int count, const NoiseContext& noise)
+{
+   for (int i=0;i<count;i++)
+      out[i]=FastfBm1DNoise(x[i], n_octaves[i], noise);
+}
+
+void FastfBm1DNoiseBatchScalar(const float *x, const int *n_octaves, float *out, int count, const NoiseContext& noise)
+{
+   for (int i=0;i<count;i++)
+      out[i]=FastfBm1DNoise(x[i], n_octaves[i], noise);
+}
+
+#ifdef NOISE_X86_SIMD
+
+void FastfBm1DNoiseBatchSSE2(const double *x, const int *n_octaves, double *out, int count, const NoiseContext& noise)
+{
+   int i=0;
+   for (;i+2<=count;i+=2)
+   {
+      int octaves[2]={clampOctaves(n_octaves[i]), clampOctaves(n_octaves[i+1])};
+      int maxoctaves=std::max(octaves[0], octaves[1]);
+      const double *g1p=noise.gradient1p(double());
+      __m128d px=_mm_loadu_pd(x+i);
+      __m128d sum=_mm_setzero_pd();
+      __m128d invscale=_mm_set1_pd(1.);  // 1/scale, exact since scale is a power of 2
+      for (int o=0;o<maxoctaves;o++)
+      {
+         __m128d t=_mm_add_pd(px, _mm_set1_pd(NN));
+         __m128i it=_mm_cvttpd_epi32(t);
+         int bx[2]={_mm_cvtsi128_si32(it)&BM, _mm_cvtsi128_si32(_mm_srli_si128(it, 4))&BM};
+         __m128d rx0=_mm_sub_pd(t, _mm_cvtepi32_pd(it));
+         __m128d rx1=_mm_sub_pd(rx0, _mm_set1_pd(1.));
+         __m128d sx=_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(rx0, rx0), rx0), _mm_add_pd(_mm_mul_pd(rx0, _mm_sub_pd(_mm_mul_pd(rx0, _mm_set1_pd(6.)), _mm_set1_pd(15.))), _mm_set1_pd(10.)));
+         __m128d u=_mm_mul_pd(rx0, _mm_set_pd(g1p[bx[1]], g1p[bx[0]]));
+         __m128d v=_mm_mul_pd(rx1, _mm_set_pd(g1p[(bx[1]+1)&BM], g1p[(bx[0]+1)&BM]));
+         __m128d val=_mm_mul_pd(_mm_set1_pd(2.1), _mm_add_pd(u, _mm_mul_pd(sx, _mm_sub_pd(v, u))));
+         __m128d live=_mm_castsi128_pd(_mm_set_epi32(-(o<octaves[1]), -(o<octaves[1]), -(o<octaves[0]), -(o<octaves[0])));
+         sum=_mm_add_pd(sum, _mm_and_pd(live, _mm_mul_pd(val, invscale)));
+         invscale=_mm_mul_pd(invscale, _mm_set1_pd(.5));
+         px=_mm_mul_pd(px, _mm_set1_pd(2.02345));
+      }
+      _mm_storeu_pd(out+i, sum);
+   }
+   FastfBm1DNoiseBatchScalar(x+i, n_octaves+i, out+i, count-i, noise);
+}
+
+void FastfBm1DNoiseBatchSSE2(const float *x, const int *n_octaves, float *out, int count, const NoiseContext& noise)
+{
+   int i=0;
+   for (;i+4<=count;i+=4)
+   {
+      int octaves[4];
+      int maxoctaves=1;
+      for (int k=0;k<4;k++)
+      {
+         octaves[k]=clampOctaves(n_octaves[i+k]);
+         maxoctaves=std::max(maxoctaves, octaves[k]);
+      }
+      __m128i octavesv=_mm_loadu_si128((const __m128i*)octaves);
+      const float *g1p=noise.gradient1p(float());
+      __m128 px=_mm_loadu_ps(x+i);
+      __m128 sum=_mm_setzero_ps();
+      __m128 invscale=_mm_set1_ps(1.f);  // 1/scale, exact since scale is a power of 2
+      for (int o=0;o<maxoctaves;o++)
+      {
+         __m128 t=_mm_cvtepi32_ps(_mm_cvttps_epi32(px));
+         t=_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, px), _mm_set1_ps(1.f)));  // floor, SSE2 has only truncation
+         int bx[4];
+         _mm_storeu_si128((__m128i*)bx, _mm_and_si128(_mm_cvttps_epi32(t), _mm_set1_epi32(BM)));
+         __m128 rx0=_mm_sub_ps(px, t);
+         __m128 rx1=_mm_sub_ps(rx0, _mm_set1_ps(1.f));
+         __m128 sx=_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(rx0, rx0), rx0), _mm_add_ps(_mm_mul_ps(rx0, _mm_sub_ps(_mm_mul_ps(rx0, _mm_set1_ps(6.f)), _mm_set1_ps(15.f))), _mm_set1_ps(10.f)));
+         __m128 u=_mm_mul_ps(rx0, _mm_setr_ps(g1p[bx[0]], g1p[bx[1]], g1p[bx[2]], g1p[bx[3]]));
+         __m128 v=_mm_mul_ps(rx1, _mm_setr_ps(g1p[(bx[0]+1)&BM], g1p[(bx[1]+1)&BM], g1p[(bx[2]+1)&BM], g1p[(bx[3]+1)&BM]));
+         __m128 val=_mm_mul_ps(_mm_set1_ps(2.1f), _mm_add_ps(u, _mm_mul_ps(sx, _mm_sub_ps(v, u))));
+         __m128 live=_mm_castsi128_ps(_mm_cmpgt_epi32(octavesv, _mm_set1_epi32(o)));
+         sum=_mm_add_ps(sum, _mm_and_ps(live, _mm_mul_ps(val, invscale)));
+         invscale=_mm_mul_ps(invscale, _mm_set1_ps(.5f));
+         px=_mm_mul_ps(px, _mm_set1_ps(2.02345f));
+      }
+      _mm_storeu_ps(out+i, sum);
+   }
+   FastfBm1DNoiseBatchScalar(x+i, n_octaves+i, out+i, count-i, noise);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d gatherGradient1(const double *g1p, __m128i bx)
+{
+   __m256d all=_mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+   return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), g1p, bx, all, 8);
+}
+
+__attribute__((target("avx2")))
+void FastfBm1DNoiseBatchAVX2(const double *x, const int *n_octaves, double *out, int count, const NoiseContext& noise)
+{
+   int i=0;
+   for (;i+4<=count;i+=4)
+   {
+      __m128i octaves=_mm_loadu_si128((const __m128i*)(n_octaves+i));
+      octaves=_mm_min_epi32(_mm_max_epi32(octaves, _mm_set1_epi32(1)), _mm_set1_epi32(6));
+      int maxoctaves=1;
+      for (int k=0;k<4;k++)
+         maxoctaves=std::max(maxoctaves, clampOctaves(n_octaves[i+k]));
+      const double *g1p=noise.gradient1p(double());
+      __m256d px=_mm256_loadu_pd(x+i);
+      __m256d sum=_mm256_setzero_pd();
+      __m256d invscale=_mm256_set1_pd(1.);  // 1/scale, exact since scale is a power of 2
+      for (int o=0;o<maxoctaves;o++)
+      {
+         __m256d t=_mm256_add_pd(px, _mm256_set1_pd(NN));
+         __m128i it=_mm256_cvttpd_epi32(t);
+         __m128i bx0=_mm_and_si128(it, _mm_set1_epi32(BM));
+         __m128i bx1=_mm_and_si128(_mm_add_epi32(bx0, _mm_set1_epi32(1)), _mm_set1_epi32(BM));
+         __m256d rx0=_mm256_sub_pd(t, _mm256_cvtepi32_pd(it));
+         __m256d rx1=_mm256_sub_pd(rx0, _mm256_set1_pd(1.));
+         __m256d sx=_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(rx0, rx0), rx0), _mm256_add_pd(_mm256_mul_pd(rx0, _mm256_sub_pd(_mm256_mul_pd(rx0, _mm256_set1_pd(6.)), _mm256_set1_pd(15.))), _mm256_set1_pd(10.)));
+         __m256d u=_mm256_mul_pd(rx0, gatherGradient1(g1p, bx0));
+         __m256d v=_mm256_mul_pd(rx1, gatherGradient1(g1p, bx1));
+         __m256d val=_mm256_mul_pd(_mm256_set1_pd(2.1), _mm256_add_pd(u, _mm256_mul_pd(sx, _mm256_sub_pd(v, u))));
+         __m256d live=_mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(octaves, _mm_set1_epi32(o))));
+         sum=_mm256_add_pd(sum, _mm256_and_pd(live, _mm256_mul_pd(val, invscale)));
+         invscale=_mm256_mul_pd(invscale, _mm256_set1_pd(.5));
+         px=_mm256_mul_pd(px, _mm256_set1_pd(2.02345));
+      }
+      _mm256_storeu_pd(out+i, sum);
+   }
+   FastfBm1DNoiseBatchSSE2(x+i, n_octaves+i, out+i, count-i, noise);
+}
+
+__attribute__((target("avx2")))
+static inline __m256 gatherGradient1(const float *g1p, __m256i bx)
+{
+   __m256 all=_mm256_castsi256_ps(_mm256_set1_epi32(-1));
+   return _mm256_mask_i32gather_ps(_mm256_setzero_ps(), g1p, bx, all, 4);
+}
+
+__attribute__((target("avx2")))
+void FastfBm1DNoiseBatchAVX2(const float *x, const int *n_octaves, float *out, int count, const NoiseContext& noise)
+{
+   int i=0;
+   for (;i+8<=count;i+=8)
+   {
+      __m256i octaves=_mm256_loadu_si256((const __m256i*)(n_octaves+i));
+      octaves=_mm256_min_epi32(_mm256_max_epi32(octaves, _mm256_set1_epi32(1)), _mm256_set1_epi32(6));
+      int maxoctaves=1;
+      for (int k=0;k<8;k++)
+         maxoctaves=std::max(maxoctaves, clampOctaves(n_octaves[i+k]));
+      const float *g1p=noise.gradient1p(float());
+      __m256 px=_mm256_loadu_ps(x+i);
+      __m256 sum=_mm256_setzero_ps();
+      __m256 invscale=_mm256_set1_ps(1.f);  // 1/scale, exact since scale is a power of 2
+      for (int o=0;o<maxoctaves;o++)
+      {
+         __m256 t=_mm256_floor_ps(px);
+         __m256i bx0=_mm256_and_si256(_mm256_cvttps_epi32(t), _mm256_set1_epi32(BM));
+         __m256i bx1=_mm256_and_si256(_mm256_add_epi32(bx0, _mm256_set1_epi32(1)), _mm256_set1_epi32(BM));
+         __m256 rx0=_mm256_sub_ps(px, t);
+         __m256 rx1=_mm256_sub_ps(rx0, _mm256_set1_ps(1.f));
+         __m256 sx=_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(rx0, rx0), rx0), _mm256_add_ps(_mm256_mul_ps(rx0, _mm256_sub_ps(_mm256_mul_ps(rx0, _mm256_set1_ps(6.f)), _mm256_set1_ps(15.f))), _mm256_set1_ps(10.f)));
+         __m256 u=_mm256_mul_ps(rx0, gatherGradient1(g1p, bx0));
+         __m256 v=_mm256_mul_ps(rx1, gatherGradient1(g1p, bx1));
+         __m256 val=_mm256_mul_ps(_mm256_set1_ps(2.1f), _mm256_add_ps(u, _mm256_mul_ps(sx, _mm256_sub_ps(v, u))));
+         __m256 live=_mm256_castsi256_ps(_mm256_cmpgt_epi32(octaves, _mm256_set1_epi32(o)));
+         sum=_mm256_add_ps(sum, _mm256_and_ps(live, _mm256_mul_ps(val, invscale)));
+         invscale=_mm256_mul_ps(invscale, _mm256_set1_ps(.5f));
+         px=_mm256_mul_ps(px, _mm256_set1_ps(2.02345f));
+      }
+      _mm256_storeu_ps(out+i, sum);
+   }
+   FastfBm1DNoiseBatchSSE2(x+i, n_octaves+i, out+i, count-i, noise);
+}
+
+#endif
+
+template <typename T>
+static fBm1DBatchFunction<T> selectfBm1DBatch(const char **name)
+{
+#ifdef NOISE_X86_SIMD
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+   {
+      *name="AVX2";
+      return FastfBm1DNoiseBatchAVX2;
+   }
+   *name="SSE2";
+   return FastfBm1DNoiseBatchSSE2;
+#else
+   *name="scalar";
+   return FastfBm1DNoiseBatchScalar;
+#endif
+}
+
+const char *fBm1DBatchISA="";  // which version FastfBm1DNoiseBatch() runs, set on first use
+
+void FastfBm1DNoiseBatch(const double *x, const int *n_octaves, double *out, int count, const NoiseContext& noise=theDefaultNoiseContext)
+{
+   static const fBm1DBatchFunction<double> batch=selectfBm1DBatch<double>(&fBm1DBatchISA);
+   batch(x, n_octaves, out, count, noise);
+}
+
+void FastfBm1DNoiseBatch(const float *x, const int *n_octaves, float *out, int count, const NoiseContext& noise=theDefaultNoiseContext)
+{
+   static const fBm1DBatchFunction<float> batch=selectfBm1DBatch<float>(&fBm1DBatchISA);
+   batch(x, n_octaves, out, count, noise);
+}
+
+/* --- wavetable fBm -----------------------------------------------------*/
+// FastfBm1DNoise(origin+u) tabulated for every octave count 1-6, so reading the fBm costs one cubic interpolation
+// whatever the octave count.  The table covers UNITS lattice units from origin and then repeats; over its last
+// BLEND_UNITS it crossfades into the noise just before origin, so it wraps without a step.  Everywhere else the
+// samples are exactly FastfBm1DNoise() and only the interpolation differs, see bench_noise for how much.  A caller
+// that needs the noise itself rather than a loop reads the table only where covers() and computes it elsewhere.
+
+struct fBm1DWavetable
+{
+   static const int UNITS=64;
+   static const int SAMPLES_PER_UNIT=128;
+   static const int BLEND_UNITS=4;
+   static const int SIZE=UNITS*SAMPLES_PER_UNIT;  // a power of 2
+   static const int STRIDE=SIZE+3;  // one guard sample before and two after each table, for the cubic
+
+   double origin=0.;
+   uint64_t noise_seed=0;  // of the context it was built from
+   bool built=false;
+   std::vector<float> tables;  // [(n_octaves-1)*STRIDE+1+i]
+
+   // octave by octave in the same order as FastfBm1DNoise(), so the table for n octaves is the n-1 table plus one
+   // more pnoise1() per sample.  Allocates and takes about 0.45 ms, so not for the audio thread.
+   void build(double fromOrigin, const NoiseContext& noise=theDefaultNoiseContext)
+   {
+      origin=fromOrigin;
+      noise_seed=noise.seed;
+      built=true;
+      tables.assign(6*STRIDE, 0.f);
+      const int blendStart=SIZE-BLEND_UNITS*SAMPLES_PER_UNIT;
+      for (int i=0;i<SIZE;i++)
+      {
+         double p[1]={origin+(double)i/SAMPLES_PER_UNIT};
+         double pb[1]={origin+(double)(i-SIZE)/SAMPLES_PER_UNIT};  // where the table wraps to
+         double fade=(i<blendStart) ? 0. : (double)(i-blendStart)/(SIZE-blendStart);
+         fade=fade*fade*(3.-2.*fade);
+         double sum=0., sumb=0., scale=1.;
+         for (int n=0;n<6;n++)
+         {
+            sum += pnoise1(p, noise) / scale;
+            if (fade>0.)
+               sumb += pnoise1(pb, noise) / scale;
+            scale *= 2.;
+            p[0] *= 2.02345;
+            pb[0] *= 2.02345;
+            tables[n*STRIDE+1+i]=(float)(sum+fade*(sumb-sum));
+         }
+      }
+      for (int n=0;n<6;n++)
+      {
+         float *table=&tables[n*STRIDE+1];
+         table[-1]=table[SIZE-1];
+         table[SIZE]=table[0];
+         table[SIZE+1]=table[1];
+      }
+   }
+
+   // whether lookup(u) reads only unblended samples, the first UNITS-BLEND_UNITS units less the cubic's reach
+   bool covers(double u) const
+   {
+      return (u>=0.)&&(u*SAMPLES_PER_UNIT<SIZE-BLEND_UNITS*SAMPLES_PER_UNIT-2);
+   }
+
+   float lookup(double u, int n_octaves) const
+   {
+      double position=u*SAMPLES_PER_UNIT;
+      double whole=(double)(long long)position;
+      whole-=(whole>position) ? 1. : 0.;  // floor, without the library call
+      int i=(int)((long long)whole & (SIZE-1));  // SIZE is a power of 2
+      float f=(float)(position-whole);
+      const float *y=&tables[(clampOctaves(n_octaves)-1)*STRIDE+1+i];
+      // Catmull-Rom through y[-1] y[0] y[1] y[2]
+      return y[0]+0.5f*f*(y[1]-y[-1]+f*(2.f*y[-1]-5.f*y[0]+4.f*y[1]-y[2]+f*(3.f*(y[0]-y[1])+y[2]-y[-1])));
+   }
+};
+
+/* --- incremental fBm ---------------------------------------------------*/
+// out[i]=FastfBm1DNoise(x+i*dx, n_octaves) for count points, for audio-rate fBm.  Within one lattice cell an octave is
+// a degree 6 polynomial of the offset into the cell, and so of i.  Each octave adds its polynomial in i into one sum,
+// so past a few operations per octave per call a point costs one 6th degree polynomial whatever the octave count.
+// At audio rates a block of a few dozen points rarely crosses a cell; an octave that does is computed point by point
+// with pnoise1() instead.  Agrees with FastfBm1DNoise() to about 1e-7.
+
+template <typename T>
+void FastfBm1DNoiseRamp(double x, double dx, int n_octaves, T *out, int count, const NoiseContext& noise=theDefaultNoiseContext)
+{
+   const double *g1 = NoiseGradients<double>::g1;
+   n_octaves = clampOctaves(n_octaves);
+   for (int i=0;i<count;i++)
+      out[i] = T(0);
+
+   double sum[7] = {};  // coefficients of i^0..i^6
+   double xo = x, dxo = dx, scale = 1.;
+   for (int n=0;n<n_octaves;n++)
+   {
+      int b0, b1;
+      double r0, r1;
+      noiseLattice(xo, b0,b1, r0,r1);
+      double rLast = r0 + (count-1)*dxo;
+      if ((rLast>=0.)&&(rLast<1.))  // all in one cell
+      {
+         // pnoise1() is 2.1*lerp(fade(t), t*g0, (t-1)*g1), in powers of t that is
+         double w = 2.1/scale, ga = g1[noise.p[b0]], gb = g1[noise.p[b1]], a = gb-ga, c = -gb;
+         double poly[7] = {0., w*ga, 0., w*10.*c, w*(10.*a-15.*c), w*(6.*c-15.*a), w*6.*a};
+         // and t=r0+i*dxo, so shift it to r0 (Horner's synthetic division) then scale by dxo
+         for (int k=0;k<6;k++)
+            for (int j=5;j>=k;j--)
+               poly[j] += r0*poly[j+1];
+         double dk = 1.;
+         for (int k=0;k<7;k++)
+         {
+            sum[k] += poly[k]*dk;
+            dk *= dxo;
+         }
+      }
+      else
+      {
+         for (int i=0;i<count;i++)
+         {
+            double q[1] = {xo + i*dxo};
+            out[i] += T(pnoise1(q, noise) / scale);
+         }
+      }
+      scale *= 2.;
+      xo *= 2.02345;
+      dxo *= 2.02345;
+   }
+
+   // in double: at audio rates the high powers of dxo are far below the smallest normal float
+   int i = 0;
+   for (;i+8<=count;i+=8)  // a fixed trip count, so it vectorizes at -O2 too
+      for (int k=0;k<8;k++)
+      {
+         double t = i+k;
+         out[i+k] += T(sum[0]+t*(sum[1]+t*(sum[2]+t*(sum[3]+t*(sum[4]+t*(sum[5]+t*sum[6]))))));
+      }
+   for (;i<count;i++)
+   {
+      double t = i;
+      out[i] += T(sum[0]+t*(sum[1]+t*(sum[2]+t*(sum[3]+t*(sum[4]+t*(sum[5]+t*sum[6]))))));
+   }
+}
+
+// simplex noise: the lattice is skewed into simplices, so a sample sums N+1 corner kernels instead of blending the
+// 2^N corners of a cube.  Hashes through the same permutation as npnoise3/npnoise4, so it reseeds with the context.
+// About -1 to +1, like pnoise2 and npnoise3/4.
+enum NoiseBasis { NOISE_PERLIN, NOISE_SIMPLEX };  // the lattice noise an fBm sums, picked per call
+
+template <typename T>
+static inline int simplexFloor(T v)
+{
+   int i = (int)v;
+   return (v < T(i)) ? i-1 : i;
+}
+
+// the falloff kernel of one corner, (r2-d^2)^4 clamped at 0 without a branch: which corners reach a point is random
+template <typename T>
+static inline T simplexKernel(T t)
+{
+   t = (t > 0) ? t : T(0.);
+   t *= t;
+   return t*t;
+}
+
+// the gradients are looked up rather than picked with grad3/grad4's selects, which mispredict on every random hash
+static const signed char simplexGradients2[8][2] = {
+   {1,2},{-1,2},{1,-2},{-1,-2},{2,1},{-2,1},{2,-1},{-2,-1}};
+static const signed char simplexGradients3[16][3] = {  // the 12 cube edge directions, as grad3
+   {1,1,0},{-1,1,0},{1,-1,0},{-1,-1,0},{1,0,1},{-1,0,1},{1,0,-1},{-1,0,-1},
+   {0,1,1},{0,-1,1},{0,1,-1},{0,-1,-1},{1,1,0},{0,-1,1},{-1,1,0},{0,-1,-1}};
+static const signed char simplexGradients4[32][4] = {  // the 32 tesseract edge directions
+   {0,1,1,1},{0,1,1,-1},{0,1,-1,1},{0,1,-1,-1},{0,-1,1,1},{0,-1,1,-1},{0,-1,-1,1},{0,-1,-1,-1},
+   {1,0,1,1},{1,0,1,-1},{1,0,-1,1},{1,0,-1,-1},{-1,0,1,1},{-1,0,1,-1},{-1,0,-1,1},{-1,0,-1,-1},
+   {1,1,0,1},{1,1,0,-1},{1,-1,0,1},{1,-1,0,-1},{-1,1,0,1},{-1,1,0,-1},{-1,-1,0,1},{-1,-1,0,-1},
+   {1,1,1,0},{1,1,-1,0},{1,-1,1,0},{1,-1,-1,0},{-1,1,1,0},{-1,1,-1,0},{-1,-1,1,0},{-1,-1,-1,0}};
+
+template <typename T>
+static inline T simplexGrad2(int hash, T x, T y)
+{
+   const signed char *g = simplexGradients2[hash & 7];
+   return T(g[0])*x + T(g[1])*y;
+}
+
+template <typename T>
+static inline T simplexGrad3(int hash, T x, T y, T z)
+{
+   const signed char *g = simplexGradients3[hash & 15];
+   return T(g[0])*x + T(g[1])*y + T(g[2])*z;
+}
+
+template <typename T>
+static inline T simplexGrad4(int hash, T x, T y, T z, T w)
+{
+   const signed char *g = simplexGradients4[hash & 31];
+   return T(g[0])*x + T(g[1])*y + T(g[2])*z + T(g[3])*w;
+}
+
+template <typename T>
+T snoise2(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
+{
+   const T F2 = T(0.366025403784438647), G2 = T(0.211324865405187118);  // (sqrt(3)-1)/2, (3-sqrt(3))/6
+   const int *perm = noise.pp;
+
+   T s = (vec[0]+vec[1])*F2;                      // skew to find the simplex cell
+   int i = simplexFloor(vec[0]+s);
+   int j = simplexFloor(vec[1]+s);
+   T t = T(i+j)*G2;
+   T x0 = vec[0]-(T(i)-t);                        // unskewed offset from the cell origin
+   T y0 = vec[1]-(T(j)-t);
+
+   int i1 = (x0 > y0) ? 1 : 0;                    // lower or upper triangle
+   int j1 = 1-i1;
+   T x1 = x0-T(i1)+G2,       y1 = y0-T(j1)+G2;
+   T x2 = x0-T(1.)+T(2.)*G2, y2 = y0-T(1.)+T(2.)*G2;
+
+   int ii = i & BM, jj = j & BM;
+   T n = simplexKernel(T(0.5)-x0*x0-y0*y0)*simplexGrad2(perm[ii+perm[jj]], x0, y0)
+       + simplexKernel(T(0.5)-x1*x1-y1*y1)*simplexGrad2(perm[ii+i1+perm[jj+j1]], x1, y1)
+       + simplexKernel(T(0.5)-x2*x2-y2*y2)*simplexGrad2(perm[ii+1+perm[jj+1]], x2, y2);
+   return T(40.)*n;
+}
+
+template <typename T>
+T snoise3(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
+{
+   const T F3 = T(1./3.), G3 = T(1./6.);
+   const int *perm = noise.pp;
+
+   T s = (vec[0]+vec[1]+vec[2])*F3;
+   int i = simplexFloor(vec[0]+s);
+   int j = simplexFloor(vec[1]+s);
+   int k = simplexFloor(vec[2]+s);
+   T t = T(i+j+k)*G3;
+   T x0 = vec[0]-(T(i)-t);
+   T y0 = vec[1]-(T(j)-t);
+   T z0 = vec[2]-(T(k)-t);
+
+   // which of the 6 tetrahedra, by ranking x0,y0,z0: the largest steps at the second corner, the middle one at the third
+   int rx = (x0 >= y0) + (x0 >= z0);
+   int ry = (x0 < y0) + (y0 >= z0);
+   int rz = (x0 < z0) + (y0 < z0);
+   int i1 = (rx >= 2), j1 = (ry >= 2), k1 = (rz >= 2);
+   int i2 = (rx >= 1), j2 = (ry >= 1), k2 = (rz >= 1);
+
+   T x1 = x0-T(i1)+G3,        y1 = y0-T(j1)+G3,        z1 = z0-T(k1)+G3;
+   T x2 = x0-T(i2)+T(2.)*G3,  y2 = y0-T(j2)+T(2.)*G3,  z2 = z0-T(k2)+T(2.)*G3;
+   T x3 = x0-T(1.)+T(3.)*G3,  y3 = y0-T(1.)+T(3.)*G3,  z3 = z0-T(1.)+T(3.)*G3;
+
+   int ii = i & BM, jj = j & BM, kk = k & BM;
+   T n = simplexKernel(T(0.6)-x0*x0-y0*y0-z0*z0)*simplexGrad3(perm[ii+perm[jj+perm[kk]]], x0, y0, z0)
+       + simplexKernel(T(0.6)-x1*x1-y1*y1-z1*z1)*simplexGrad3(perm[ii+i1+perm[jj+j1+perm[kk+k1]]], x1, y1, z1)
+       + simplexKernel(T(0.6)-x2*x2-y2*y2-z2*z2)*simplexGrad3(perm[ii+i2+perm[jj+j2+perm[kk+k2]]], x2, y2, z2)
+       + simplexKernel(T(0.6)-x3*x3-y3*y3-z3*z3)*simplexGrad3(perm[ii+1+perm[jj+1+perm[kk+1]]], x3, y3, z3);
+   return T(32.)*n;
+}
+
+template <typename T>
+T snoise4(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
+{
+   const T F4 = T(0.309016994374947424), G4 = T(0.138196601125010504);  // (sqrt(5)-1)/4, (5-sqrt(5))/20
+   const int *perm = noise.pp;
+
+   T s = (vec[0]+vec[1]+vec[2]+vec[3])*F4;
+   int i = simplexFloor(vec[0]+s);
+   int j = simplexFloor(vec[1]+s);
+   int k = simplexFloor(vec[2]+s);
+   int l = simplexFloor(vec[3]+s);
+   T t = T(i+j+k+l)*G4;
+   T x0 = vec[0]-(T(i)-t);
+   T y0 = vec[1]-(T(j)-t);
+   T z0 = vec[2]-(T(k)-t);
+   T w0 = vec[3]-(T(l)-t);
+
+   // rank the offsets: a coordinate steps at corner c when its rank is at least 4-c
+   int rx = (x0 > y0) + (x0 > z0) + (x0 > w0);
+   int ry = (x0 <= y0) + (y0 > z0) + (y0 > w0);
+   int rz = (x0 <= z0) + (y0 <= z0) + (z0 > w0);
+   int rw = (x0 <= w0) + (y0 <= w0) + (z0 <= w0);
+
+   int ii = i & BM, jj = j & BM, kk = k & BM, ll = l & BM;
+   T n = 0;
+   for (int c=0;c<5;c++)
+   {
+      int ic = (rx >= 4-c), jc = (ry >= 4-c), kc = (rz >= 4-c), lc = (rw >= 4-c);  // c=0 is the origin, c=4 is (1,1,1,1)
+      T x = x0-T(ic)+T(c)*G4, y = y0-T(jc)+T(c)*G4, z = z0-T(kc)+T(c)*G4, w = w0-T(lc)+T(c)*G4;
+      n += simplexKernel(T(0.6)-x*x-y*y-z*z-w*w)*simplexGrad4(perm[ii+ic+perm[jj+jc+perm[kk+kc+perm[ll+lc]]]], x, y, z, w);
+   }
+   return T(27.)*n;
+}
+
 // -1 to +1 noise
-double fBm2DNoise(double x,double y,double InversePersistence,double Lacunarity,int n_octaves,bool *NoiseResetFlag)
+template <typename T>
+T fBm2DNoise(T x,T y,T InversePersistence,T Lacunarity,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN)
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
@@ -752,27 +1510,27 @@ double fBm2DNoise(double x,double y,double InversePersistence,double Lacunarity,
    if (Lacunarity>4.0) Lacunarity=4.0;
 
    int i;
-   double val,sum = 0;
-   double p[2],scale = 1;
+   T val,sum = 0;
+   T p[2],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
-   static double   currentInversePersistence=0;
-   static double   currentLacunarity=0;
+   static T   normalscale=1.;   // used to renormalize added octaves
+   static T   currentInversePersistence=0;
+   static T   currentLacunarity=0;
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if ((InversePersistence!=currentInversePersistence)||(Lacunarity!=currentLacunarity)||(n_octaves!=currentnoctaves))
    {
-           double dfscale=1.;                  // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                  // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
               dfscale *= InversePersistence;
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentInversePersistence=InversePersistence;
            currentLacunarity=Lacunarity;
@@ -785,40 +1543,41 @@ double fBm2DNoise(double x,double y,double InversePersistence,double Lacunarity,
    p[1] = y;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise2(p);
+      val = (basis == NOISE_SIMPLEX) ? T(0.66)*snoise2(p, noise) : pnoise2(p, noise);  // simplex scaled to pnoise2's rms, so the fudge below holds
       sum += val / scale;
       scale *= InversePersistence;
       p[0] *= Lacunarity;
       p[1] *= Lacunarity;
    }
-   return(sum/(1.2*normalscale));  // the 1.2 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.2)*normalscale));  // the 1.2 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
-double FastfBm2DNoise(double x,double y,int n_octaves,bool *NoiseResetFlag) // fixed invpersistence=2. and lacunarity=2.
+template <typename T>
+T FastfBm2DNoise(T x,T y,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN) // fixed invpersistence=2. and lacunarity=2.
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
    
    int i;
-   double val,sum = 0;
-   double p[2],scale = 1;
+   T val,sum = 0;
+   T p[2],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
+   static T   normalscale=1.;   // used to renormalize added octaves
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if (n_octaves!=currentnoctaves)
    {
-           double dfscale=1.;                    // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                    // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
-              dfscale *= 2.;
+              dfscale *= T(2.);
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentnoctaves=n_octaves;
            *NoiseResetFlag=false;
@@ -829,64 +1588,67 @@ double FastfBm2DNoise(double x,double y,int n_octaves,bool *NoiseResetFlag) // f
    p[1] = y;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise2(p);
+      val = (basis == NOISE_SIMPLEX) ? T(0.66)*snoise2(p, noise) : pnoise2(p, noise);  // simplex scaled to pnoise2's rms, so the fudge below holds
       sum += val / scale;
-      scale *= 2.;
-      p[0] *= 2.05645;  // to avoid artifacts avoid lacunarity of 2.0
-      p[1] *= 2.05467;  // to avoid artifacts avoid lacunarity of 2.0
+      scale *= T(2.);
+      p[0] *= T(2.05645);  // to avoid artifacts avoid lacunarity of 2.0
+      p[1] *= T(2.05467);  // to avoid artifacts avoid lacunarity of 2.0
    }
-   return(sum/(1.2*normalscale));  // the 1.2 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.2)*normalscale));  // the 1.2 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
-double grad3(int hash, double x, double y, double z)
+template <typename T>
+T grad3(int hash, T x, T y, T z)
   {
     int     h = hash & 15;       // CONVERT LO 4 BITS OF HASH CODE
-    double  u = h < 8 ? x : y,   // INTO 12 GRADIENT DIRECTIONS.
+    T  u = h < 8 ? x : y,   // INTO 12 GRADIENT DIRECTIONS.
             v = h < 4 ? y : h==12||h==14 ? x : z;
     return ((h&1) == 0 ? u : -u) + ((h&2) == 0 ? v : -v);
   }
 
 
-double npnoise3(double vec[])      // new improved perlin noise3
+template <typename T>
+T npnoise3(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)      // new improved perlin noise3
   {
-    double x=vec[0];
-    double y=vec[1];
-    double z=vec[2];
+    T x=vec[0];
+    T y=vec[1];
+    T z=vec[2];
 
-    int   X = (int)floor(x) & 255,             // FIND UNIT CUBE THAT
-          Y = (int)floor(y) & 255,             // CONTAINS POINT.
-          Z = (int)floor(z) & 255;
+    int   X = (int)std::floor(x) & 255,             // FIND UNIT CUBE THAT
+          Y = (int)std::floor(y) & 255,             // CONTAINS POINT.
+          Z = (int)std::floor(z) & 255;
 
-    x -= floor(x);                             // FIND RELATIVE X,Y,Z
-    y -= floor(y);                             // OF POINT IN CUBE.
-    z -= floor(z);
+    x -= std::floor(x);                             // FIND RELATIVE X,Y,Z
+    y -= std::floor(y);                             // OF POINT IN CUBE.
+    z -= std::floor(z);
 
-    double  u = fade(x),                       // COMPUTE FADE CURVES
+    T  u = fade(x),                       // COMPUTE FADE CURVES
             v = fade(y),                       // FOR EACH OF X,Y,Z.
             w = fade(z);
 
-    int  A = p[X]+Y,
-         AA = p[A]+Z,
-         AB = p[A+1]+Z, // HASH COORDINATES OF
-         C = p[X+1]+Y,
-         BA = p[C]+Z,
-         BB = p[C+1]+Z; // THE 8 CUBE CORNERS,
-
-    return lerp(w,lerp(v,lerp(u, grad3(p[AA  ], x, y, z),   // AND ADD
-                         grad3(p[BA  ], x-1, y, z)),        // BLENDED
-                 lerp(u, grad3(p[AB  ], x, y-1, z),         // RESULTS
-                         grad3(p[BB  ], x-1, y-1, z))),     // FROM  8
-                 lerp(v, lerp(u, grad3(p[AA+1], x, y, z-1 ),// CORNERS
-                         grad3(p[BA+1], x-1, y, z-1)),      // OF CUBE
-                 lerp(u, grad3(p[AB+1], x, y-1, z-1),
-                         grad3(p[BB+1], x-1, y-1, z-1))));
+    int  A = noise.p[X]+Y,
+         AA = noise.p[A]+Z,
+         AB = noise.p[A+1]+Z, // HASH COORDINATES OF
+         C = noise.p[X+1]+Y,
+         BA = noise.p[C]+Z,
+         BB = noise.p[C+1]+Z; // THE 8 CUBE CORNERS,
+
+    return lerp(w,lerp(v,lerp(u, grad3(noise.p[AA  ], x, y, z),   // AND ADD
+                         grad3(noise.p[BA  ], x-1, y, z)),        // BLENDED
+                 lerp(u, grad3(noise.p[AB  ], x, y-1, z),         // RESULTS
+                         grad3(noise.p[BB  ], x-1, y-1, z))),     // FROM  8
+                 lerp(v, lerp(u, grad3(noise.p[AA+1], x, y, z-1 ),// CORNERS
+                         grad3(noise.p[BA+1], x-1, y, z-1)),      // OF CUBE
+                 lerp(u, grad3(noise.p[AB+1], x, y-1, z-1),
+                         grad3(noise.p[BB+1], x-1, y-1, z-1))));
   }
 
 
-static double grad4(int hash, double x, double y, double z, double w)
+template <typename T>
+static T grad4(int hash, T x, T y, T z, T w)
 {
    int h = hash & 31; // CONVERT LO 5 BITS OF HASH TO 32 GRAD DIRECTIONS.
-   double a=y,b=z,c=w;            // X,Y,Z
+   T a=y,b=z,c=w;            // X,Y,Z
    switch (h >> 3)
    {          // OR, DEPENDING ON HIGH ORDER 2 BITS:
    case 1: a=w;b=x;c=y;break;     // W,X,Y
@@ -896,68 +1658,70 @@ static double grad4(int hash, double x, double y, double z, double w)
    return ((h&4)==0 ? -a:a) + ((h&2)==0 ? -b:b) + ((h&1)==0 ? -c:c);
 }
 
-double npnoise4(double vec[])
+template <typename T>
+T npnoise4(const T vec[], const NoiseContext& noise=theDefaultNoiseContext)
 {
-      double x=vec[0];
-      double y=vec[1];
-      double z=vec[2];
-      double w=vec[3];
-
-      int X = (int)floor(x) & 255;                  // FIND UNIT HYPERCUBE
-      int Y = (int)floor(y) & 255;                  // THAT CONTAINS POINT.
-      int Z = (int)floor(z) & 255;
-      int W = (int)floor(w) & 255;
-
-      x -= floor(x);                                // FIND RELATIVE X,Y,Z,W
-      y -= floor(y);                                // OF POINT IN CUBE.
-      z -= floor(z);
-      w -= floor(w);
-
-      double a = fade(x);                                // COMPUTE FADE CURVES
-      double b = fade(y);                                // FOR EACH OF X,Y,Z,W.
-      double c = fade(z);
-      double d = fade(w);
-
-      int A   = pp[X]+Y;      // HASH COORDINATES OF
-      int AA  = pp[A]+Z;        // THE 16 CORNERS OF
-      int AB  = pp[A+1]+Z;      // THE HYPERCUBE.
-      int C   = pp[X+1]+Y;
-      int BA  = pp[C]+Z;
-      int BB  = pp[C+1]+Z;
-      int AAA = pp[AA]+W;
-      int AAB = pp[AA+1]+W;
-      int ABA = pp[AB]+W;
-      int ABB = pp[AB+1]+W;
-      int BAA = pp[BA]+W;
-      int BAB = pp[BA+1]+W;
-      int BBA = pp[BB]+W;
-      int BBB = pp[BB+1]+W;
+      T x=vec[0];
+      T y=vec[1];
+      T z=vec[2];
+      T w=vec[3];
+
+      int X = (int)std::floor(x) & 255;                  // FIND UNIT HYPERCUBE
+      int Y = (int)std::floor(y) & 255;                  // THAT CONTAINS POINT.
+      int Z = (int)std::floor(z) & 255;
+      int W = (int)std::floor(w) & 255;
+
+      x -= std::floor(x);                                // FIND RELATIVE X,Y,Z,W
+      y -= std::floor(y);                                // OF POINT IN CUBE.
+      z -= std::floor(z);
+      w -= std::floor(w);
+
+      T a = fade(x);                                // COMPUTE FADE CURVES
+      T b = fade(y);                                // FOR EACH OF X,Y,Z,W.
+      T c = fade(z);
+      T d = fade(w);
+
+      int A   = noise.pp[X]+Y;      // HASH COORDINATES OF
+      int AA  = noise.pp[A]+Z;        // THE 16 CORNERS OF
+      int AB  = noise.pp[A+1]+Z;      // THE HYPERCUBE.
+      int C   = noise.pp[X+1]+Y;
+      int BA  = noise.pp[C]+Z;
+      int BB  = noise.pp[C+1]+Z;
+      int AAA = noise.pp[AA]+W;
+      int AAB = noise.pp[AA+1]+W;
+      int ABA = noise.pp[AB]+W;
+      int ABB = noise.pp[AB+1]+W;
+      int BAA = noise.pp[BA]+W;
+      int BAB = noise.pp[BA+1]+W;
+      int BBA = noise.pp[BB]+W;
+      int BBB = noise.pp[BB+1]+W;
 
       return lerp(d,                                     // INTERPOLATE DOWN.
-          lerp(c,lerp(b,lerp(a,grad4(pp[AAA  ], x  , y  , z  , w),
-                               grad4(pp[BAA  ], x-1, y  , z  , w)),
-                        lerp(a,grad4(pp[ABA  ], x  , y-1, z  , w),
-                               grad4(pp[BBA  ], x-1, y-1, z  , w))),
-
-                 lerp(b,lerp(a,grad4(pp[AAB  ], x  , y  , z-1, w),
-                               grad4(pp[BAB  ], x-1, y  , z-1, w)),
-                        lerp(a,grad4(pp[ABB  ], x  , y-1, z-1, w),
-                               grad4(pp[BBB  ], x-1, y-1, z-1, w)))),
-
-          lerp(c,lerp(b,lerp(a,grad4(pp[AAA+1], x  , y  , z  , w-1),
-                               grad4(pp[BAA+1], x-1, y  , z  , w-1)),
-                        lerp(a,grad4(pp[ABA+1], x  , y-1, z  , w-1),
-                               grad4(pp[BBA+1], x-1, y-1, z  , w-1))),
-
-                 lerp(b,lerp(a,grad4(pp[AAB+1], x  , y  , z-1, w-1),
-                               grad4(pp[BAB+1], x-1, y  , z-1, w-1)),
-                        lerp(a,grad4(pp[ABB+1], x  , y-1, z-1, w-1),
-                               grad4(pp[BBB+1], x-1, y-1, z-1, w-1)))));
+          lerp(c,lerp(b,lerp(a,grad4(noise.pp[AAA  ], x  , y  , z  , w),
+                               grad4(noise.pp[BAA  ], x-1, y  , z  , w)),
+                        lerp(a,grad4(noise.pp[ABA  ], x  , y-1, z  , w),
+                               grad4(noise.pp[BBA  ], x-1, y-1, z  , w))),
+
+                 lerp(b,lerp(a,grad4(noise.pp[AAB  ], x  , y  , z-1, w),
+                               grad4(noise.pp[BAB  ], x-1, y  , z-1, w)),
+                        lerp(a,grad4(noise.pp[ABB  ], x  , y-1, z-1, w),
+                               grad4(noise.pp[BBB  ], x-1, y-1, z-1, w)))),
+
+          lerp(c,lerp(b,lerp(a,grad4(noise.pp[AAA+1], x  , y  , z  , w-1),
+                               grad4(noise.pp[BAA+1], x-1, y  , z  , w-1)),
+                        lerp(a,grad4(noise.pp[ABA+1], x  , y-1, z  , w-1),
+                               grad4(noise.pp[BBA+1], x-1, y-1, z  , w-1))),
+
+                 lerp(b,lerp(a,grad4(noise.pp[AAB+1], x  , y  , z-1, w-1),
+                               grad4(noise.pp[BAB+1], x-1, y  , z-1, w-1)),
+                        lerp(a,grad4(noise.pp[ABB+1], x  , y-1, z-1, w-1),
+                               grad4(noise.pp[BBB+1], x-1, y-1, z-1, w-1)))));
 }
 
 
 // -1 to +1 noise
-double fBm3DNoise(double x,double y,double z,double InversePersistence,double Lacunarity,int n_octaves, bool *NoiseResetFlag)
+template <typename T>
+T fBm3DNoise(T x,T y,T z,T InversePersistence,T Lacunarity,int n_octaves, bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN)
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
@@ -967,27 +1731,27 @@ double fBm3DNoise(double x,double y,double z,double InversePersistence,double La
    if (Lacunarity>4.0) Lacunarity=4.0;
 
    int i;
-   double val,sum = 0;
-   double p[3],scale = 1;
+   T val,sum = 0;
+   T p[3],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
-   static double   currentInversePersistence=0;
-   static double   currentLacunarity=0;
+   static T   normalscale=1.;   // used to renormalize added octaves
+   static T   currentInversePersistence=0;
+   static T   currentLacunarity=0;
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if ((InversePersistence!=currentInversePersistence)||(Lacunarity!=currentLacunarity)||(n_octaves!=currentnoctaves))
    {
-           double dfscale=1.;                  // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                  // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
               dfscale *= InversePersistence;
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentInversePersistence=InversePersistence;
            currentLacunarity=Lacunarity;
@@ -1001,41 +1765,42 @@ double fBm3DNoise(double x,double y,double z,double InversePersistence,double La
    val=0; sum=0;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise3(p);
+      val = (basis == NOISE_SIMPLEX) ? T(0.65)*snoise3(p, noise) : pnoise3(p, noise);  // simplex scaled to pnoise3's rms, so the fudge below holds
       sum += val / scale;
       scale *= InversePersistence;
       p[0] *= Lacunarity;
       p[1] *= Lacunarity;
       p[2] *= Lacunarity;
    }
-   return(sum/(1.1*normalscale));  // the 1.1 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.1)*normalscale));  // the 1.1 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
-double FastfBm3DNoise(double x,double y,double z,int n_octaves,bool *NoiseResetFlag) // fixed invpersistence=2. and lacunarity=2.
+template <typename T>
+T FastfBm3DNoise(T x,T y,T z,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN) // fixed invpersistence=2. and lacunarity=2.
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
    
    int i;
-   double val,sum = 0;
-   double p[3],scale = 1;
+   T val,sum = 0;
+   T p[3],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
+   static T   normalscale=1.;   // used to renormalize added octaves
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if (n_octaves!=currentnoctaves)
    {
-           double dfscale=1.;                    // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                    // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
-              dfscale *= 2.;
+              dfscale *= T(2.);
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentnoctaves=n_octaves;
            *NoiseResetFlag=false;
@@ -1047,18 +1812,19 @@ double FastfBm3DNoise(double x,double y,double z,int n_octaves,bool *NoiseResetF
    p[2] = z;
    for (i=0;i<n_octaves;i++)
    {
-      val = pnoise3(p);
+      val = (basis == NOISE_SIMPLEX) ? T(0.65)*snoise3(p, noise) : pnoise3(p, noise);  // simplex scaled to pnoise3's rms, so the fudge below holds
       sum += val / scale;
-      scale *= 2.;
-      p[0] *= 2.05656;  // to avoid artifacts avoid lacunarity of 2.0
-      p[1] *= 2.06756;  // to avoid artifacts avoid lacunarity of 2.0
-      p[2] *= 2.06345;  // to avoid artifacts avoid lacunarity of 2.0
+      scale *= T(2.);
+      p[0] *= T(2.05656);  // to avoid artifacts avoid lacunarity of 2.0
+      p[1] *= T(2.06756);  // to avoid artifacts avoid lacunarity of 2.0
+      p[2] *= T(2.06345);  // to avoid artifacts avoid lacunarity of 2.0
    }
-   return(sum/(1.1*normalscale));  // the 1.1 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.1)*normalscale));  // the 1.1 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
 // -1 to +1 noise
-double fBm4DNoise(double x,double y,double z,double w,double InversePersistence,double Lacunarity,int n_octaves, bool *NoiseResetFlag)
+template <typename T>
+T fBm4DNoise(T x,T y,T z,T w,T InversePersistence,T Lacunarity,int n_octaves, bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN)
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
@@ -1068,27 +1834,27 @@ double fBm4DNoise(double x,double y,double z,double w,double InversePersistence,
    if (Lacunarity>4.0) Lacunarity=4.0;
 
    int i;
-   double val,sum = 0;
-   double p[4],scale = 1;
+   T val,sum = 0;
+   T p[4],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
-   static double   currentInversePersistence=0;
-   static double   currentLacunarity=0;
+   static T   normalscale=1.;   // used to renormalize added octaves
+   static T   currentInversePersistence=0;
+   static T   currentLacunarity=0;
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if ((InversePersistence!=currentInversePersistence)||(Lacunarity!=currentLacunarity)||(n_octaves!=currentnoctaves))
    {
-           double dfscale=1.;                  // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                  // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
               dfscale *= InversePersistence;
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentInversePersistence=InversePersistence;
            currentLacunarity=Lacunarity;
@@ -1103,7 +1869,7 @@ double fBm4DNoise(double x,double y,double z,double w,double InversePersistence,
    p[3] = w;
    for (i=0;i<n_octaves;i++)
    {
-      val = npnoise4(p);
+      val = (basis == NOISE_SIMPLEX) ? snoise4(p, noise) : npnoise4(p, noise);  // already about npnoise4's rms
       sum += val / scale;
       scale *= InversePersistence;
       p[0] *= Lacunarity;
@@ -1111,34 +1877,35 @@ double fBm4DNoise(double x,double y,double z,double w,double InversePersistence,
       p[2] *= Lacunarity;
       p[3] *= Lacunarity;
    }
-   return(sum/(1.3*normalscale));  // the 1.3 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.3)*normalscale));  // the 1.3 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
-double FastfBm4DNoise(double x,double y,double z,double w,int n_octaves, bool *NoiseResetFlag)
+template <typename T>
+T FastfBm4DNoise(T x,T y,T z,T w,int n_octaves, bool *NoiseResetFlag, const NoiseContext& noise=theDefaultNoiseContext, NoiseBasis basis=NOISE_PERLIN)
 {
    if (n_octaves<1) n_octaves=1;
    if (n_octaves>6) n_octaves=6;
   
    int i;
-   double val,sum = 0;
-   double p[4],scale = 1;
+   T val,sum = 0;
+   T p[4],scale = 1;
 
-   static double   normalscale=1.;   // used to renormalize added octaves
+   static T   normalscale=1.;   // used to renormalize added octaves
    static int      currentnoctaves=0;
 
    if (*NoiseResetFlag)
    if (n_octaves!=currentnoctaves)
    {
-           double dfscale=1.;                    // based on sqrt of sum of squares of scales
-           double inversescale=1.;
+           T dfscale=1.;                    // based on sqrt of sum of squares of scales
+           T inversescale=1.;
            normalscale=0;
            for (i=0;i<n_octaves;i++)
            {
-              inversescale = 1./dfscale;
+              inversescale = T(1.)/dfscale;
               normalscale += inversescale*inversescale;
-              dfscale *= 2.;
+              dfscale *= T(2.);
            }
-           normalscale=sqrt(normalscale);
+           normalscale=std::sqrt(normalscale);
 
            currentnoctaves=n_octaves;
            *NoiseResetFlag=false;
@@ -1151,51 +1918,44 @@ double FastfBm4DNoise(double x,double y,double z,double w,int n_octaves, bool *N
    p[3] = w;
    for (i=0;i<n_octaves;i++)
    {
-      val = npnoise4(p);
+      val = (basis == NOISE_SIMPLEX) ? snoise4(p, noise) : npnoise4(p, noise);  // already about npnoise4's rms
       sum += val / scale;
-      scale *= 2.;
-      p[0] *= 2.05654;   // to avoid artifacts avoid lacunarity of 2.0
-      p[1] *= 2.02384;
-      p[2] *= 2.02378;
-      p[3] *= 2.04532;
+      scale *= T(2.);
+      p[0] *= T(2.05654);   // to avoid artifacts avoid lacunarity of 2.0
+      p[1] *= T(2.02384);
+      p[2] *= T(2.02378);
+      p[3] *= T(2.04532);
    }
-   return(sum/(1.3*normalscale));  // the 1.3 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
+   return(sum/(T(1.3)*normalscale));  // the 1.3 is fudge to make 8 octave sum correct, but introduces some error at low octave counts
 }
 
 
 
+// the float kernels, instantiated here so they are always compiled whether or not anything calls them yet
+template float pnoise1<float>(const float vec[], const NoiseContext& noise);
+template float pnoise2<float>(const float vec[], const NoiseContext& noise);
+template float pnoise3<float>(const float vec[], const NoiseContext& noise);
+template float npnoise3<float>(const float vec[], const NoiseContext& noise);
+template float npnoise4<float>(const float vec[], const NoiseContext& noise);
+template float snoise2<float>(const float vec[], const NoiseContext& noise);
+template float snoise3<float>(const float vec[], const NoiseContext& noise);
+template float snoise4<float>(const float vec[], const NoiseContext& noise);
+template float fBm1DNoise<float>(float x,float InversePersistence,float Lacunarity,int n_octaves, const NoiseContext& noise);
+template float FastfBm1DNoise<float>(float x,int n_octaves, const NoiseContext& noise);
+template float FastfBm1DHashNoise<float>(float x,int n_octaves, uint32_t seed);
+template void FastfBm1DHashNoiseBlock<float>(const float *x, int n_octaves, float *out, int count, uint32_t seed);
+template float fBm2DNoise<float>(float x,float y,float InversePersistence,float Lacunarity,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+template float FastfBm2DNoise<float>(float x,float y,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+template float fBm3DNoise<float>(float x,float y,float z,float InversePersistence,float Lacunarity,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+template float FastfBm3DNoise<float>(float x,float y,float z,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+template float fBm4DNoise<float>(float x,float y,float z,float w,float InversePersistence,float Lacunarity,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+template float FastfBm4DNoise<float>(float x,float y,float z,float w,int n_octaves,bool *NoiseResetFlag, const NoiseContext& noise, NoiseBasis basis);
+
+// the gradients are built on first use now and each NoiseContext has its own permutation, so this only makes sure
+// the gradients are there
 void initPerlin(void)
 {
-        int i, j;
-
-        for (i=0; i< 256; ++i)
-          pp[256+i]=pp[i]=permutation[i];
-
-        for (i = 0 ; i < B ; i++)
-        {
-            p[i] = pp[i];
-
-            g1[i] = g_precomputed[i][0];
-
-		    for (j = 0 ; j < 2 ; j++)
-                g2[i][j] = g_precomputed[i][j];
-		    normalize2(g2[i]);
-
-            for (j = 0 ; j < 3 ; j++)
-                            g3[i][j] = g_precomputed[i][j];
-                // normalize3(g3[i]);  // already normalized
-	    }
-
-        for (i = 0 ; i < B + 2 ; i++)
-        {
-            p[B + i] = p[i];
-            g1[B + i] = g1[i];
-            for (j = 0 ; j < 2 ; j++)
-                g2[B + i][j] = g2[i][j];
-            for (j = 0 ; j < 3 ; j++)
-                g3[B + i][j] = g3[i][j];
-	    }
-
+   initNoiseGradients();
 }
 
 
@@ -16,1141 +16,257 @@ You should have received a copy of the GNU General Public License along with thi
 #include <fstream> 
 #include <string>
 #include <mutex>
+#include <osdialog.h>
 
 #include "Meander.hpp"
 
-// the following is for performance profiling under Windows by the developer and should not be defined in the release distribution
-// #define _USE_WINDOWS_PERFTIME
 
-#if defined(_USE_WINDOWS_PERFTIME)
-#include <windows.h>
-#endif
-
-
-struct Meander : Module 
+struct Meander : Module, MeanderEngine
 {
-	bool instanceRunning = false;
-	
-	enum ParamIds 
-	{
-		BUTTON_RUN_PARAM,
-		BUTTON_RESET_PARAM,
-
-		CONTROL_TEMPOBPM_PARAM,
-		CONTROL_TIMESIGNATURETOP_PARAM,
-		CONTROL_TIMESIGNATUREBOTTOM_PARAM,
-
-		CONTROL_ROOT_KEY_PARAM,
-		CONTROL_SCALE_PARAM,
-
-		BUTTON_CIRCLESTEP_C_PARAM,
-		BUTTON_CIRCLESTEP_G_PARAM,
-		BUTTON_CIRCLESTEP_D_PARAM,
-		BUTTON_CIRCLESTEP_A_PARAM,
-		BUTTON_CIRCLESTEP_E_PARAM,
-		BUTTON_CIRCLESTEP_B_PARAM,
-		BUTTON_CIRCLESTEP_GBFS_PARAM,
-		BUTTON_CIRCLESTEP_DB_PARAM,
-		BUTTON_CIRCLESTEP_AB_PARAM,
-		BUTTON_CIRCLESTEP_EB_PARAM,
-		BUTTON_CIRCLESTEP_BB_PARAM,
-		BUTTON_CIRCLESTEP_F_PARAM,
-
-	
-		BUTTON_HARMONY_SETSTEP_1_PARAM,
-		BUTTON_HARMONY_SETSTEP_2_PARAM,
-		BUTTON_HARMONY_SETSTEP_3_PARAM,
-		BUTTON_HARMONY_SETSTEP_4_PARAM,
-		BUTTON_HARMONY_SETSTEP_5_PARAM,
-		BUTTON_HARMONY_SETSTEP_6_PARAM,
-		BUTTON_HARMONY_SETSTEP_7_PARAM,
-		BUTTON_HARMONY_SETSTEP_8_PARAM,
-		BUTTON_HARMONY_SETSTEP_9_PARAM,
-		BUTTON_HARMONY_SETSTEP_10_PARAM,
-		BUTTON_HARMONY_SETSTEP_11_PARAM,
-		BUTTON_HARMONY_SETSTEP_12_PARAM,
-		BUTTON_HARMONY_SETSTEP_13_PARAM,
-		BUTTON_HARMONY_SETSTEP_14_PARAM,
-		BUTTON_HARMONY_SETSTEP_15_PARAM,
-		BUTTON_HARMONY_SETSTEP_16_PARAM,
-
-		BUTTON_ENABLE_MELODY_PARAM,
-		CONTROL_MELODY_VOLUME_PARAM,
-		BUTTON_MELODY_DESTUTTER_PARAM,
-		CONTROL_MELODY_NOTE_LENGTH_DIVISOR_PARAM,
-		CONTROL_MELODY_TARGETOCTAVE_PARAM,
-		CONTROL_MELODY_ALPHA_PARAM,
-		CONTROL_MELODY_RANGE_PARAM,
-
-
-		BUTTON_ENABLE_ARP_PARAM,
-		CONTROL_ARP_COUNT_PARAM,
-		CONTROL_ARP_INCREMENT_PARAM,
-		CONTROL_ARP_DECAY_PARAM,
-		CONTROL_ARP_PATTERN_PARAM,
-		BUTTON_ENABLE_ARP_CHORDAL_PARAM,
-		BUTTON_ENABLE_ARP_SCALER_PARAM,
-
-
-		BUTTON_ENABLE_HARMONY_PARAM,
-		BUTTON_HARMONY_DESTUTTER_PARAM,
-		CONTROL_HARMONY_VOLUME_PARAM,
-		CONTROL_HARMONY_STEPS_PARAM,
-		CONTROL_HARMONY_TARGETOCTAVE_PARAM,
-		CONTROL_HARMONY_ALPHA_PARAM,
-		CONTROL_HARMONY_RANGE_PARAM,
-		CONTROL_HARMONY_DIVISOR_PARAM,
-		CONTROL_HARMONYPRESETS_PARAM,
-
-		BUTTON_ENABLE_BASS_PARAM,
-		CONTROL_BASS_VOLUME_PARAM,
-		CONTROL_BASS_TARGETOCTAVE_PARAM,
-		BUTTON_BASS_ACCENT_PARAM,
-		BUTTON_BASS_SYNCOPATE_PARAM,
-		BUTTON_BASS_SHUFFLE_PARAM,
-		CONTROL_BASS_DIVISOR_PARAM,
-
-				
-		CONTROL_HARMONY_FBM_OCTAVES_PARAM,
-		CONTROL_MELODY_FBM_OCTAVES_PARAM,
-		CONTROL_ARP_FBM_OCTAVES_PARAM,
-
-		CONTROL_HARMONY_FBM_PERIOD_PARAM,
-		CONTROL_MELODY_FBM_PERIOD_PARAM,
-		CONTROL_ARP_FBM_PERIOD_PARAM,
-
-		BUTTON_ENABLE_MELODY_CHORDAL_PARAM,
-		BUTTON_ENABLE_MELODY_SCALER_PARAM,
-
-		BUTTON_ENABLE_HARMONY_ALL7THS_PARAM,
-		BUTTON_ENABLE_HARMONY_V7THS_PARAM,
-
-		BUTTON_ENABLE_HARMONY_STACCATO_PARAM,
-		BUTTON_ENABLE_MELODY_STACCATO_PARAM,
-		BUTTON_ENABLE_BASS_STACCATO_PARAM,
+	// MeanderEngine output hooks.  While the generators are running ahead (generatingAhead) the calls are queued for
+	// the tick they belong to, otherwise, as for live circle and step input, they take effect immediately.
 
-		BUTTON_BASS_OCTAVES_PARAM,
+	ScheduledEventQueue scheduledEvents;
+	bool generatingAhead=false;
+	long long generated_tick=0;  // next 32nd note tick the engine will generate
+	long long played_tick=0;     // next 32nd note tick playback will reach
+	int lookahead_ticks=2;       // how far generation runs ahead of playback
 
-		BUTTON_PROG_STEP_PARAM,
-				
-		
-		NUM_PARAMS
-	};
-
-	enum InputIds 
+	void scheduleOrApply(int type, int id, int channel, float value)
 	{
-		IN_RUN_EXT_CV,
-		IN_RESET_EXT_CV,
-		IN_TEMPO_EXT_CV,
-		IN_TIMESIGNATURETOP_EXT_CV,
-		IN_TIMESIGNATUREBOTTOM_EXT_CV,
-		IN_ROOT_KEY_EXT_CV,
-		IN_SCALE_EXT_CV,
-		IN_CLOCK_EXT_CV,
-		IN_HARMONY_CIRCLE_DEGREE_EXT_CV,
-		IN_HARMONY_CIRCLE_DEGREE_GATE_EXT_CV,
-
-		
-		IN_MELODY_ENABLE_EXT_CV,			
-		IN_MELODY_VOLUME_EXT_CV,
-		IN_MELODY_DESTUTTER_EXT_CV,
-		IN_MELODY_NOTE_LENGTH_DIVISOR_EXT_CV,
-		IN_MELODY_TARGETOCTAVE_EXT_CV,
-		IN_MELODY_ALPHA_EXT_CV,
-		IN_MELODY_RANGE_EXT_CV,
-
-		IN_ARP_ENABLE_EXT_CV,
-		IN_ARP_COUNT_EXT_CV,
-		IN_ARP_INCREMENT_EXT_CV,
-		IN_ARP_DECAY_EXT_CV,
-		IN_ARP_PATTERN_EXT_CV,
-		IN_ENABLE_ARP_CHORDAL_EXT_CV,
-		IN_ENABLE_ARP_SCALER_EXT_CV,
-
-
-		IN_HARMONY_ENABLE_EXT_CV,
-		IN_HARMONY_DESTUTTER_EXT_CV,
-		IN_HARMONY_VOLUME_EXT_CV,
-		IN_HARMONY_STEPS_EXT_CV,
-		IN_HARMONY_TARGETOCTAVE_EXT_CV,
-		IN_HARMONY_ALPHA_EXT_CV,
-		IN_HARMONY_RANGE_EXT_CV,
-		IN_HARMONY_DIVISOR_EXT_CV,
-		IN_HARMONYPRESETS_EXT_CV,
-
-		IN_BASS_ENABLE_EXT_CV,
-		IN_BASS_VOLUME_EXT_CV,
-		IN_BASS_TARGETOCTAVE_EXT_CV,
-		IN_BASS_ACCENT_EXT_CV,
-		IN_BASS_SYNCOPATE_EXT_CV,
-		IN_BASS_SHUFFLE_EXT_CV,
-		IN_BASS_DIVISOR_EXT_CV,
-
-				
-		IN_HARMONY_FBM_OCTAVES_EXT_CV,
-		IN_MELODY_FBM_OCTAVES_EXT_CV,
-		IN_ARP_FBM_OCTAVES_EXT_CV,
-
-		IN_HARMONY_FBM_PERIOD_EXT_CV,
-		IN_MELODY_FBM_PERIOD_EXT_CV,
-		IN_ARP_FBM_PERIOD_EXT_CV,
-
-		IN_ENABLE_MELODY_CHORDAL_EXT_CV,
-		IN_MELODY_SCALER_EXT_CV,
-
-		IN_ENABLE_HARMONY_ALL7THS_EXT_CV,
-		IN_ENABLE_HARMONY_V7THS_EXT_CV,
-
-		IN_ENABLE_HARMONY_STACCATO_EXT_CV,
-		IN_ENABLE_MELODY_STACCATO_EXT_CV,
-		IN_ENABLE_BASS_STACCATO_EXT_CV,
-
-		IN_BASS_OCTAVES_EXT_CV,
-
-		IN_PROG_STEP_EXT_CV,
-
-		IN_MELODY_SCALE_DEGREE_EXT_CV,
-		IN_MELODY_SCALE_GATE_EXT_CV,
-				
-
-		NUM_INPUTS
-		
-	};
-	
-	
+		ScheduledEvent event;
+		event.tick=generated_tick;
+		event.type=type;
+		event.id=id;
+		event.channel=channel;
+		event.value=value;
+		if (generatingAhead && scheduledEvents.push(event))
+			return;
+		applyEvent(event);  // immediate, or the queue is full
+	}
 
-	enum OutputIds 
+	void setOutputChannels(int outputId, int channels) override
 	{
-		OUT_RUN_OUT,
-		OUT_RESET_OUT,
-		OUT_TEMPO_OUT,
-		OUT_CLOCK_OUT, 
-		OUT_MELODY_GATE_OUTPUT,
-		OUT_HARMONY_GATE_OUTPUT,
-		OUT_BASS_GATE_OUTPUT,
-		OUT_FBM_HARMONY_OUTPUT,
-		OUT_MELODY_CV_OUTPUT,
-		OUT_FBM_MELODY_OUTPUT,
-		OUT_BASS_CV_OUTPUT,
-		OUT_HARMONY_CV_OUTPUT,
-		OUT_CLOCK_BEATX2_OUTPUT,
-		OUT_CLOCK_BAR_OUTPUT,
-		OUT_CLOCK_BEATX4_OUTPUT,
-		OUT_CLOCK_BEATX8_OUTPUT,
-		OUT_CLOCK_BEAT_OUTPUT,
-		OUT_BASS_TRIGGER_OUTPUT,
-		OUT_HARMONY_TRIGGER_OUTPUT,
-		OUT_MELODY_TRIGGER_OUTPUT,
-		OUT_FBM_ARP_OUTPUT,
-		OUT_MELODY_VOLUME_OUTPUT,
-		OUT_HARMONY_VOLUME_OUTPUT,
-		OUT_BASS_VOLUME_OUTPUT,
-		OUT_EXT_POLY_SCALE_OUTPUT,
-	
-		NUM_OUTPUTS
-	};
+		scheduleOrApply(EVENT_OUTPUT_CHANNELS, outputId, channels, 0.f);
+	}
 
-	enum LightIds 
+	void setOutputVoltage(int outputId, float voltage, int channel=0) override
 	{
-		LIGHT_LEDBUTTON_HARMONY_ENABLE,
-		LIGHT_LEDBUTTON_MELODY_ENABLE,
-		LIGHT_LEDBUTTON_ARP_ENABLE,
-		LIGHT_LEDBUTTON_ARP_ENABLE_CHORDAL,
-		LIGHT_LEDBUTTON_ARP_ENABLE_SCALER,
-		LIGHT_LEDBUTTON_BASS_ENABLE,
-		LIGHT_LEDBUTTON_RUN,
-		LIGHT_LEDBUTTON_RESET,
-		LIGHT_LEDBUTTON_MELODY_DESTUTTER,
-		LIGHT_LEDBUTTON_CIRCLESTEP_1,
-		LIGHT_LEDBUTTON_CIRCLESTEP_2,
-		LIGHT_LEDBUTTON_CIRCLESTEP_3,
-		LIGHT_LEDBUTTON_CIRCLESTEP_4,
-		LIGHT_LEDBUTTON_CIRCLESTEP_5,
-		LIGHT_LEDBUTTON_CIRCLESTEP_6,
-		LIGHT_LEDBUTTON_CIRCLESTEP_7,
-		LIGHT_LEDBUTTON_CIRCLESTEP_8,
-		LIGHT_LEDBUTTON_CIRCLESTEP_9,
-		LIGHT_LEDBUTTON_CIRCLESTEP_10,
-		LIGHT_LEDBUTTON_CIRCLESTEP_11,
-		LIGHT_LEDBUTTON_CIRCLESTEP_12,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_1_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_2_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_3_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_4_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_5_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_6_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_7_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_8_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_9_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_10_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_11_LIGHT,
-		LIGHT_CIRCLE_ROOT_KEY_POSITION_12_LIGHT,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_1,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_2,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_3,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_4,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_5,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_6,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_7,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_8,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_9,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_10,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_11,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_12,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_13,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_14,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_15,
-		LIGHT_LEDBUTTON_CIRCLESETSTEP_16,
-		LIGHT_CLOCK_IN_LIGHT,
-		LIGHT_LEDBUTTON_MELODY_ENABLE_CHORDAL,
-		LIGHT_LEDBUTTON_MELODY_ENABLE_SCALER,
-
-		LIGHT_LEDBUTTON_ENABLE_HARMONY_ALL7THS_PARAM,
-		LIGHT_LEDBUTTON_ENABLE_HARMONY_V7THS_PARAM,
-		LIGHT_LEDBUTTON_BASS_SYNCOPATE_PARAM,
-		LIGHT_LEDBUTTON_BASS_ACCENT_PARAM,
-		LIGHT_LEDBUTTON_BASS_SHUFFLE_PARAM,
-
-		LIGHT_LEDBUTTON_ENABLE_HARMONY_STACCATO_PARAM,
-		LIGHT_LEDBUTTON_ENABLE_MELODY_STACCATO_PARAM,
-		LIGHT_LEDBUTTON_ENABLE_BASS_STACCATO_PARAM,
-
-		LIGHT_LEDBUTTON_BASS_OCTAVES_PARAM,
-
-		LIGHT_LEDBUTTON_PROG_STEP_PARAM,
-		
-		NUM_LIGHTS
-	};
-
-
-	// Clock code adapted from Strum and AS
+		scheduleOrApply(EVENT_OUTPUT_VOLTAGE, outputId, channel, voltage);
+	}
 
-	struct LFOGenerator 
+	void setLightBrightness(int lightId, float brightness) override
 	{
-		float phase = 0.0f;
-		float pw = 0.5f;
-		float freq = 1.0f;
-		dsp::SchmittTrigger resetTrigger;
-		void setFreq(float freq_to_set)
-		{
-			freq = freq_to_set;
-		}		
-		void step(float dt) 
-		{
-			float deltaPhase = fminf(freq * dt, 0.5f);
-			phase += deltaPhase;
-			if (phase >= 1.0f)
-				phase -= 1.0f;
-		}
-		void setReset(float reset) 
-		{
-			if (resetTrigger.process(reset)) 
-			{
-				phase = 0.0f;
-			}
-		}
-		float sqr() 
-		{
-			float sqr = (phase < pw) ? 1.0f : -1.0f;
-			return sqr;
-		}
-	};  // struct LFOGenerator 
+		scheduleOrApply(EVENT_LIGHT_BRIGHTNESS, lightId, 0, brightness);
+	}
 
-	void userPlaysCirclePositionHarmony(int circle_position, float octaveOffset)  // C=0   play immediate
+	void triggerGate(int outputId, float duration) override
 	{
-		if (doDebug) DEBUG("userPlaysCirclePositionHarmony(%d)", circle_position); 
-		if (doDebug) DEBUG("circle_position=%d", circle_position);
-	
-		theMeanderState.last_harmony_chord_root_note=circle_of_fifths[circle_position];
-
-		if (octaveOffset>9)
-			octaveOffset=9;
-
-		for (int i=0; i<7; ++i) // melody and bass will use this to accompany 
-		{
-			if  (theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].CircleIndex==circle_position)
-			{
-				int theDegree=theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].Degree;
-				for (int j=0;j<MAX_STEPS;++j)
-				{
-					if (theHarmonyTypes[harmony_type].harmony_steps[j]==theDegree)
-					{
-						theMeanderState.last_harmony_step=j;
-						break;
-					}
-				}
-				break;
-			}
-		} 
-
-		theMeanderState.theMelodyParms.last_step=theMeanderState.last_harmony_step;
-		int note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[theMeanderState.last_harmony_step]);		// not sure this is necessary
-		theMeanderState.theMelodyParms.last_chord_note_index= note_index;
-		 
-		int current_chord_note=0;
-		int root_key_note=circle_of_fifths[circle_position]; 
-		if (doDebug) DEBUG("root_key_note=%d %s", root_key_note, note_desig[root_key_note%12]); 
-		int circle_chord_type= theCircleOf5ths.Circle5ths[circle_position].chordType;
-		theMeanderState.theHarmonyParms.last_chord_type=circle_chord_type;
-		if (doDebug) DEBUG("circle_chord_type=%d", circle_chord_type);
-		int num_chord_members=chord_type_num_notes[circle_chord_type];
-		if (doDebug) DEBUG("num_chord_members=%d", num_chord_members);
-
-		if (((theMeanderState.theHarmonyParms.enable_all_7ths)||(theMeanderState.theHarmonyParms.enable_V_7ths))			
-			&& ((circle_chord_type==2)
-			||  (circle_chord_type==3)
-			||  (circle_chord_type==4)
-			||  (circle_chord_type==5)))
-				outputs[OUT_HARMONY_CV_OUTPUT].setChannels(4);  // set polyphony
-			else
-				outputs[OUT_HARMONY_CV_OUTPUT].setChannels(3);  // set polyphony
-
-		for (int j=0;j<num_chord_members;++j) 
-		{
-			current_chord_note=(int)((int)root_key_note+(int)chord_type_intervals[circle_chord_type][j]);
-			if (doDebug) DEBUG("  current_chord_note=%d %s", current_chord_note, note_desig[current_chord_note%12]);
-			int note_to_play=current_chord_note+(octaveOffset*12);
-			outputs[OUT_HARMONY_CV_OUTPUT].setVoltage((note_to_play/12.0)-4.0,j);  // (note, channel) 
-					
-			if (j<4)
-			{
-				theMeanderState.theHarmonyParms.last[j].note=note_to_play;
-				theMeanderState.theHarmonyParms.last[j].noteType=NOTE_TYPE_CHORD;
-				theMeanderState.theHarmonyParms.last[j].length=1;  // whole  note for now
-				theMeanderState.theHarmonyParms.last[j].time32s=barts_count;
-				theMeanderState.theHarmonyParms.last[j].countInBar=bar_note_count;
-				if (bar_note_count<256)
-				played_notes_circular_buffer[bar_note_count++]=theMeanderState.theHarmonyParms.last[j];
-				
-			}
-            
-		}
-		float durationFactor=1.0;
-		if (theMeanderState.theHarmonyParms.enable_staccato)
-			durationFactor=0.5;
-		else
-			durationFactor=1.0;
-		
-		float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theHarmonyParms.note_length_divisor);
-		harmonyGatePulse.reset();  // kill the pulse in case it is active
-		harmonyGatePulse.trigger(note_duration);  
+		scheduleOrApply(EVENT_GATE_TRIGGER, outputId, 0, duration);
 	}
 
-	void doHarmony(int barChordNumber=1, bool playFlag=false)
+	void resetGate(int outputId) override
 	{
-		if (doDebug) DEBUG("doHarmony");
-		if (doDebug) DEBUG("doHarmony() theActiveHarmonyType.min_steps=%d, theActiveHarmonyType.max_steps=%d", theActiveHarmonyType.min_steps, theActiveHarmonyType.max_steps );
-
-		outputs[OUT_HARMONY_VOLUME_OUTPUT].setVoltage(theMeanderState.theHarmonyParms.volume);
-		
-		clock_t current_cpu_t= clock();  // cpu clock ticks since program began
-		double current_cpu_time_double= (double)(current_cpu_t) / (double)CLOCKS_PER_SEC;
-		
-		if (doDebug) DEBUG("\nHarmony: barCount=%d Time=%.3lf", bar_count, (double)current_cpu_time_double);
-													
-		current_melody_note += 1.0/12.0;
-		current_melody_note=fmod(current_melody_note, 1.0f);	
+		scheduleOrApply(EVENT_GATE_RESET, outputId, 0, 0.f);
+	}
 
-		
-	
-		for (int i=0; i<MAX_CIRCLE_STATIONS; ++i) {
-			CircleStepStates[i] = false;
-			lights[LIGHT_LEDBUTTON_CIRCLESTEP_1+i].setBrightness(0.0f);
-		}
+	void triggerClockPulse(int division) override
+	{
+		scheduleOrApply(EVENT_CLOCK_PULSE, division, 0, 0.f);
+	}
 
-		for (int i=0; i<16; ++i) {
-			if (i<theActiveHarmonyType.num_harmony_steps)
-				lights[LIGHT_LEDBUTTON_CIRCLESETSTEP_1+i].setBrightness(0.25f);
-			else
-				lights[LIGHT_LEDBUTTON_CIRCLESETSTEP_1+i].setBrightness(0.0f);
-				
-		}
-	
-	
-     	if (doDebug) DEBUG("theHarmonyTypes[%d].num_harmony_steps=%d", harmony_type, theActiveHarmonyType.num_harmony_steps);
-		int step=(bar_count%theActiveHarmonyType.num_harmony_steps);  // 0-(n-1)
- 
- 		if ((harmony_type==22)&&(step==0)&&(barChordNumber==0))  // random coming home
+	int gateFor(int outputId)
+	{
+		switch (outputId)
 		{
-			float rnd = rack::random::uniform();
-			int temp_num_harmony_steps=1 + (int)((rnd*(theHarmonyTypes[22].num_harmony_steps-1)));
-			bar_count += (theHarmonyTypes[22].num_harmony_steps-temp_num_harmony_steps);
+			case OUT_HARMONY_GATE_OUTPUT: return GATE_HARMONY;
+			case OUT_MELODY_GATE_OUTPUT:  return GATE_MELODY;
+			case OUT_BASS_GATE_OUTPUT:    return GATE_BASS;
 		}
+		return -1;
+	}
 
-		if (randomize_harmony) // this could be used to randomize any progression
-		{
-			if (barChordNumber==0)
-			{
-				float rnd = rack::random::uniform();
-				step = (int)((rnd*theActiveHarmonyType.num_harmony_steps));
-				step=step%theActiveHarmonyType.num_harmony_steps;
-			}
-			else
-			{
-				step=theMeanderState.theHarmonyParms.last_circle_step;
-			}
-		}
-		else
-		if (harmony_type==22) // random coming home
-		{
-			if (barChordNumber!=0)
-			{
-				step=theMeanderState.theHarmonyParms.last_circle_step;
-			}
-		}
-		else
-		if (harmony_type==23) // random order
+	void applyEvent(const ScheduledEvent& event)
+	{
+		if (fBm_cv_smooth && isfBmOutput(event.id) && ((event.type==EVENT_OUTPUT_CHANNELS)||(event.type==EVENT_OUTPUT_VOLTAGE)))
+			return;  // processfBmCV() owns these outputs
+		switch (event.type)
 		{
-			if (barChordNumber==0)
-			{
-				float rnd = rack::random::uniform();
-				step = (int)((rnd*theActiveHarmonyType.num_harmony_steps));
-				step=step%theActiveHarmonyType.num_harmony_steps;
-			}
-			else
-			{
-				step=theMeanderState.theHarmonyParms.last_circle_step;
-			}
-		}
-		else
-		if ((harmony_type==31)||(harmony_type==42)||(harmony_type==43)||(harmony_type==44)||(harmony_type==45)||(harmony_type==46)||(harmony_type==47)||(harmony_type==48))  // Markov chains
-		{   
-			if (barChordNumber==0)
-			{
-				float rnd = rack::random::uniform();
-				if (doDebug) DEBUG("rnd=%.2f",rnd);
-			
-
-				if (theMeanderState.theHarmonyParms.last_circle_step==-1)
+			case EVENT_OUTPUT_CHANNELS:
+				outputs[event.id].setChannels(event.channel);
+				break;
+			case EVENT_OUTPUT_VOLTAGE:
+				outputs[event.id].setVoltage(event.value, event.channel);
+				break;
+			case EVENT_LIGHT_BRIGHTNESS:
+				lights[event.id].setBrightness(event.value);
+				break;
+			case EVENT_GATE_TRIGGER:
+				if (gateFor(event.id)>=0)
+					gates.trigger(gateFor(event.id), event.value);
+				break;
+			case EVENT_GATE_RESET:
+				if (gateFor(event.id)>=0)
+					gates.reset(gateFor(event.id));
+				break;
+			case EVENT_CLOCK_PULSE:
+				switch (event.id)
 				{
-					step=0;
+					case 1:  gates.trigger(GATE_CLOCK_BAR, trigger_length);    break;
+					case 4:  gates.trigger(GATE_CLOCK_BEAT, trigger_length);   break;
+					case 8:  gates.trigger(GATE_CLOCK_BEATX2, trigger_length); break;
+					case 16: gates.trigger(GATE_CLOCK_BEATX4, trigger_length); break;
+					case 32: gates.trigger(GATE_CLOCK_BEATX8, trigger_length); break;
 				}
-				else
-				{
-					float probabilityTargetBottom[8]={0};  // skip first array index since this is 1 based
-					float probabilityTargetTop[8]={0};     // skip first array index since this is 1 based
-					float bottom=0;
-					step=1;
-					for (int i=1; i<8; ++i)  // skip first array index since this is 1 based
-					{
-						probabilityTargetBottom[i]=bottom;
-						if (harmony_type==31)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixBach1[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==42)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixBach2[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==43)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixMozart1[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==44)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixMozart2[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==45)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixPalestrina1[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==46)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixBeethoven1[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==47)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrixTraditional1[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-						else
-						if (harmony_type==48)
-							probabilityTargetTop[i]=bottom+MarkovProgressionTransitionMatrix_I_IV_V[theMeanderState.theHarmonyParms.last_circle_step+1][i];
-											
-						
-						bottom=probabilityTargetTop[i];
-					}
-					if (doDebug) DEBUG("Markov Probabilities:");
-					for (int i=1; i<8; ++i)  // skip first array index since this is 1 based
-					{
-						if (harmony_type==31)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixBach1[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==42)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixBach2[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==43)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixMozart1[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==44)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixMozart2[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==45)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixPalestrina1[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==46)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixBeethoven1[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==47)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrixTraditional1[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}
-						else
-						if (harmony_type==48)
-						{
-							if (doDebug) DEBUG("i=%d: p=%.2f b=%.2f t=%.2f", i, MarkovProgressionTransitionMatrix_I_IV_V[theMeanderState.theHarmonyParms.last_circle_step+1][i], probabilityTargetBottom[i], probabilityTargetTop[i]);
-						}					
-
-						if ((rnd>probabilityTargetBottom[i])&&(rnd<= probabilityTargetTop[i]))
-						{
-							step=i-1;
-							if (doDebug) DEBUG("step=%d", step);
-						}
-					}
-				
-				}
-			}
-			else
-			{
-				step=theMeanderState.theHarmonyParms.last_circle_step;
-			}
-			
-		}
-		
-    	
-
-		if (doDebug) DEBUG("step=%d", step);
-
-		int degreeStep=(theActiveHarmonyType.harmony_steps[step])%8;  
-		if (doDebug) DEBUG("degreeStep=%d", degreeStep);
-	
-		theMeanderState.theHarmonyParms.last_circle_step=step;  // used for Markov chain
-
-		//find this in semicircle
-		for (int i=0; i<7; ++i)
-		{
-			if  (theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].Degree==degreeStep)
-			{
-				current_circle_position = theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].CircleIndex; 
 				break;
-			}
-			if (i==7)
-			{
-	    	   if (doDebug) DEBUG("  warning circleposition could not be found 2");
-			}
 		}
-				
-		lights[LIGHT_LEDBUTTON_CIRCLESETSTEP_1+step].setBrightness(1.0f);
-		lights[LIGHT_LEDBUTTON_CIRCLESTEP_1+ (current_circle_position)%12].setBrightness(1.0f);
-		
-		if (doDebug) DEBUG("current_circle_position=%d root=%d %s", current_circle_position, circle_of_fifths[current_circle_position], note_desig[circle_of_fifths[current_circle_position]]);		
-		if (doDebug) DEBUG("theCircleOf5ths.Circle5ths[current_circle_position].chordType=%d", theCircleOf5ths.Circle5ths[current_circle_position].chordType);
-		
-		
-		double period=1.0/theMeanderState.theHarmonyParms.period; // 1/seconds
-		double fBmarg=theMeanderState.theHarmonyParms.seed + (double)(period*current_cpu_time_double); 
-	    double fBmrand=(FastfBm1DNoise(fBmarg,theMeanderState.theHarmonyParms.noctaves) +1.)/2; 
-			
-		theMeanderState.theHarmonyParms.note_avg = 
-			(1.0-theMeanderState.theHarmonyParms.alpha)*theMeanderState.theHarmonyParms.note_avg + 
-			theMeanderState.theHarmonyParms.alpha*(theMeanderState.theHarmonyParms.range_bottom + (fBmrand*theMeanderState.theHarmonyParms.r1));
-					
-		if (theMeanderState.theHarmonyParms.note_avg>theMeanderState.theHarmonyParms.range_top)
-		theMeanderState.theHarmonyParms.note_avg=theMeanderState.theHarmonyParms.range_top;
-		if (theMeanderState.theHarmonyParms.note_avg<theMeanderState.theHarmonyParms.range_bottom)
-		theMeanderState.theHarmonyParms.note_avg=theMeanderState.theHarmonyParms.range_bottom;
-					
-		int step_chord_type= theCircleOf5ths.Circle5ths[current_circle_position].chordType;
-		
-		if (((theMeanderState.theHarmonyParms.enable_all_7ths)||(theMeanderState.theHarmonyParms.enable_V_7ths))			
-		&& ((theCircleOf5ths.Circle5ths[current_circle_position].chordType==2)
-		||  (theCircleOf5ths.Circle5ths[current_circle_position].chordType==3)
-		||  (theCircleOf5ths.Circle5ths[current_circle_position].chordType==4)
-		||  (theCircleOf5ths.Circle5ths[current_circle_position].chordType==5)))
-			outputs[OUT_HARMONY_CV_OUTPUT].setChannels(4);  // set polyphony
-		else
-			outputs[OUT_HARMONY_CV_OUTPUT].setChannels(3);  // set polyphony
-		
-		if (doDebug) DEBUG("step_chord_type=%d", step_chord_type);
-		int num_chord_members=chord_type_num_notes[step_chord_type]; 
-		if (doDebug) DEBUG("num_chord_members=%d", num_chord_members);
-		
-	
-		theMeanderState.theHarmonyParms.last_chord_type=step_chord_type;
-		theMeanderState.last_harmony_chord_root_note=circle_of_fifths[current_circle_position];
-		theMeanderState.last_harmony_step=step;
-	
+	}
 
-		if (doDebug) DEBUG("theMeanderState.last_harmony_chord_root_note=%d %s", theMeanderState.last_harmony_chord_root_note, note_desig[theMeanderState.last_harmony_chord_root_note%MAX_NOTES]);
+	// One slice of the next tick's generation, on a sample with no tick: the clock counters and the first generator
+	// call on the first slice, then one generator call per slice, then the end of the tick.  So a bar line, where
+	// harmony, bass, melody and arp can all be due, costs at most one generator per sample rather than all of them.
+	bool generatingTick=false;  // beginClockTick() has run for generated_tick, endClockTick() has not
 
-		if (doDebug) DEBUG("1st 3 step_chord_notes=%d %s, %d %s, %d %s", step_chord_notes[step][0], note_desig[step_chord_notes[step][0]%MAX_NOTES], step_chord_notes[step][1], note_desig[step_chord_notes[step][1]%MAX_NOTES], step_chord_notes[step][2], note_desig[step_chord_notes[step][2]%MAX_NOTES]);
-			
-		bool tonicFound=false;
-		for (int j=0;j<num_chord_members;++j) 
+	void generateStep()
+	{
+		generatingAhead=true;
+		if (!generatingTick)
 		{
-				if (doDebug) DEBUG("num_step_chord_notes[%d]=%d", step, num_step_chord_notes[step]);
-				current_chord_notes[j]= step_chord_notes[step][(int)(theMeanderState.theHarmonyParms.note_avg*num_step_chord_notes[step])+j]; // may create inversion
-				if (doDebug) DEBUG("current_chord_notes[%d]=%d %s", j, current_chord_notes[j], note_desig[current_chord_notes[j]%MAX_NOTES]);
-						
-				int note_to_play=current_chord_notes[j]-12;  // drop it an octave to get target octave right
-				if (doDebug) DEBUG("    h_note_to_play=%d %s", note_to_play, note_desig[note_to_play%MAX_NOTES]);
-							
-				if (playFlag)  
-				{
-					if (j<4)
-					{
-						theMeanderState.theHarmonyParms.last[j].note=note_to_play;
-						theMeanderState.theHarmonyParms.last[j].noteType=NOTE_TYPE_CHORD;
-						theMeanderState.theHarmonyParms.last[j].length=1;  // need chords per measure
-						theMeanderState.theHarmonyParms.last[j].time32s=barts_count;
-						theMeanderState.theHarmonyParms.last[j].countInBar=bar_note_count;
-						if (bar_note_count<256)
-						played_notes_circular_buffer[bar_note_count++]=theMeanderState.theHarmonyParms.last[j];
-					}
-				
-					//  get tonic in channel 0
-											
-					if ( (note_to_play%MAX_NOTES)==(theMeanderState.last_harmony_chord_root_note%MAX_NOTES))
-					{
-						outputs[OUT_HARMONY_CV_OUTPUT].setVoltage((note_to_play/12.0)-4.0,0);  // (note, channel)
-						tonicFound=true;
-					}
-					else
-					{
-						if (!tonicFound)
-							outputs[OUT_HARMONY_CV_OUTPUT].setVoltage((note_to_play/12.0)-4.0,j+1);  // (note, channel)
-						else
-							outputs[OUT_HARMONY_CV_OUTPUT].setVoltage((note_to_play/12.0)-4.0,j);  // (note, channel)
-					}
-					
-				
-				}
+			beginClockTick();
+			generatingTick=true;
 		}
-		
-		if (playFlag)
-		{ 
-			outputs[OUT_HARMONY_VOLUME_OUTPUT].setVoltage(theMeanderState.theHarmonyParms.volume);
-
-			// output some fBm noise
-			outputs[OUT_FBM_HARMONY_OUTPUT].setChannels(1);  // set polyphony  
-		
-			float durationFactor=1.0;
-			if (theMeanderState.theHarmonyParms.enable_staccato)
-				durationFactor=0.5;
-			else
-				durationFactor=0.95;
-
-					
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BAR_OUTPUT)
-				durationFactor*=1.0;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEAT_OUTPUT)
-				durationFactor*=.25;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX2_OUTPUT)
-				durationFactor*=.125;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX4_OUTPUT)
-				durationFactor*=.0625;	
-			else
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX8_OUTPUT)
-				durationFactor*=.03125;	
-			else
-			if ( inputs[IN_PROG_STEP_EXT_CV].isConnected()) // something is connected to the circle STEP input but we do not know what. Assume it is an 16X BPM frequency
-		   		durationFactor *= .01562;  
-			
-						
-			float note_duration=durationFactor*4/(frequency*theMeanderState.theHarmonyParms.note_length_divisor);
-			harmonyGatePulse.reset();  // kill the pulse in case it is active
-			harmonyGatePulse.trigger(note_duration);  
+		if (!runNextGenerator())
+		{
+			endClockTick();
+			generatingTick=false;
+			++generated_tick;
 		}
+		generatingAhead=false;
+	}
 
-		outputs[OUT_FBM_HARMONY_OUTPUT].setVoltage((float)clamp((10.f*fBmrand), 0.f, 10.f) ,0); // rescale fBm output to 0-10V so it can be used better for CV.  Output even if harmony disabled
+	// the rest of the next tick's generation at once, when playback has caught up with it
+	void generateTick()
+	{
+		long long tick=generated_tick;
+		while (generated_tick==tick)
+			generateStep();
+	}
 
-		++circle_step_index;
-		if (circle_step_index>=theActiveHarmonyType.num_harmony_steps)
-			circle_step_index=0;
+	// before live step, circle or degree input changes the harmony or melody state: the generators of a tick must all
+	// see the same state, so the tick in progress is finished first
+	void finishGeneratingTick()
+	{
+		if (generatingTick)
+			generateTick();
+	}
 
-		if ((harmony_type==22)&&(step==0)&&(barChordNumber==0))  // random coming home
+	// called on each clock tick: make sure the tick has been generated, then play everything queued for it
+	void playTick()
+	{
+		while (generated_tick<=played_tick)  // generation fell behind, e.g. a fast external clock
+			generateTick();
+		const ScheduledEvent* event;
+		while ((event=scheduledEvents.front()) && (event->tick<=played_tick))
 		{
-			float rnd = rack::random::uniform();
-			int temp_num_harmony_steps=1 + (int)((rnd*(theHarmonyTypes[22].num_harmony_steps-1)));
-			bar_count += (theHarmonyTypes[22].num_harmony_steps-temp_num_harmony_steps);
+			applyEvent(*event);
+			scheduledEvents.pop();
 		}
-
+		fBm_cv_tick=songTick()-(generated_tick-played_tick);  // the song tick this tick was generated at
+		fBm_cv_tick_interval=fBm_cv_samples_since_tick;
+		fBm_cv_samples_since_tick=0;
+		++played_tick;
 	}
 
-	void userPlaysScaleDegreeMelody(int degree, float octaveOffset)  // C=0   play immediate
+	// drop anything not yet played and restart both clocks, as on stop and reset
+	void clearScheduledEvents()
 	{
-		if (degree<1)
-			degree=1;
-		if (degree>7)
-			degree=7;
-
-		
-
-		int	note_to_play=root_key_notes[root_key][degree-1]+(octaveOffset*12); 
-		outputs[OUT_MELODY_CV_OUTPUT].setVoltage((note_to_play/12.0)-4.0,0);  // (note, channel)  shift down 1 ocatve/v
-					
-		theMeanderState.theMelodyParms.last[0].note=note_to_play;
-		theMeanderState.theMelodyParms.last[0].noteType=NOTE_TYPE_MELODY;
-		theMeanderState.theMelodyParms.last[0].length=1;  // whole  note for now
-		theMeanderState.theMelodyParms.last[0].time32s=barts_count;
-		theMeanderState.theMelodyParms.last[0].countInBar=bar_note_count;
-
-		if (bar_note_count<256)
-		played_notes_circular_buffer[bar_note_count++]=theMeanderState.theMelodyParms.last[0];
-			
-		float durationFactor=1.0;
-		if (theMeanderState.theMelodyParms.enable_staccato)
-			durationFactor=0.5;
-		else
-			durationFactor=1.0;
-		
-		float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theMelodyParms.note_length_divisor);
-		melodyGatePulse.reset();  // kill the pulse in case it is active
-		melodyGatePulse.trigger(note_duration);  
+		scheduledEvents.clear();
+		generatingTick=false;  // the counters were reset, so the tick in progress is dropped
+		generated_tick=0;
+		played_tick=0;
 	}
 
-	void doMelody()
+	// Smooth fBm CV.  Rather than stepping when a note plays, OUT_FBM_HARMONY/MELODY/ARP follow each part's fBm every
+	// sample, along the same musical time base, so channel 0 passes through the values the notes are chosen from.
+	// Further polyphonic channels start elsewhere in the noise.  The voltages are made FBM_CV_BLOCK samples at a time
+	// by FastfBm1DNoiseRamp(), and only for connected outputs.
+	static const int FBM_CV_BLOCK=64;
+	static const int FBM_CV_PARTS=RANDOM_PART_ARP+1;
+	bool fBm_cv_smooth=false;
+	int fBm_cv_channels=1;
+	long long fBm_cv_tick=0;              // song tick of the last tick played
+	long long fBm_cv_samples_since_tick=0;
+	long long fBm_cv_tick_interval=0;     // samples between the last two ticks, for an external clock
+	int fBm_cv_index=FBM_CV_BLOCK;        // next sample of the block to play, the block is used up at FBM_CV_BLOCK
+	float fBm_cv_block[FBM_CV_PARTS][PORT_MAX_CHANNELS][FBM_CV_BLOCK]={};
+	const int fBmOutputs[FBM_CV_PARTS]={OUT_FBM_HARMONY_OUTPUT, OUT_FBM_MELODY_OUTPUT, OUT_FBM_ARP_OUTPUT};
+
+	bool isfBmOutput(int outputId)
 	{
-		if (doDebug) DEBUG("doMelody()");
-
-		outputs[OUT_MELODY_VOLUME_OUTPUT].setVoltage(theMeanderState.theMelodyParms.volume);
-		clock_t current_cpu_t= clock();  // cpu clock ticks since program began
-		double current_cpu_time_double= (double)(current_cpu_t) / (double)CLOCKS_PER_SEC;
-	
-		if (doDebug) DEBUG("Melody: Time=%.3lf",  (double)current_cpu_time_double);
-
-		++theMeanderState.theMelodyParms.bar_melody_counted_note;
-
-		theMeanderState.theArpParms.note_count=0;  // where does this really go, at the begining of a melody note
-	
-		double period=1.0/theMeanderState.theMelodyParms.period; // 1/seconds
-		double fBmarg=theMeanderState.theMelodyParms.seed + (double)(period*current_cpu_time_double); 
-		double fBmrand=(FastfBm1DNoise(fBmarg,theMeanderState.theMelodyParms.noctaves) +1.)/2; 
-			
-		theMeanderState.theMelodyParms.note_avg = 
-			(1.0-theMeanderState.theMelodyParms.alpha)*theMeanderState.theMelodyParms.note_avg + 
-			theMeanderState.theMelodyParms.alpha*(theMeanderState.theMelodyParms.range_bottom + (fBmrand*theMeanderState.theMelodyParms.r1));
-					
-		if (theMeanderState.theMelodyParms.note_avg>theMeanderState.theMelodyParms.range_top)
-		theMeanderState.theMelodyParms.note_avg=theMeanderState.theMelodyParms.range_top;
-		if (theMeanderState.theMelodyParms.note_avg<theMeanderState.theMelodyParms.range_bottom)
-		theMeanderState.theMelodyParms.note_avg=theMeanderState.theMelodyParms.range_bottom;
-		
-		int step=theMeanderState.last_harmony_step;	
-		theMeanderState.theMelodyParms.last_step= step;
-		int note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[step]);		
-		theMeanderState.theMelodyParms.last_chord_note_index= note_index;
-		int note_to_play=step_chord_notes[step][note_index]; 
-
-		if (theMeanderState.theMelodyParms.chordal)
-		{
-			note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[step]);	
-			note_to_play=step_chord_notes[step][note_index]; 
-	
-		}
-		else
-		if (theMeanderState.theMelodyParms.scaler)
-		{
-			note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_root_key_notes[root_key]);
-			note_to_play=root_key_notes[root_key][note_index]; 
-		}
+		return (outputId==OUT_FBM_HARMONY_OUTPUT)||(outputId==OUT_FBM_MELODY_OUTPUT)||(outputId==OUT_FBM_ARP_OUTPUT);
+	}
 
+	void fillfBmCVBlock()
+	{
+		double samplesPerTick=(inputs[IN_CLOCK_EXT_CV].isConnected()) ? (double)fBm_cv_tick_interval : transport.samples_per_tick;
+		double ticksPerSample=(running && (samplesPerTick>0.)) ? 1.0/samplesPerTick : 0.;
+		double tick=fBm_cv_tick + std::min(fBm_cv_samples_since_tick*ticksPerSample, 1.0);  // not past the next tick
 
-        if (false) // accidentals are probably not notated correctly  Flat accidentals may sound better than sharp
+		for (int part=0; part<FBM_CV_PARTS; ++part)
 		{
-			if ((theMeanderState.theMelodyParms.bar_melody_counted_note!=1)&&(theMeanderState.theMelodyParms.bar_melody_counted_note==(theMeanderState.theMelodyParms.note_length_divisor-1))) // allow accidentals, but not on first or last melody note in bar
+			if (!outputs[fBmOutputs[part]].isConnected())
+				continue;
+			double seed=theMeanderState.theHarmonyParms.seed;
+			double period=theMeanderState.theHarmonyParms.period;
+			int noctaves=theMeanderState.theHarmonyParms.noctaves;
+			if (part==RANDOM_PART_MELODY)
 			{
-			
-				float rnd = rack::random::uniform();
-				if (rnd<.05)
-					note_to_play += 1;
-				else
-				if (rnd>.90)
-					note_to_play -= 1;
+				seed=theMeanderState.theMelodyParms.seed;
+				period=theMeanderState.theMelodyParms.period;
+				noctaves=theMeanderState.theMelodyParms.noctaves;
 			}
-		}
-				
-		if (doDebug) DEBUG("    melody note_to_play=%d %s", note_to_play, note_desig[note_to_play%MAX_NOTES]);
-
-		if (true)	// do it even if melody notes will not be played, so arp will have roots
-		{   
-			if ((theMeanderState.theMelodyParms.destutter) && (note_to_play==theMeanderState.theMelodyParms.last[0].note) && (theMeanderState.theMelodyParms.last_stutter_step==step))   // seems like gate always fires
+			else
+			if (part==RANDOM_PART_ARP)
 			{
-				theMeanderState.theMelodyParms.stutter_detected=true;
-				theMeanderState.theMelodyParms.last_stutter_step=step;
+				seed=theMeanderState.theArpParms.seed;
+				period=theMeanderState.theArpParms.period;
+				noctaves=theMeanderState.theArpParms.noctaves;
 			}
-			else
+			double u=(1.0/period)*(tick/16.0);  // as musicalTime()
+			double du=(1.0/period)*(ticksPerSample/16.0);
+			for (int c=0; c<fBm_cv_channels; ++c)
 			{
-				theMeanderState.theMelodyParms.last_stutter_step=step;
-				theMeanderState.theMelodyParms.stutter_detected=false;
-										
-				theMeanderState.theMelodyParms.last[0].note=note_to_play;
-				theMeanderState.theMelodyParms.last[0].noteType=NOTE_TYPE_MELODY;
-				theMeanderState.theMelodyParms.last[0].length=theMeanderState.theMelodyParms.note_length_divisor;
-				theMeanderState.theMelodyParms.last[0].time32s=barts_count;
-				theMeanderState.theMelodyParms.last[0].countInBar=bar_note_count;
-
-				if ((theMeanderState.theMelodyParms.enabled)&&(bar_note_count<256))
-					played_notes_circular_buffer[bar_note_count++]=theMeanderState.theMelodyParms.last[0];
-			
-
-				if (theMeanderState.theMelodyParms.enabled)
-				{						
-					outputs[OUT_MELODY_CV_OUTPUT].setChannels(1);  // set polyphony  may need to deal with unset channel voltages
-					outputs[OUT_MELODY_CV_OUTPUT].setVoltage(((note_to_play/12.0) -4.0) ,0);  // (note, channel) -4 since midC=c4=0voutputs[OUT_MELODY_CV_OUTPUT].setVoltage((note_to_play -4 + theMeanderState.theMelodyParms.target_octave,0);  // (note, channel) -4 since midC=c4=0v
-		    	}
-
-				// output some fBm noise
-				outputs[OUT_FBM_MELODY_OUTPUT].setChannels(1);  // set polyphony  
-				outputs[OUT_FBM_MELODY_OUTPUT].setVoltage((float)clamp((10.f*fBmrand), 0.f, 10.f) ,0); // rescale fBm output to 0-10V so it can be used better for CV
-
-				float durationFactor=1.0;
-				if (theMeanderState.theMelodyParms.enable_staccato)
-					durationFactor=0.5;
-				else
-					durationFactor=0.95;
-				float note_duration=durationFactor*4/(frequency*theMeanderState.theMelodyParms.note_length_divisor);
-
-				// adjust melody note duration if arp enabled
-				
-				if (theMeanderState.theArpParms.enabled)
-					note_duration=durationFactor*4/(frequency*theMeanderState.theArpParms.note_length_divisor);
-				
-
-				if (theMeanderState.theMelodyParms.enabled)
-				melodyGatePulse.trigger(note_duration);  // Test 1s duration  need to use .process to detect this and then send it to output
+				float* block=fBm_cv_block[part][c];
+				FastfBm1DNoiseRamp(fBmChannelOrigin(part, seed, c)+u, du, noctaves, block, FBM_CV_BLOCK, noise);
+				for (int i=0; i<FBM_CV_BLOCK; ++i)
+					block[i]=clamp(5.f*(block[i]+1.f), 0.f, 10.f);  // 0-10V like the stepped output
 			}
 		}
 	}
 
-	void doArp() 
+	void processfBmCV()
 	{
-		if (doDebug) DEBUG("doArp()");
-	
-	    if (theMeanderState.theArpParms.note_count>=theMeanderState.theArpParms.count)
-	  		return;
-
-		int arp_note=0;
-
-		
-		if ((theMeanderState.theArpParms.pattern>=-1)&&(theMeanderState.theArpParms.pattern<=1))
-			arp_note=theMeanderState.theArpParms.note_count*theMeanderState.theArpParms.pattern;
-		else
-		if (theMeanderState.theArpParms.pattern==2)
-		{
-			if (theMeanderState.theArpParms.note_count<=((theMeanderState.theArpParms.count)/2))
-			arp_note=theMeanderState.theArpParms.note_count;
-			else
-			arp_note=theMeanderState.theArpParms.count-theMeanderState.theArpParms.note_count-1;
-		}
-		else
-		if (theMeanderState.theArpParms.pattern==-2)
-		{
-			if (theMeanderState.theArpParms.note_count<=((theMeanderState.theArpParms.count)/2))
-			arp_note-=theMeanderState.theArpParms.note_count;
-			else
-			arp_note=-theMeanderState.theArpParms.count+theMeanderState.theArpParms.note_count-1;
-		}
-		else
-			arp_note=theMeanderState.theArpParms.note_count*theMeanderState.theArpParms.pattern;
-
-		if (theMeanderState.theArpParms.pattern!=0)
-		++arp_note; // above the melody note
-
-		++theMeanderState.theArpParms.note_count;
-
-		float volume=theMeanderState.theMelodyParms.volume;
-		float volume_factor=pow((1.0-theMeanderState.theArpParms.decay), theMeanderState.theArpParms.note_count);
-		volume *= volume_factor;
-
-		
-		if (doDebug) DEBUG("theMeanderState.theMelodyParms.last_chord_note_index=%d", theMeanderState.theMelodyParms.last_chord_note_index);
-		if (doDebug) DEBUG("num_step_chord_notes[%d]=%d", theMeanderState.theMelodyParms.last_step, num_step_chord_notes[theMeanderState.theMelodyParms.last_step]);
-				
-		int note_to_play=100; // bogus
-
-		if (theMeanderState.theArpParms.chordal) // use step_chord_notes
+		if (fBm_cv_index>=FBM_CV_BLOCK)
 		{
-           note_to_play=step_chord_notes[theMeanderState.theMelodyParms.last_step][(theMeanderState.theMelodyParms.last_chord_note_index + arp_note)% num_step_chord_notes[theMeanderState.theMelodyParms.last_step]];
-		}
-		else 
-		if (theMeanderState.theArpParms.scaler) // use root_key_notes rather than step_chord_notes.  This is slower since scale note index has to be looked up
-		{   
-			if (false)  // old brute force search from beginning
-			{
-				for (int x=0; x<num_root_key_notes[root_key]; ++x)
-				{
-					if (root_key_notes[root_key][x]==theMeanderState.theMelodyParms.last[0].note)
-					{
-						note_to_play=root_key_notes[root_key][x+arp_note];
-						if (doDebug) DEBUG("note fount at index=%d root_key_notes[root_key][x]=%d", x, root_key_notes[root_key][x]);
-						break;
-					}
-				}
-			}
-		
-			if (true)  // new // BSP search  .  
-			{
-				int note_to_search_for=theMeanderState.theMelodyParms.last[0].note;
-				if (doDebug) DEBUG("BSP  note_to_search_for=%d",  note_to_search_for);
-				int num_to_search=num_root_key_notes[root_key];
-				if (doDebug) DEBUG("BSP num_to_search=%d", num_to_search);
-				int start_search_index=0;
-				int end_search_index=num_root_key_notes[root_key]-1;
-				int pass=0;
-				int partition_index=0;
-				while (pass<8)
-				{
-					if (doDebug) DEBUG("start_search_index=%d end_search_index=%d", start_search_index, end_search_index);
-					partition_index=(end_search_index+start_search_index)/2;
-					if (doDebug) DEBUG("BSP start_search_index=%d end_search_index=%d partition_index=%d", start_search_index, end_search_index, partition_index);
-					if ( note_to_search_for>root_key_notes[root_key][partition_index])
-					{
-						start_search_index=partition_index;
-						if (doDebug) DEBUG(">BSP root_key_notes[root_key][partition_index]=%d", root_key_notes[root_key][partition_index]);
-					}
-					else
-					if ( note_to_search_for<root_key_notes[root_key][partition_index])
-					{
-						end_search_index=partition_index;
-						if (doDebug) DEBUG("<BSP root_key_notes[root_key][partition_index]=%d", root_key_notes[root_key][partition_index]);
-					}
-					else
-					{
-						/* we found it */
-						if (doDebug) DEBUG("value %d found at index %d", root_key_notes[root_key][partition_index], partition_index);
-						pass=8;
-						break;
-					}
-					++pass;
-				}
-				if ((partition_index>=0) && (partition_index<num_to_search))
-					note_to_play=root_key_notes[root_key][partition_index+arp_note];
-							
-			}
-			
+			fillfBmCVBlock();
+			fBm_cv_index=0;
 		}
-		
-		
-	
-		if (((theMeanderState.theMelodyParms.enabled)||(theMeanderState.theArpParms.enabled))&&theMeanderState.theArpParms.note_count<32)
+		for (int part=0; part<FBM_CV_PARTS; ++part)
 		{
-			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].note=note_to_play;
-			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].noteType=NOTE_TYPE_ARP;
-			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].length=theMeanderState.theArpParms.note_length_divisor;
-			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].time32s=barts_count;
-			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].countInBar=bar_note_count;
-			if (bar_note_count<256)
-			played_notes_circular_buffer[bar_note_count++]=theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count];
+			Output& output=outputs[fBmOutputs[part]];
+			if (!output.isConnected())
+				continue;
+			output.setChannels(fBm_cv_channels);
+			for (int c=0; c<fBm_cv_channels; ++c)
+				output.setVoltage(fBm_cv_block[part][c][fBm_cv_index], c);
 		}
-	
-		outputs[OUT_MELODY_CV_OUTPUT].setChannels(1);  // set polyphony  may need to deal with unset channel voltages
-		outputs[OUT_MELODY_CV_OUTPUT].setVoltage(((note_to_play/12.0) -4.0) ,0);  // (note, channel) -4 since midC=c4=0voutputs[OUT_MELODY_CV_OUTPUT].setVoltage((note_to_play -4 + theMeanderState.theMelodyParms.target_octave,0);  // (note, channel) -4 since midC=c4=0v
-		outputs[OUT_MELODY_VOLUME_OUTPUT].setVoltage(volume);  // this is strictly for arp decay
-		melodyGatePulse.reset();  // kill the pulse in case it is active
-		float durationFactor=1.0;
-		if (theMeanderState.theMelodyParms.enable_staccato)
-			durationFactor=0.5;
-		else
-			durationFactor=0.95;
-		float note_duration=durationFactor*4/(frequency*theMeanderState.theArpParms.note_length_divisor);
-		melodyGatePulse.trigger(note_duration);  
+		++fBm_cv_index;
+		if (running && (played_tick>0))  // hold at the start until the first tick
+			++fBm_cv_samples_since_tick;
 	}
- 
-
-	void doBass()
-	{
-		if (doDebug) DEBUG("doBass()");
 
-	    outputs[OUT_BASS_VOLUME_OUTPUT].setVoltage(theMeanderState.theBassParms.volume);
-				
-		if (theMeanderState.theBassParms.enabled) 
-		{
-			++theMeanderState.theBassParms.bar_bass_counted_note;
-			if ((theMeanderState.theBassParms.syncopate)&&(theMeanderState.theBassParms.bar_bass_counted_note==2))  // experimenting with bass patterns
-			  return;
-			if ((theMeanderState.theBassParms.shuffle)&&((theMeanderState.theBassParms.bar_bass_counted_note%3)==2))  // experimenting with bass patterns
-			return;
 
-			if (theMeanderState.theBassParms.octave_enabled)
-				outputs[OUT_BASS_CV_OUTPUT].setChannels(2);  // set polyphony  may need to deal with unset channel voltages
-			else
-				outputs[OUT_BASS_CV_OUTPUT].setChannels(1);  // set polyphony  may need to deal with unset channel voltages
-			if (doDebug) DEBUG("    bass note to play=%d %s", theMeanderState.last_harmony_chord_root_note, note_desig[theMeanderState.last_harmony_chord_root_note%MAX_NOTES]);
-				
-			theMeanderState.theBassParms.last[0].note=theMeanderState.last_harmony_chord_root_note+ (theMeanderState.theBassParms.target_octave*12);  
-			theMeanderState.theBassParms.last[0].noteType=NOTE_TYPE_BASS;
-			theMeanderState.theBassParms.last[0].length=1;  // need bass notes per measure
-			theMeanderState.theBassParms.last[0].time32s=barts_count;
-			theMeanderState.theBassParms.last[0].countInBar=bar_note_count;
-			if (bar_note_count<256)
-			played_notes_circular_buffer[bar_note_count++]=theMeanderState.theBassParms.last[0];
-
-			outputs[OUT_BASS_CV_OUTPUT].setVoltage((theMeanderState.last_harmony_chord_root_note/12.0)-4.0 +theMeanderState.theBassParms.target_octave ,0);  //(note, channel)	
-				
-			if (theMeanderState.theBassParms.octave_enabled)
-			{
-		
-				theMeanderState.theBassParms.last[1].note=theMeanderState.theBassParms.last[0].note+12; 
-				theMeanderState.theBassParms.last[1].noteType=NOTE_TYPE_BASS;
-				theMeanderState.theBassParms.last[1].length=1;  // need bass notes per measure
-				theMeanderState.theBassParms.last[1].time32s=barts_count;
-				theMeanderState.theBassParms.last[1].countInBar=bar_note_count;
-				if (bar_note_count<256)
-				played_notes_circular_buffer[bar_note_count++]=theMeanderState.theBassParms.last[1];
-
-			 	outputs[OUT_BASS_CV_OUTPUT].setVoltage((theMeanderState.last_harmony_chord_root_note/12.0)-3.0 +theMeanderState.theBassParms.target_octave ,1);
-			}
-
-			if (!theMeanderState.theBassParms.accent)  // need to redo with new gate procedure
-			{
-				theMeanderState.theBassParms.note_accented=false; 
-			}
-			else
-			{
-				if (theMeanderState.theBassParms.bar_bass_counted_note==1)  // experimenting with bass patterns
-					theMeanderState.theBassParms.note_accented=true; 
-				else
-					theMeanderState.theBassParms.note_accented=false; 
-			}	
-			
-			float durationFactor=1.0;
-			if (theMeanderState.theBassParms.enable_staccato)
-				durationFactor=0.5;
-			else
-				durationFactor=0.95;
-			
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BAR_OUTPUT)
-				durationFactor*=1.0;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEAT_OUTPUT)
-				durationFactor*=.25;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX2_OUTPUT)
-				durationFactor*=.125;
-			else	
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX4_OUTPUT)
-				durationFactor*=.0625;	
-			else
-			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX8_OUTPUT)
-				durationFactor*=.03125;	
-			else
-			if ( inputs[IN_PROG_STEP_EXT_CV].isConnected()) // something is connected to the circle STEP input but we do not know what. Assume it is an 16X BPM frequency
-		   		durationFactor *= .01562;  
-			
-			float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theBassParms.note_length_divisor);
-
-		    bassGatePulse.trigger(note_duration);  
-		}
-	}
-   
-	LFOGenerator LFOclock;
+	MeanderTransport transport;  // internal 32nd note clock
 	
 	dsp::SchmittTrigger ST_32ts_trig;  // 32nd note timer tick
 
@@ -1161,28 +277,10 @@ struct Meander : Module
 	dsp::SchmittTrigger bpm_mode_trig;
 	dsp::SchmittTrigger step_button_trig;
 
-	dsp::PulseGenerator resetPulse;
-	bool reset_pulse = false;
-
-	dsp::PulseGenerator runPulse;
-	bool run_pulse = false;
-
-	dsp::PulseGenerator stepPulse;
-	bool step_pulse = false;
-
-	// PULSES FOR TRIGGER OUTPUTS INSTEAD OF GATES
-	dsp::PulseGenerator clockPulse32ts;
-	bool pulse32ts = false;
-	dsp::PulseGenerator clockPulse16ts;
-	bool pulse16ts = false;
-	dsp::PulseGenerator clockPulse8ts;
-	bool pulse8ts = false; 
-	dsp::PulseGenerator clockPulse4ts;
-	bool pulse4ts = false;
-	dsp::PulseGenerator clockPulse2ts;
-	bool pulse2ts = false;
-	dsp::PulseGenerator clockPulse1ts;
-	bool pulse1ts = false;
+	// note gates, clock triggers and the run and reset out triggers
+	MeanderGates gates;
+	const int gateOutputs[NUM_GATES]={OUT_HARMONY_GATE_OUTPUT, OUT_MELODY_GATE_OUTPUT, OUT_BASS_GATE_OUTPUT, OUT_CLOCK_BAR_OUTPUT, OUT_CLOCK_BEAT_OUTPUT,
+		OUT_CLOCK_BEATX2_OUTPUT, OUT_CLOCK_BEATX4_OUTPUT, OUT_CLOCK_BEATX8_OUTPUT, OUT_RUN_OUT, OUT_RESET_OUT};
 	
 	float trigger_length = 0.0001f;
 
@@ -1192,26 +290,7 @@ struct Meander : Module
 
 	bool running = true;
 	
-	int bar_count = 0;  // number of bars running count
-	
-	int i16ts_count = 0;  // counted 32s notes per sixteenth note
-	int i8ts_count = 0;  // counted 32s notes per eighth note
-	int i4ts_count = 0; // counted 32s notes per quarter note
-	int i2ts_count = 0; // counted 32s notes per half note
-	int barts_count = 0;     // counted 32s notes per bar
 
-	float tempo =120.0f;
-	float frequency = 2.0f;
-
-	
-	int i16ts_count_limit = 2;// 32s notes per sixteenth note
-	int i8ts_count_limit = 4;   // 32s notes per eighth note
-	int i4ts_count_limit = 8;  // 32s notes per quarter note
-	int i2ts_count_limit =16;  // 32s notes per half note
-	int barts_count_limit = 32;     // 32s notes per bar
-	
-	float min_bpm = 10.0f;
-	float max_bpm = 300.0f;
 
 	float extHarmonyIn=-99;
   
@@ -1224,10 +303,6 @@ struct Meander : Module
 	
 	float phase = 0.f;
   		
-	float last_melody_note=0;
-	float current_melody_note=0;
-
-	int circle_step_index=0;
 
 	dsp::SchmittTrigger HarmonyEnableToggle;
 	dsp::SchmittTrigger MelodyEnableToggle;
@@ -1260,20 +335,36 @@ struct Meander : Module
 	
 	dsp::SchmittTrigger CircleStepToggles[MAX_STEPS];
 	dsp::SchmittTrigger CircleStepSetToggles[MAX_STEPS];
-	bool CircleStepStates[MAX_STEPS]={};
-	bool CircleStepSetStates[MAX_STEPS]={};
-
-	rack::dsp::PulseGenerator barTriggerPulse; 
-
-	rack::dsp::PulseGenerator harmonyGatePulse; 
-	rack::dsp::PulseGenerator melodyGatePulse; 
-	rack::dsp::PulseGenerator bassGatePulse; 
-	rack::dsp::PulseGenerator barGaterPulse; 
 
 	bool time_sig_changed=false;
 
 	int override_step=1;
 
+	std::string harmonyPresetBankPath;  // empty for the built-in presets
+	const HarmonyPresetBank* harmonyPresetBankChanged=nullptr;  // set by the UI thread, swapped in by process() like harmonyPresetChanged
+	bool noiseSeedChanged=false;  // set by dataFromJson(), noiseSeedNew is applied by process() so the tables are not rewritten under it
+	uint64_t noiseSeedNew=0;
+
+	// builds the fBm wavetables on the UI thread, from a copy of the noise with the seed process() is or will be using
+	void preparefBmWavetables()
+	{
+		NoiseContext wavetableNoise((noiseSeedChanged) ? noiseSeedNew : noise.seed);
+		buildfBmWavetables(wavetableNoise);
+	}
+
+	// Parses the bank file once, on the calling thread.  Returns false and keeps the current bank if it has no presets.
+	bool useHarmonyPresetBank(const std::string &path)
+	{
+		const HarmonyPresetBank* bank=(path.empty()) ? &theBuiltinHarmonyPresetBank : loadHarmonyPresetBank(path);
+		if (!bank)
+			return false;
+		harmonyPresetBankPath=path;
+		if (paramQuantities[CONTROL_HARMONYPRESETS_PARAM])
+			paramQuantities[CONTROL_HARMONYPRESETS_PARAM]->maxValue=(float)bank->size();
+		harmonyPresetBankChanged=bank;
+		return true;
+	}
+
     // save button states
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
@@ -1300,6 +391,29 @@ struct Meander : Module
 		json_object_set_new(rootJ, "theBassParmsaccent", json_boolean(theMeanderState.theBassParms.accent));
 		json_object_set_new(rootJ, "theBassParmsshuffle", json_boolean(theMeanderState.theBassParms.shuffle));
 		json_object_set_new(rootJ, "theBassParmsoctave_enabled", json_boolean(theMeanderState.theBassParms.octave_enabled));
+		json_object_set_new(rootJ, "random_seed", json_integer((json_int_t)random_seed));
+		json_object_set_new(rootJ, "noise_seed", json_integer((json_int_t)noise.seed));
+		if (!harmonyPresetBankPath.empty())
+			json_object_set_new(rootJ, "harmonyPresetBank", json_string(harmonyPresetBankPath.c_str()));
+		json_object_set_new(rootJ, "fBmWavetable", json_boolean(fBm_wavetable));
+		json_object_set_new(rootJ, "fBmCVSmooth", json_boolean(fBm_cv_smooth));
+		json_object_set_new(rootJ, "fBmCVChannels", json_integer(fBm_cv_channels));
+		if (profiler.enabled)
+		{
+			json_object_set_new(rootJ, "profiling", json_boolean(true));
+			json_t *profileJ = json_object();
+			for (int i=0; i<NUM_PROFILE_SECTIONS; ++i)
+			{
+				MeanderProfiler::Stats stats=profiler.stats(i);
+				json_t *sectionJ = json_object();
+				json_object_set_new(sectionJ, "count", json_integer((json_int_t)stats.count));
+				json_object_set_new(sectionJ, "mean_ns", json_real(stats.mean));
+				json_object_set_new(sectionJ, "p99_ns", json_real(stats.p99));
+				json_object_set_new(sectionJ, "max_ns", json_real(stats.max));
+				json_object_set_new(profileJ, profileSectionKeys[i], sectionJ);
+			}
+			json_object_set_new(rootJ, "profile", profileJ);
+		}
 		
 		return rootJ;
 	}
@@ -1378,21 +492,81 @@ struct Meander : Module
 		if (BassParmsshuffleJ)
 			theMeanderState.theBassParms.shuffle = json_is_true(BassParmsshuffleJ);
 
-		json_t *BassParmsoctave_enabledJ = json_object_get(rootJ, "theBassParmsoctave_enabled");
-		if (BassParmsoctave_enabledJ)
-			theMeanderState.theBassParms.octave_enabled = json_is_true(BassParmsoctave_enabledJ);
+		json_t *BassParmsoctave_enabledJ = json_object_get(rootJ, "theBassParmsoctave_enabled");
+		if (BassParmsoctave_enabledJ)
+			theMeanderState.theBassParms.octave_enabled = json_is_true(BassParmsoctave_enabledJ);
+
+		json_t *random_seedJ = json_object_get(rootJ, "random_seed");
+		if (random_seedJ)
+			random_seed = (uint64_t)json_integer_value(random_seedJ);
+
+		json_t *noise_seedJ = json_object_get(rootJ, "noise_seed");
+		noiseSeedNew = (noise_seedJ) ? (uint64_t)json_integer_value(noise_seedJ) : 0;  // patches from before noise seeds keep the reference permutation
+		noiseSeedChanged = true;
+
+		json_t *harmonyPresetBankJ = json_object_get(rootJ, "harmonyPresetBank");
+		if (harmonyPresetBankJ)
+		{
+			if (!useHarmonyPresetBank(json_string_value(harmonyPresetBankJ)))
+				if (doDebug) DEBUG("harmony preset bank %s could not be loaded", json_string_value(harmonyPresetBankJ));
+		}
+
+		json_t *fBmWavetableJ = json_object_get(rootJ, "fBmWavetable");
+		if (fBmWavetableJ)
+			fBm_wavetable = json_is_true(fBmWavetableJ);
+		if (fBm_wavetable)
+			preparefBmWavetables();  // for the seeds just read
+
+		json_t *fBmCVSmoothJ = json_object_get(rootJ, "fBmCVSmooth");
+		if (fBmCVSmoothJ)
+			fBm_cv_smooth = json_is_true(fBmCVSmoothJ);
+
+		json_t *fBmCVChannelsJ = json_object_get(rootJ, "fBmCVChannels");
+		if (fBmCVChannelsJ)
+			fBm_cv_channels = clamp((int)json_integer_value(fBmCVChannelsJ), 1, (int)PORT_MAX_CHANNELS);
+
+		json_t *profilingJ = json_object_get(rootJ, "profiling");  // keep timing a patch that is being diagnosed
+		if (profilingJ)
+			profiler.enable(json_is_true(profilingJ));
 		
 	}
 
 	    	
+	// on level for each gate.  The note gates carry their part's volume, non-standard but useful.
+	float gateLevel(int gate)
+	{
+		switch (gate)
+		{
+			case GATE_HARMONY:
+				return clamp((float)theMeanderState.theHarmonyParms.volume, 2.1f, 10.f);  // don't let gate on level drop below 2.0v so it will trigger ADSR etc.
+			case GATE_MELODY:
+				return clamp((float)theMeanderState.theMelodyParms.volume, 2.1f, 10.f);
+			case GATE_BASS:
+			{
+				float bassGateLevel=theMeanderState.theBassParms.volume;
+				if ((theMeanderState.theBassParms.accent)&&(!theMeanderState.theBassParms.note_accented))
+					bassGateLevel*=.8;
+				return clamp(bassGateLevel, 2.1f, 10.f);
+			}
+		}
+		return 10.0f;
+	}
+
 	void process(const ProcessArgs &args) override 
 	{
 		
-		if (!instanceRunning)
-			return;
-	
 		if (!globalsInitialized)
 			return;
+		profiler.startIfRequested();
+		uint64_t profileStart=profiler.begin();
+
+		gates.setSampleRate(args.sampleRate);  // before anything can start a gate
+		if (noiseSeedChanged)
+		{
+			setNoiseSeed(noiseSeedNew);
+			noiseSeedChanged=false;
+		}
+		prog_step_input_connected=inputs[IN_PROG_STEP_EXT_CV].isConnected();
 
 		//Run
 	
@@ -1402,15 +576,8 @@ struct Meander : Module
 
 			if(!running)
 			{
-				i16ts_count = 0;  
-				i8ts_count = 0;  
-				i4ts_count = 0; 
-				i2ts_count = 0; 
-				barts_count = 0;    
-				
-				theMeanderState.theMelodyParms.bar_melody_counted_note=0;
-				theMeanderState.theArpParms.note_count=0;
-				theMeanderState.theBassParms.bar_bass_counted_note=0;
+				resetClockCounters();
+				clearScheduledEvents();
 				outputs[OUT_CLOCK_BAR_OUTPUT].setVoltage(0.0f);	   // bars 	
 				outputs[OUT_CLOCK_BEAT_OUTPUT].setVoltage(0.0f);   // 4ts 
 				outputs[OUT_CLOCK_BEATX2_OUTPUT].setVoltage(0.0f); // 8ts
@@ -1419,15 +586,12 @@ struct Meander : Module
 			}
 			else
 			{
-				LFOclock.setFreq(frequency*(32/time_sig_bottom));	  // for 32ts	
 				barts_count_limit = (32*time_sig_top/time_sig_bottom);
 			}
 			theMeanderState.theHarmonyParms.pending_step_edit=0;
-			runPulse.trigger(0.01f); // delay 10ms
+			gates.trigger(GATE_RUN, 0.01f); // delay 10ms
 		}
 		lights[LIGHT_LEDBUTTON_RUN].setBrightness(running ? 1.0f : 0.0f); 
-		run_pulse = runPulse.process(1.0 / args.sampleRate);  
-		outputs[OUT_RUN_OUT].setVoltage((run_pulse ? 10.0f : 0.0f));
 
 		if (inputs[IN_TEMPO_EXT_CV].isConnected())
 		{
@@ -1459,31 +623,24 @@ struct Meander : Module
 		{
 		//	setup_harmony();
 			time_sig_changed=false;
-	    	LFOclock.setReset(1.0f);
+			transport.reset();
+			barts_count_limit = (32*time_sig_top/time_sig_bottom);
 			bar_count = 0;
 			bar_note_count=0;
-			i16ts_count = 0;  
-			i8ts_count = 0;  
-			i4ts_count = 0; 
-			i2ts_count = 0; 
-			barts_count = 0;    
-			 
-
-			theMeanderState.theMelodyParms.bar_melody_counted_note=0;
-			theMeanderState.theArpParms.note_count=0;
-			theMeanderState.theBassParms.bar_bass_counted_note=0;
+			resetClockCounters();
+			clearScheduledEvents();
 
 			theMeanderState.theHarmonyParms.last_circle_step=-1; // for Markov chain
 			
 			resetLight = 1.0;
-			resetPulse.trigger(0.01f);  // necessary to pass on reset below vis resetPuls.process()
+			gates.trigger(GATE_RESET, 0.01f);  // pass the reset on at OUT_RESET_OUT
 
 				
 			if (!running)
 			{
-				harmonyGatePulse.reset();  // kill the pulse in case it is active
-				melodyGatePulse.reset();  // kill the pulse in case it is active
-				bassGatePulse.reset();  // kill the pulse in case it is active
+				gates.reset(GATE_HARMONY);  // kill the pulse in case it is active
+				gates.reset(GATE_MELODY);  // kill the pulse in case it is active
+				gates.reset(GATE_BASS);  // kill the pulse in case it is active
 				outputs[OUT_HARMONY_GATE_OUTPUT].setVoltage(0);
 				outputs[OUT_MELODY_GATE_OUTPUT].setVoltage(0);
 				outputs[OUT_BASS_GATE_OUTPUT].setVoltage(0);
@@ -1496,12 +653,11 @@ struct Meander : Module
 
 		resetLight -= resetLight / lightLambda / args.sampleRate;
 		lights[LIGHT_LEDBUTTON_RESET].setBrightness(resetLight); 
-		reset_pulse = resetPulse.process(1.0 / args.sampleRate);
-  		outputs[OUT_RESET_OUT].setVoltage((reset_pulse ? 10.0f : 0.0f));
         
 	
 		if ((step_button_trig.process(params[BUTTON_PROG_STEP_PARAM].getValue() || (  inputs[IN_PROG_STEP_EXT_CV].isConnected()  &&  (inputs[IN_PROG_STEP_EXT_CV].getVoltage() > 0.))))) 
 		{
+			finishGeneratingTick();
 			++bar_count;
 
 			if (theMeanderState.theHarmonyParms.enabled)
@@ -1524,18 +680,10 @@ struct Meander : Module
 			int degreeStep=(theActiveHarmonyType.harmony_steps[override_step])%8;  
 			
 			//find this in semicircle
-			for (int j=0; j<7; ++j)
-			{
-				if  (theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].Degree==degreeStep)
-				{
-					current_circle_position = theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].CircleIndex; 
-					if (doDebug) DEBUG("harmony step edit-pt2 current_circle_position=%d", current_circle_position);
-					break;
-				}
-			}
+			current_circle_position = degree_circle_position[degreeStep]; 
+			if (doDebug) DEBUG("harmony step edit-pt2 current_circle_position=%d", current_circle_position);
 		
 			stepLight = 1.0;
-			stepPulse.trigger(0.01f);  // necessary to pass on reset below vis resetPuls.process()
            			
 			if (running)
 			{
@@ -1548,16 +696,11 @@ struct Meander : Module
 
 		stepLight -= stepLight / lightLambda / args.sampleRate;
 		lights[LIGHT_LEDBUTTON_PROG_STEP_PARAM].setBrightness(stepLight);
-		step_pulse = stepPulse.process(1.0 / args.sampleRate);
 
+		uint64_t clockTickStart=profiler.begin();
 		if(running)  
 		{
-			// these should be done in initialization rather than every process() call
-			LFOclock.setFreq(frequency*(32/time_sig_bottom));	  // for 32ts	should not hurt top call this each sample
-			barts_count_limit = (32*time_sig_top/time_sig_bottom);
-			//************************************************************************
-						 
-			LFOclock.step(1.0 / args.sampleRate);
+			transport.setRate(frequency*(32/time_sig_bottom), args.sampleRate);  // for 32ts, only does work on a change
 
 			bool clockTick=false;
 			if ( inputs[IN_CLOCK_EXT_CV].isConnected())  // external clock connected to Clock input
@@ -1585,203 +728,22 @@ struct Meander : Module
 			}
 			else // no external clock connected to Clock input, use internal clock
 			{
-				float IntClockLevel=5.0f*(LFOclock.sqr()+1.0f);
-				if (ST_32ts_trig.process(LFOclock.sqr()))                         // triggers from each external clock tick ONLY once when .sqr() reaches 1.0V
-				{
-					 clockTick=true;
-				}
-			
-				 outputs[OUT_CLOCK_OUT].setChannels(1);  // set polyphony  
-				 outputs[OUT_CLOCK_OUT].setVoltage(IntClockLevel);  
-			}
-				
-		    if (clockTick)
-			{
-				bool melodyPlayed=false;   // set to prevent arp note being played on the melody beat
-				int barChordNumber=(int)((int)(barts_count*theMeanderState.theHarmonyParms.note_length_divisor)/(int)32);
-			
-				// bar
-				if (barts_count == 0) 
-				{
-					theMeanderState.theMelodyParms.bar_melody_counted_note=0;
-					theMeanderState.theBassParms.bar_bass_counted_note=0;
-					bar_note_count=0;
-					if ((theMeanderState.theHarmonyParms.note_length_divisor==1)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doHarmony(barChordNumber, theMeanderState.theHarmonyParms.enabled);
-					if ((theMeanderState.theBassParms.note_length_divisor==1)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doBass();
-					if ((theMeanderState.theMelodyParms.note_length_divisor==1)&&(!theMeanderState.userControllingMelody))
-					{
-						doMelody();
-						melodyPlayed=true;
-					}
-					clockPulse1ts.trigger(trigger_length);
-					// Pulse the output gate 
-					barTriggerPulse.trigger(1e-3f);  // 1ms duration  need to use .process to detect this and then send it to output
-				}
-						
-		        // i2ts
-				if (i2ts_count == 0)
-				{
-					if ((theMeanderState.theHarmonyParms.note_length_divisor==2)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doHarmony(barChordNumber, theMeanderState.theHarmonyParms.enabled);
-					if ((theMeanderState.theBassParms.note_length_divisor==2)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doBass();
-					if ((theMeanderState.theMelodyParms.note_length_divisor==2)&&(!theMeanderState.userControllingMelody))
-					{
-						doMelody();
-						melodyPlayed=true;
-					}
-					i2ts_count++;
-
-					if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-						clockPulse2ts.trigger(trigger_length);
-				}
-				else
-				if (i2ts_count == (i2ts_count_limit-1))
-				{
-					i2ts_count = 0;    
-					if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-						clockPulse2ts.trigger(trigger_length);
-				}
-				else
-				{
-					i2ts_count++;
-				}
-								
-		
-				// i4ts
-				if (i4ts_count == 0)
-				{
-					if ((theMeanderState.theHarmonyParms.note_length_divisor==4)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doHarmony(barChordNumber, theMeanderState.theHarmonyParms.enabled);
-					if ((theMeanderState.theBassParms.note_length_divisor==4)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doBass();
-					if ((theMeanderState.theMelodyParms.note_length_divisor==4)&&(!theMeanderState.userControllingMelody))
-					{
-						doMelody();
-						melodyPlayed=true;
-					}
-					if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==4)&&(!melodyPlayed))
-						doArp();
-
-					i4ts_count++;
-
-					if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-					 	clockPulse4ts.trigger(trigger_length);
-				}
-				else
-				if (i4ts_count == (i4ts_count_limit-1))
-				{
-					i4ts_count = 0;  
-					if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-					 	clockPulse4ts.trigger(trigger_length);
-				}
-				else
-				{
-					i4ts_count++;
-				}
-				
-					  
-		 		// i8ts
-				if (i8ts_count == 0)
+				if (transport.process())  // sample accurate 32nd note tick
 				{
-					if ((theMeanderState.theHarmonyParms.note_length_divisor==8)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doHarmony(barChordNumber, theMeanderState.theHarmonyParms.enabled);
-					if ((theMeanderState.theBassParms.note_length_divisor==8)&&(!theMeanderState.userControllingHarmonyFromCircle))
-						doBass();
-					if ((theMeanderState.theMelodyParms.note_length_divisor==8)&&(!theMeanderState.userControllingMelody))
-					{
-						doMelody();
-						melodyPlayed=true;
-					}
-					if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==8)&&(!melodyPlayed))
-						doArp();
-
-					i8ts_count++;
-
-					if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-						clockPulse8ts.trigger(trigger_length);
-				}
-				else
-				if (i8ts_count == (i8ts_count_limit-1))
-				{
-					i8ts_count = 0; 
-					if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-					  clockPulse8ts.trigger(trigger_length);
-				}
-				else
-				{
-					i8ts_count++; 
-				}
-				
-				
-				// i16ts
-				if (i16ts_count == 0)
-				{
-					if ((theMeanderState.theMelodyParms.note_length_divisor==16)&&(!theMeanderState.userControllingMelody))
-					{
-						doMelody();  
-						melodyPlayed=true;  
-					}
-					if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==16)&&(!melodyPlayed))
-						doArp();
-
-					i16ts_count++;
-
-					if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-						clockPulse16ts.trigger(trigger_length);
-				}
-				else
-				if (i16ts_count == (i16ts_count_limit-1))
-				{
-					i16ts_count = 0;
-					if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
-						clockPulse16ts.trigger(trigger_length);
-				}
-				else
-				{
-					i16ts_count++;
-				}
-				
-
-				//32nds  ***********************************
-
-				clock_t current_cpu_t= clock();  // cpu clock ticks since program began
-				double current_cpu_time_double= (double)(current_cpu_t) / (double)CLOCKS_PER_SEC;
-			
-				 // do on each 1/32nd clock tick
-				
-				if ((theMeanderState.theMelodyParms.note_length_divisor==32)&&(!theMeanderState.userControllingMelody))
-				{
-					doMelody();   
-					melodyPlayed=true; 
-				}
-				if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==32)&&(!melodyPlayed))
-					doArp(); 
-							
-				// output some fBm noise
-				double period=1.0/theMeanderState.theArpParms.period; // 1/seconds
-				double fBmarg=theMeanderState.theArpParms.seed + (double)(period*current_cpu_time_double); 
-				double fBmrand=(FastfBm1DNoise(fBmarg,theMeanderState.theArpParms.noctaves) +1.)/2; 
-				outputs[OUT_FBM_ARP_OUTPUT].setChannels(1);  // set polyphony  
-				outputs[OUT_FBM_ARP_OUTPUT].setVoltage((float)clamp((10.f*fBmrand), 0.f, 10.f) ,0);  // rescale fBm output to 0-10V so it can be used better for CV
-				
-				if (barts_count == (barts_count_limit-1))  // do this after all processing so bar_count does not get incremented too early
-				{
-					barts_count = 0;  
-					theMeanderState.theMelodyParms.bar_melody_counted_note=0;
-					theMeanderState.theBassParms.bar_bass_counted_note=0;
-					bar_note_count=0;
-					if (!theMeanderState.userControllingHarmonyFromCircle)  // don't mess up bar count
-					++bar_count; 
+					clockTick=true;
+					outputs[OUT_CLOCK_OUT].setChannels(1);  // set polyphony  
+					outputs[OUT_CLOCK_OUT].setVoltage(10.0f);  
 				}
 				else
+				if (transport.clockFalls())
 				{
-					barts_count++;  
+					outputs[OUT_CLOCK_OUT].setVoltage(0.0f);  
 				}
+			}
 				
-				clockPulse32ts.trigger(trigger_length);  // retrigger the pulse after all done in this loop
+		    if (clockTick)
+			{
+				playTick();
 
 			//	outputs[OUT_CLOCK_OUT].setChannels(1);  // set polyphony  
 			//	outputs[OUT_CLOCK_OUT].setVoltage(10.0f);  
@@ -1789,69 +751,32 @@ struct Meander : Module
 			}
 			else  // !clockTick
 			{
+				// generate ahead on samples with no tick, so generation and playback never share a sample
+				if (generated_tick<played_tick+lookahead_ticks)
+					generateStep();
 			//	outputs[OUT_CLOCK_OUT].setChannels(1);  // set polyphony  
 			//	outputs[OUT_CLOCK_OUT].setVoltage(0.0f);  
 			}
 			
 		}
+		profiler.end(PROFILE_CLOCK_TICK, clockTickStart);
 
-		pulse1ts = clockPulse1ts.process(1.0 / args.sampleRate);
-		pulse2ts = clockPulse2ts.process(1.0 / args.sampleRate);
-		pulse4ts = clockPulse4ts.process(1.0 / args.sampleRate);
-		pulse8ts = clockPulse8ts.process(1.0 / args.sampleRate);
-		pulse16ts = clockPulse16ts.process(1.0 / args.sampleRate);
-		pulse32ts = clockPulse32ts.process(1.0 / args.sampleRate);
-
-		// end the gate if pulse timer has expired 
-
-		if (false) // standard gate voltages 
-		{
-			outputs[OUT_HARMONY_GATE_OUTPUT].setVoltage( harmonyGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ? CV_MAX10 : 0.0 ); 
-			outputs[OUT_MELODY_GATE_OUTPUT].setVoltage( melodyGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ? CV_MAX10 : 0.0 ); 
-			outputs[OUT_BASS_GATE_OUTPUT].setVoltage( bassGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ? CV_MAX10 : 0.0 ); 
+		if (fBm_cv_smooth)
+			processfBmCV();
 
-			float bassVolumeLevel=theMeanderState.theBassParms.volume;
-			if (theMeanderState.theBassParms.accent)
-			{
-				if (theMeanderState.theBassParms.note_accented)
-					bassVolumeLevel=theMeanderState.theBassParms.volume;
-				else
-					bassVolumeLevel=0.5*theMeanderState.theBassParms.volume;
-				bassVolumeLevel=clamp(bassVolumeLevel, 0.0f, 10.f); 
+		// end the gate if pulse timer has expired.  Only outputs that change on this sample are written, except
+		// that the note gates follow their volume while they are high.
 
-			}
-			outputs[OUT_BASS_VOLUME_OUTPUT].setVoltage(bassVolumeLevel);
-		}
-		else  // non-standard volume over gate voltages
+		uint32_t gatesToUpdate=gates.process() | (gates.high_mask & ((1u<<GATE_HARMONY)|(1u<<GATE_MELODY)|(1u<<GATE_BASS)));
+		while (gatesToUpdate)
 		{
-			float harmonyGateLevel=theMeanderState.theHarmonyParms.volume; 
-			harmonyGateLevel=clamp(harmonyGateLevel, 2.1f, 10.f);  // don't let gate on level drop below 2.0v so it will trigger ADSR etc.
-			outputs[OUT_HARMONY_GATE_OUTPUT].setVoltage( harmonyGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ? harmonyGateLevel : 0.0 ); 
-
-			float melodyGateLevel=theMeanderState.theMelodyParms.volume; 
-			melodyGateLevel=clamp(melodyGateLevel, 2.1f, 10.f);   // don't let gate on level drop below 2.0v so it will trigger ADSR etc.
-			outputs[OUT_MELODY_GATE_OUTPUT].setVoltage( melodyGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ? melodyGateLevel : 0.0 ); 
-
-			float bassGateLevel=theMeanderState.theBassParms.volume;
-
-			if (theMeanderState.theBassParms.accent)
-			{
-				if (!theMeanderState.theBassParms.note_accented)
-					bassGateLevel*=.8;
-			}
-
-			bassGateLevel=clamp(bassGateLevel, 2.1f, 10.f); // don't let gate on level drop below 2.0v so it will trigger ADSR etc.
-			outputs[OUT_BASS_GATE_OUTPUT].setVoltage( bassGatePulse.process( 1.0 / APP->engine->getSampleRate() ) ?bassGateLevel : 0.0 ); 
+			int gate=__builtin_ctz(gatesToUpdate);
+			gatesToUpdate&=gatesToUpdate-1;
+			outputs[gateOutputs[gate]].setVoltage(gates.isHigh(gate) ? gateLevel(gate) : 0.0f);
 		}
-				
-				
-		outputs[OUT_CLOCK_BAR_OUTPUT].setVoltage((pulse1ts ? 10.0f : 0.0f));     // barts  
-		outputs[OUT_CLOCK_BEAT_OUTPUT].setVoltage((pulse4ts ? 10.0f : 0.0f));    // 4ts
-		outputs[OUT_CLOCK_BEATX2_OUTPUT].setVoltage((pulse8ts ? 10.0f : 0.0f));  // 8ts
-		outputs[OUT_CLOCK_BEATX4_OUTPUT].setVoltage((pulse16ts ? 10.0f : 0.0f)); // 16ts
-		outputs[OUT_CLOCK_BEATX8_OUTPUT].setVoltage((pulse32ts ? 10.0f : 0.0f)); // 32ts
 
 	        
+		uint64_t togglesStart=profiler.begin();
 		if (HarmonyEnableToggle.process(params[BUTTON_ENABLE_HARMONY_PARAM].getValue())) 
 		{
 			theMeanderState.theHarmonyParms.enabled = !theMeanderState.theHarmonyParms.enabled;
@@ -2012,6 +937,7 @@ struct Meander : Module
 				CircleStepStates[current_circle_position] = !CircleStepStates[current_circle_position];
 				lights[LIGHT_LEDBUTTON_CIRCLESTEP_1+current_circle_position].setBrightness(CircleStepStates[current_circle_position] ? 1.0f : 0.0f);	
 			
+				finishGeneratingTick();
 				userPlaysCirclePositionHarmony(current_circle_position, theMeanderState.theHarmonyParms.target_octave); 
 										
 				theMeanderState.userControllingHarmonyFromCircle=true;
@@ -2020,35 +946,27 @@ struct Meander : Module
 			
 			
 				//find this in circle
-				
-				for (int j=0; j<7; ++j) 
+				int theDegree=circle_position_degree[current_circle_position];
+				if (doDebug) DEBUG("harmony step edit-pt4 theDegree=%d", theDegree);
+				if ((theDegree>=1)&&(theDegree<=7))
 				{
-					if  (theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].CircleIndex==current_circle_position)
+					if (theMeanderState.theHarmonyParms.pending_step_edit)
 					{
-						int theDegree=theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].Degree;
-						if (doDebug) DEBUG("harmony step edit-pt4 theDegree=%d", theDegree);
-						if ((theDegree>=1)&&(theDegree<=7))
+						if (doDebug) DEBUG("harmony step edit-pt5 theMeanderState.theHarmonyParms.pending_step_edit=%d", theMeanderState.theHarmonyParms.pending_step_edit);
+						if (doDebug) DEBUG("harmony step edit-pt6 theDegree=%d found", theDegree);
+						theHarmonyPreset.harmony_steps[theMeanderState.theHarmonyParms.pending_step_edit-BUTTON_HARMONY_SETSTEP_1_PARAM]=theDegree;
+						//
+						strcpy(theHarmonyPreset.harmony_degrees_desc,"");
+						for (int k=0;k<theHarmonyPreset.num_harmony_steps;++k)
 						{
-							if (theMeanderState.theHarmonyParms.pending_step_edit)
-							{
-								if (doDebug) DEBUG("harmony step edit-pt5 theMeanderState.theHarmonyParms.pending_step_edit=%d", theMeanderState.theHarmonyParms.pending_step_edit);
-								if (doDebug) DEBUG("harmony step edit-pt6 theDegree=%d found", theDegree);
-								theHarmonyTypes[harmony_type].harmony_steps[theMeanderState.theHarmonyParms.pending_step_edit-BUTTON_HARMONY_SETSTEP_1_PARAM]=theDegree;
-								//
-								strcpy(theHarmonyTypes[harmony_type].harmony_degrees_desc,"");
-								for (int k=0;k<theHarmonyTypes[harmony_type].num_harmony_steps;++k)
-								{
-									strcat(theHarmonyTypes[harmony_type].harmony_degrees_desc,circle_of_fifths_arabic_degrees[theHarmonyTypes[harmony_type].harmony_steps[k]]);  
-									strcat(theHarmonyTypes[harmony_type].harmony_degrees_desc," ");
-								}
-								//
-								copyHarmonyTypeToActiveHarmonyType(harmony_type);
-								setup_harmony();
-							}
+							strcat(theHarmonyPreset.harmony_degrees_desc,circle_of_fifths_arabic_degrees[theHarmonyPreset.harmony_steps[k]]);  
+							strcat(theHarmonyPreset.harmony_degrees_desc," ");
 						}
-						break;
+						//
+						copyHarmonyTypeToActiveHarmonyType(harmony_type);
+						setup_harmony();
 					}
-				} 
+				}
 			}
 		}
 			
@@ -2068,15 +986,8 @@ struct Meander : Module
 						int degreeStep=(theActiveHarmonyType.harmony_steps[selectedStep])%8;  
 						
 						//find this in semicircle
-						for (int j=0; j<7; ++j)
-						{
-							if  (theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].Degree==degreeStep)
-							{
-								current_circle_position = theCircleOf5ths.theDegreeSemiCircle.degreeElements[j].CircleIndex; 
-								if (doDebug) DEBUG("harmony step edit-pt2 current_circle_position=%d", current_circle_position);
-								break;
-							}
-						}
+						current_circle_position = degree_circle_position[degreeStep]; 
+						if (doDebug) DEBUG("harmony step edit-pt2 current_circle_position=%d", current_circle_position);
 					}
 
 					
@@ -2102,6 +1013,7 @@ struct Meander : Module
 				}
 			} 
 		}
+		profiler.end(PROFILE_TOGGLES, togglesStart);
 
 		float fvalue=0;
         float circleDegree=0;  // for harmony
@@ -2251,6 +1163,7 @@ struct Meander : Module
 			
         	if ((degreeChanged)&&(!skipStep))
 			{
+				finishGeneratingTick();
 				if (theMeanderState.circleDegree<1)
 					theMeanderState.circleDegree=1;
 				if (theMeanderState.circleDegree>7)
@@ -2260,27 +1173,13 @@ struct Meander : Module
 				if (doDebug) DEBUG("IN_HARMONY_CIRCLE_DEGREE_EXT_CV=%d", (int)theMeanderState.circleDegree);
 			//	DEBUG("IN_HARMONY_CIRCLE_DEGREE_EXT_CV=%d", (int)theMeanderState.circleDegree);
 
-				int step=1;  // default if not found below
-				for (int i=0; i<MAX_STEPS; ++i)
-				{
-					if (theActiveHarmonyType.harmony_steps[i]==theMeanderState.circleDegree)
-					{
-						step=i;
-						break;
-					}
-				}
+				int theCirclePosition=degree_circle_position[theMeanderState.circleDegree];
 
-				theMeanderState.last_harmony_step=step;
+				int step=circle_position_step[theCirclePosition];
+				if (step<0)
+					step=1;  // default if not found
 
-				int theCirclePosition=0;
-				for (int i=0; i<7; ++i)
-				{
-					if (theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].Degree==theMeanderState.circleDegree)
-					{
-						theCirclePosition=theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].CircleIndex;
-						break;
-					}
-				}
+				theMeanderState.last_harmony_step=step;
 
 				last_circle_position=theCirclePosition;
 			
@@ -2314,8 +1213,7 @@ struct Meander : Module
 			
 		if (lowFreqClock.process())
 		{
-			if (!instanceRunning)
-				return;
+			uint64_t scanStart=profiler.begin();
 			// check controls for changes
 		
 			if ((fvalue=std::round(params[CONTROL_TEMPOBPM_PARAM].getValue()))!=tempo)
@@ -2629,8 +1527,8 @@ struct Meander : Module
 								if (fvalue>=0.01)
 								{
 									float ratio=(fvalue/10.0);
-									float newValue=1.+ (ratio*(MAX_AVAILABLE_HARMONY_PRESETS-1));
-									newValue=clamp(newValue, 1., (float)MAX_AVAILABLE_HARMONY_PRESETS);
+									float newValue=1.+ (ratio*(numHarmonyPresets()-1));
+									newValue=clamp(newValue, 1., (float)numHarmonyPresets());
 									if ((int)newValue!=harmony_type)
 									{
 										if (doDebug) DEBUG("getVoltage harmony type=%d", (int)newValue);
@@ -2815,6 +1713,7 @@ struct Meander : Module
 																	
 										if (scaleDegree>0)
 										{
+											finishGeneratingTick();
 											userPlaysScaleDegreeMelody(scaleDegree, octave+theMeanderState.theMelodyParms.target_octave); 
 											theMeanderState.theArpParms.note_count=0; 
 										}
@@ -3583,16 +2482,19 @@ struct Meander : Module
 
 			// **************************
 
+			if (harmonyPresetBankChanged)
+			{
+				harmonyPresetBank=harmonyPresetBankChanged;
+				harmonyPresetBankChanged=nullptr;
+				harmonyPresetChanged=clamp(harmony_type, 1, numHarmonyPresets());  // reload the preset, even if the number is unchanged
+			}
+
 			if (harmonyPresetChanged)
 			{
-				harmony_type=harmonyPresetChanged;
-				copyHarmonyTypeToActiveHarmonyType(harmony_type);
+				setHarmonyPreset(harmonyPresetChanged);
 				harmonyPresetChanged=0;
-				circleChanged=true;  // trigger off reconstruction and setup
-				init_harmony(); // reinitialize in case user has changed harmony parms
-				setup_harmony();  // calculate harmony notes
 				params[CONTROL_HARMONYPRESETS_PARAM].setValue(harmony_type);
-				params[CONTROL_HARMONY_STEPS_PARAM].setValue(theHarmonyTypes[harmony_type].num_harmony_steps);
+				params[CONTROL_HARMONY_STEPS_PARAM].setValue(theHarmonyPreset.num_harmony_steps);
 				time_sig_changed=true;  // forces a reset so things start over
 			//	AuditHarmonyData(2);
 			}
@@ -3600,35 +2502,8 @@ struct Meander : Module
 			// reconstruct initially and when dirty
 			if (circleChanged)  
 			{	
-				if (doDebug) DEBUG("circleChanged");	
-				
-				notate_mode_as_signature_root_key=((root_key-(mode_natural_roots[mode_root_key_signature_offset[mode]]))+12)%12;
-				if (doDebug) DEBUG("notate_mode_as_signature_root_key=%d", notate_mode_as_signature_root_key);
-				
-				if ((notate_mode_as_signature_root_key==1)   // Db
-				  ||(notate_mode_as_signature_root_key==3)   // Eb
-				  ||(notate_mode_as_signature_root_key==5)   // F
-				  ||(notate_mode_as_signature_root_key==8)   // Ab
-				  ||(notate_mode_as_signature_root_key==10)) // Bb
-				{
-					for (int i=0; i<12; ++i)
-						strcpy(note_desig[i], note_desig_flats[i]);
-				}
-				else
-				{
-					for (int i=0; i<12; ++i)
-						strcpy(note_desig[i], note_desig_sharps[i]);
-				}
-
-				ConstructCircle5ths(circle_root_key, mode);
-				ConstructDegreesSemicircle(circle_root_key, mode); //int circleroot_key, int mode)
-				init_notes();  // depends on mode and root_key			
-				init_harmony();  // sets up original progressions
-				AuditHarmonyData(3);
-				setup_harmony();  // calculate harmony notes
-				params[CONTROL_HARMONY_STEPS_PARAM].setValue(theHarmonyTypes[harmony_type].num_harmony_steps);
-				AuditHarmonyData(3);
-				circleChanged=false;
+				rebuildCircle();
+				params[CONTROL_HARMONY_STEPS_PARAM].setValue(theHarmonyPreset.num_harmony_steps);
 			}
 
 			// send Poly External Scale to output  // using Aria standard
@@ -3647,38 +2522,23 @@ struct Meander : Module
 				else
 					outputs[OUT_EXT_POLY_SCALE_OUTPUT].setVoltage(8.0,(int)note);  // (scale note, channel) 
 			}
-			
+			profiler.end(PROFILE_CONTROL_SCAN, scanStart);
 		}	
 
 		if (sec1Clock.process())
 		{
 		}
+		profiler.end(PROFILE_PROCESS, profileStart);
 		
 		 	     
 	}  // end module process()
 
-	~Meander() 
-	{
-		
-		if (instanceRunning) {
-		//	 Release ownership of singleton
-			owned = false;
-		}
-	}
-
-
 	Meander() 
 	{
 
 		if (doDebug) DEBUG("");  // clear debug log file
 
-				
-		if (!owned) {
-			// Take ownership of singleton
-			owned = true;
-		    instanceRunning = true;
- 		}
-			
+
 		time_t rawtime; 
   		time( &rawtime );
    		
@@ -3688,8 +2548,9 @@ struct Meander : Module
 		lightDivider.setDivision(512);  // every 86 samples, 2ms
 				   		
 		
-		initPerlin();
-		MeanderMusicStructuresInitialize();  // sets global globalsInitialized=true
+		MeanderMusicStructuresInitialize();  // sets this instance's globalsInitialized=true
+		random_seed=((uint64_t)random::u32() << 32) | random::u32();  // new seed per instance, saved with the patch
+		setNoiseSeed(random_seed);  // and its own noise permutation
 
 			
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -3736,7 +2597,7 @@ struct Meander : Module
 		configParam(BUTTON_ENABLE_HARMONY_ALL7THS_PARAM, 0.f, 1.f, 0.f, "7ths");
 		configParam(BUTTON_ENABLE_HARMONY_V7THS_PARAM, 0.f, 1.f, 0.f, "V 7ths");
 		configParam(BUTTON_ENABLE_HARMONY_STACCATO_PARAM, 0.f, 1.f, 0.f, "Staccato");
-		configParam(CONTROL_HARMONYPRESETS_PARAM, 1.0f, (float)MAX_AVAILABLE_HARMONY_PRESETS, 1.0f, "Progression Preset");
+		configParam(CONTROL_HARMONYPRESETS_PARAM, 1.0f, (float)numHarmonyPresets(), 1.0f, "Progression Preset");
 
 		configParam(BUTTON_ENABLE_ARP_PARAM, 0.f, 1.f, 0.f, "Enable");
 		configParam(BUTTON_ENABLE_ARP_CHORDAL_PARAM, 0.f, 1.f, 1.f, "Chordal Notes");
@@ -3804,6 +2665,7 @@ struct Meander : Module
  
 struct RootKeySelectLineDisplay : LightWidget {
 	
+	MeanderEngine* engine=&thePreviewEngine;  // the module's engine once one exists
 	int frame = 0;
 	std::shared_ptr<Font> font;
 
@@ -3826,7 +2688,7 @@ struct RootKeySelectLineDisplay : LightWidget {
 		nvgStrokeColor(ctx.vg, borderColor);
 		nvgStroke(ctx.vg);
 	
-		if (globalsInitialized)  // global fully initialized if Module!=NULL
+		if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 		{
 			nvgFontSize(ctx.vg,18 );
 			nvgFontFaceId(ctx.vg, font->handle);
@@ -3836,7 +2698,7 @@ struct RootKeySelectLineDisplay : LightWidget {
 
 			char text[128];
 			
-			snprintf(text, sizeof(text), "%s", root_key_names[root_key]);
+			snprintf(text, sizeof(text), "%s", root_key_names[engine->root_key]);
 			nvgText(ctx.vg, pos.x, pos.y, text, NULL);
 		}
 	}
@@ -3845,6 +2707,7 @@ struct RootKeySelectLineDisplay : LightWidget {
 
 struct ScaleSelectLineDisplay : LightWidget {
 	
+	MeanderEngine* engine=&thePreviewEngine;  // the module's engine once one exists
 	int frame = 0;
 	std::shared_ptr<Font> font;
 
@@ -3867,7 +2730,7 @@ struct ScaleSelectLineDisplay : LightWidget {
 		nvgStrokeColor(ctx.vg, borderColor);
 		nvgStroke(ctx.vg);
 	 
-	 	if (globalsInitialized)  // global fully initialized if Module!=NULL
+	 	if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 		{
 			nvgFontSize(ctx.vg, 16);
 			nvgFontFaceId(ctx.vg, font->handle);
@@ -3877,15 +2740,15 @@ struct ScaleSelectLineDisplay : LightWidget {
 		
 			char text[128];
 			
-			snprintf(text, sizeof(text), "%s", mode_names[mode]);
+			snprintf(text, sizeof(text), "%s", mode_names[engine->mode]);
 			nvgText(ctx.vg, pos.x, pos.y, text, NULL);
 
 			// add on the scale notes display out of this box
 			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0x0, 0x0, 0xFF));
 			strcpy(text,"");
-			for (int i=0;i<mode_step_intervals[mode][0];++i)
+			for (int i=0;i<mode_step_intervals[engine->mode][0];++i)
 			{
-				strcat(text,note_desig[notes[i]%MAX_NOTES]);  
+				strcat(text,engine->note_desig[engine->notes[i]%MAX_NOTES]);  
 				strcat(text," ");
 			}
 			
@@ -4063,10 +2926,12 @@ struct MeanderWidget : ModuleWidget
 		rack::math::Rect*  ParameterRectLocal;   // warning, don't exceed the dimension
 		rack::math::Rect*  InportRectLocal; 	 // warning, don't exceed the dimension
 		rack::math::Rect*  OutportRectLocal;     // warning, don't exceed the dimension
+		MeanderEngine* engine=&thePreviewEngine;  // the module's engine once one exists
 						
 		int frame = 0;
 		std::shared_ptr<Font> textfont;
 		std::shared_ptr<Font> musicfont; 
+		MeanderFrameProfiler frameProfiler;
 
 		CircleOf5thsDisplay()  
 		{
@@ -4085,7 +2950,7 @@ struct MeanderWidget : ModuleWidget
 			{
 					// draw root_key annulus sector
 
-					int relativeCirclePosition = ((i - circle_root_key + mode)+12) % MAX_CIRCLE_STATIONS;
+					int relativeCirclePosition = ((i - engine->circle_root_key + engine->mode)+12) % MAX_CIRCLE_STATIONS;
 					if (doDebug) DEBUG("\nrelativeCirclePosition-1=%d", relativeCirclePosition);
 
 					nvgBeginPath(args.vg);
@@ -4105,10 +2970,10 @@ struct MeanderWidget : ModuleWidget
 					else	
 						nvgFillColor(args.vg, nvgRGBA(0x20, 0x20, 0x20, (int)opacity));  // grayish
 				
-					nvgArc(args.vg,theCircleOf5ths.CircleCenter.x,theCircleOf5ths.CircleCenter.y,theCircleOf5ths.MiddleCircleRadius,theCircleOf5ths.Circle5ths[i].startDegree,theCircleOf5ths.Circle5ths[i].endDegree,NVG_CW);
-					nvgLineTo(args.vg,theCircleOf5ths.Circle5ths[i].pt3.x,theCircleOf5ths.Circle5ths[i].pt3.y);
-					nvgArc(args.vg,theCircleOf5ths.CircleCenter.x,theCircleOf5ths.CircleCenter.y,theCircleOf5ths.InnerCircleRadius,theCircleOf5ths.Circle5ths[i].endDegree,theCircleOf5ths.Circle5ths[i].startDegree,NVG_CCW);
-					nvgLineTo(args.vg,theCircleOf5ths.Circle5ths[i].pt2.x,theCircleOf5ths.Circle5ths[i].pt2.y);
+					nvgArc(args.vg,engine->theCircleOf5ths.CircleCenter.x,engine->theCircleOf5ths.CircleCenter.y,engine->theCircleOf5ths.MiddleCircleRadius,engine->theCircleOf5ths.Circle5ths[i].startDegree,engine->theCircleOf5ths.Circle5ths[i].endDegree,NVG_CW);
+					nvgLineTo(args.vg,engine->theCircleOf5ths.Circle5ths[i].pt3.x,engine->theCircleOf5ths.Circle5ths[i].pt3.y);
+					nvgArc(args.vg,engine->theCircleOf5ths.CircleCenter.x,engine->theCircleOf5ths.CircleCenter.y,engine->theCircleOf5ths.InnerCircleRadius,engine->theCircleOf5ths.Circle5ths[i].endDegree,engine->theCircleOf5ths.Circle5ths[i].startDegree,NVG_CCW);
+					nvgLineTo(args.vg,engine->theCircleOf5ths.Circle5ths[i].pt2.x,engine->theCircleOf5ths.Circle5ths[i].pt2.y);
 								
 					nvgFill(args.vg);
 					nvgStroke(args.vg);
@@ -4122,8 +2987,8 @@ struct MeanderWidget : ModuleWidget
 					nvgFillColor(args.vg, nvgRGBA(0x00, 0x00, 0x00, 0xff));
 					char text[32];
 					snprintf(text, sizeof(text), "%s", CircleNoteNames[i]);
-					if (doDebug) DEBUG("radialDirection= %.3f %.3f", theCircleOf5ths.Circle5ths[i].radialDirection.x, theCircleOf5ths.Circle5ths[i].radialDirection.y);
-					Vec TextPosition=theCircleOf5ths.CircleCenter.plus(theCircleOf5ths.Circle5ths[i].radialDirection.mult(theCircleOf5ths.MiddleCircleRadius*.93f));
+					if (doDebug) DEBUG("radialDirection= %.3f %.3f", engine->theCircleOf5ths.Circle5ths[i].radialDirection.x, engine->theCircleOf5ths.Circle5ths[i].radialDirection.y);
+					Vec TextPosition=engine->theCircleOf5ths.CircleCenter.plus(engine->theCircleOf5ths.Circle5ths[i].radialDirection.mult(engine->theCircleOf5ths.MiddleCircleRadius*.93f));
 					nvgTextAlign(args.vg,NVG_ALIGN_CENTER|NVG_ALIGN_MIDDLE);
 					nvgText(args.vg, TextPosition.x, TextPosition.y, text, NULL);
 
@@ -4145,7 +3010,7 @@ struct MeanderWidget : ModuleWidget
 					nvgStrokeColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xff));
 					nvgStrokeWidth(args.vg, 2);
 
-					chord_type=theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].chordType;
+					chord_type=engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].chordType;
 
 					if (false)
 					{
@@ -4161,10 +3026,10 @@ struct MeanderWidget : ModuleWidget
 					else
 						nvgFillColor(args.vg, nvgRGBA(0xf9, 0xf9, 0x20, (int)opacity));  // yellowish
 						
-					nvgArc(args.vg,theCircleOf5ths.CircleCenter.x,theCircleOf5ths.CircleCenter.y,theCircleOf5ths.OuterCircleRadius,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].startDegree,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].endDegree,NVG_CW);
-					nvgLineTo(args.vg,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].pt3.x,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].pt3.y);
-					nvgArc(args.vg,theCircleOf5ths.CircleCenter.x,theCircleOf5ths.CircleCenter.y,theCircleOf5ths.MiddleCircleRadius,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].endDegree,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].startDegree,NVG_CCW);
-					nvgLineTo(args.vg,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].pt2.x,theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].pt2.y);
+					nvgArc(args.vg,engine->theCircleOf5ths.CircleCenter.x,engine->theCircleOf5ths.CircleCenter.y,engine->theCircleOf5ths.OuterCircleRadius,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].startDegree,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].endDegree,NVG_CW);
+					nvgLineTo(args.vg,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].pt3.x,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].pt3.y);
+					nvgArc(args.vg,engine->theCircleOf5ths.CircleCenter.x,engine->theCircleOf5ths.CircleCenter.y,engine->theCircleOf5ths.MiddleCircleRadius,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].endDegree,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].startDegree,NVG_CCW);
+					nvgLineTo(args.vg,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].pt2.x,engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].pt2.y);
 					
 					nvgFill(args.vg);
 					nvgStroke(args.vg);
@@ -4180,13 +3045,13 @@ struct MeanderWidget : ModuleWidget
 				
 					
 					if (chord_type==0) // major
-						snprintf(text, sizeof(text), "%s", circle_of_fifths_degrees_UC[(i - theCircleOf5ths.theDegreeSemiCircle.RootKeyCircle5thsPosition+7)%7]);
+						snprintf(text, sizeof(text), "%s", circle_of_fifths_degrees_UC[(i - engine->theCircleOf5ths.theDegreeSemiCircle->RootKeyCircle5thsPosition+7)%7]);
 						else
 					if ((chord_type==1)||(chord_type==6)) // minor or diminished
-						snprintf(text, sizeof(text), "%s", circle_of_fifths_degrees_LC[(i - theCircleOf5ths.theDegreeSemiCircle.RootKeyCircle5thsPosition+7)%7]);
+						snprintf(text, sizeof(text), "%s", circle_of_fifths_degrees_LC[(i - engine->theCircleOf5ths.theDegreeSemiCircle->RootKeyCircle5thsPosition+7)%7]);
 					
-					if (doDebug) DEBUG("radialDirection= %.3f %.3f", theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].radialDirection.x, theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].radialDirection.y);
-					Vec TextPosition=theCircleOf5ths.CircleCenter.plus(theCircleOf5ths.theDegreeSemiCircle.degreeElements[i].radialDirection.mult(theCircleOf5ths.OuterCircleRadius*.92f));
+					if (doDebug) DEBUG("radialDirection= %.3f %.3f", engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].radialDirection.x, engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].radialDirection.y);
+					Vec TextPosition=engine->theCircleOf5ths.CircleCenter.plus(engine->theCircleOf5ths.theDegreeSemiCircle->degreeElements[i].radialDirection.mult(engine->theCircleOf5ths.OuterCircleRadius*.92f));
 					nvgTextAlign(args.vg,NVG_ALIGN_CENTER|NVG_ALIGN_MIDDLE);
 					nvgText(args.vg, TextPosition.x, TextPosition.y, text, NULL);
 					if (i==6) // draw diminished
@@ -4515,22 +3380,22 @@ struct MeanderWidget : ModuleWidget
 				snprintf(labeltext, sizeof(labeltext), "%s", "Harmony Enable");
 				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_HARMONY_PARAM].pos, labeltext, 0, -1);
 				snprintf(labeltext, sizeof(labeltext), "%s", "Volume (0-10.0)");
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_VOLUME_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.volume, 1);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_VOLUME_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.volume, 1);
 						    
-				snprintf(labeltext, sizeof(labeltext), "Steps (%d-%d)", theActiveHarmonyType.min_steps, theActiveHarmonyType.max_steps);
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_STEPS_PARAM].pos, labeltext, (float)theActiveHarmonyType.num_harmony_steps, 0);
+				snprintf(labeltext, sizeof(labeltext), "Steps (%d-%d)", engine->theActiveHarmonyType.min_steps, engine->theActiveHarmonyType.max_steps);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_STEPS_PARAM].pos, labeltext, (float)engine->theActiveHarmonyType.num_harmony_steps, 0);
 				
 				snprintf(labeltext, sizeof(labeltext), "%s", "Target Oct.(1-6)");
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_TARGETOCTAVE_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.target_octave, 0);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_TARGETOCTAVE_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.target_octave, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Variability (0-1)");
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_ALPHA_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.alpha, 2);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_ALPHA_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.alpha, 2);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "+-Octave Range (0-3)");
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_RANGE_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.note_octave_range, 2);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_RANGE_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.note_octave_range, 2);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Notes on 1/");
-				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_DIVISOR_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.note_length_divisor, 0);
+				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_DIVISOR_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.note_length_divisor, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "~Nice 7ths");
 				drawHarmonyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_HARMONY_ALL7THS_PARAM].pos, labeltext, 0, -1);
@@ -4559,14 +3424,14 @@ struct MeanderWidget : ModuleWidget
 				nvgStroke(args.vg);
 
 				
-				if (globalsInitialized)  // global fully initialized if Module!=NULL
+				if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 				{
 					nvgBeginPath(args.vg);
 					nvgFontSize(args.vg, 14);
 					nvgFontFaceId(args.vg, textfont->handle);
 					nvgTextLetterSpacing(args.vg, -1);
 					nvgFillColor(args.vg, nvgRGBA(0xFF, 0xFF, 0x2C, 0xFF));
-					snprintf(text, sizeof(text), "#%d:  %s", harmony_type, theActiveHarmonyType.harmony_type_desc);
+					snprintf(text, sizeof(text), "#%d:  %s", engine->harmony_type, engine->theActiveHarmonyType.harmony_type_desc);
 					nvgText(args.vg, pos.x+5, pos.y+10, text, NULL);
 				}
 				pos = pos.plus(Vec(0,20));
@@ -4580,12 +3445,12 @@ struct MeanderWidget : ModuleWidget
 				nvgFill(args.vg);
 				nvgStroke(args.vg);
 
-				if (globalsInitialized)  // global fully initialized if Module!=NULL
+				if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 				{
 					nvgBeginPath(args.vg);
 					nvgFontSize(args.vg, 12);
 					nvgFillColor(args.vg, nvgRGBA(0xFF, 0xFF, 0x2C, 0xFF));
-					snprintf(text, sizeof(text), "%s           ",  theActiveHarmonyType.harmony_degrees_desc);
+					snprintf(text, sizeof(text), "%s           ",  engine->theActiveHarmonyType.harmony_degrees_desc);
 					nvgText(args.vg, pos.x+5, pos.y+10, text, NULL);
 				}
 								
@@ -4634,22 +3499,22 @@ struct MeanderWidget : ModuleWidget
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_MELODY_SCALER_PARAM].pos, labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Volume (0-10.0)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_VOLUME_PARAM].pos, labeltext, theMeanderState.theMelodyParms.volume, 1);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_VOLUME_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.volume, 1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Hold tied");
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_MELODY_DESTUTTER_PARAM].pos, labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Notes on 1/");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_NOTE_LENGTH_DIVISOR_PARAM].pos, labeltext, theMeanderState.theMelodyParms.note_length_divisor, 0);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_NOTE_LENGTH_DIVISOR_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.note_length_divisor, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Target Oct.(1-6)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_TARGETOCTAVE_PARAM].pos, labeltext, theMeanderState.theMelodyParms.target_octave, 0);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_TARGETOCTAVE_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.target_octave, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Variability (0-1)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_ALPHA_PARAM].pos, labeltext, theMeanderState.theMelodyParms.alpha, 2);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_ALPHA_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.alpha, 2);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "+-Octave Range (0-3)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_RANGE_PARAM].pos, labeltext, theMeanderState.theMelodyParms.note_octave_range, 2);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_RANGE_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.note_octave_range, 2);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Staccato");
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_MELODY_STACCATO_PARAM].pos, labeltext, 0, -1);
@@ -4669,13 +3534,13 @@ struct MeanderWidget : ModuleWidget
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_ARP_PARAM].pos, labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Count (0-31)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_COUNT_PARAM].pos, labeltext, theMeanderState.theArpParms.count, 0);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_COUNT_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.count, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Notes on 1/");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_INCREMENT_PARAM].pos, labeltext, theMeanderState.theArpParms.note_length_divisor, 0);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_INCREMENT_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.note_length_divisor, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Decay (0-1.0)");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_DECAY_PARAM].pos, labeltext, theMeanderState.theArpParms.decay, 2);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_DECAY_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.decay, 2);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Chordal");
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_ARP_CHORDAL_PARAM].pos, labeltext, 0, -1);
@@ -4684,7 +3549,7 @@ struct MeanderWidget : ModuleWidget
 				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_ARP_SCALER_PARAM].pos, labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Pattern (-3-+3");
-				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_PATTERN_PARAM].pos, labeltext, theMeanderState.theArpParms.pattern, -1);
+				drawMelodyControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_PATTERN_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.pattern, -1);
 
 				pos =ParameterRectLocal[Meander::CONTROL_ARP_PATTERN_PARAM].pos.plus(Vec(102,0));
 							
@@ -4699,26 +3564,26 @@ struct MeanderWidget : ModuleWidget
 
 				nvgFontSize(args.vg, 17);
 				nvgFillColor(args.vg, nvgRGBA(0xFF, 0xFF, 0x2C, 0xFF));
-				if (theMeanderState.theArpParms.pattern==0)
-					snprintf(text, sizeof(text), "%d: 0-echo", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==0)
+					snprintf(text, sizeof(text), "%d: 0-echo", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==1)
-					snprintf(text, sizeof(text), "%d: +1", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==1)
+					snprintf(text, sizeof(text), "%d: +1", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==2)
-					snprintf(text, sizeof(text), "%d: +1,-1", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==2)
+					snprintf(text, sizeof(text), "%d: +1,-1", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==3)
-					snprintf(text, sizeof(text), "%d: +2", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==3)
+					snprintf(text, sizeof(text), "%d: +2", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==-1)
-					snprintf(text, sizeof(text), "%d: -1", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==-1)
+					snprintf(text, sizeof(text), "%d: -1", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==-2)
-					snprintf(text, sizeof(text), "%d: -1,+1", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==-2)
+					snprintf(text, sizeof(text), "%d: -1,+1", engine->theMeanderState.theArpParms.pattern);
 				else
-				if (theMeanderState.theArpParms.pattern==-3)
-					snprintf(text, sizeof(text), "%d: -2", theMeanderState.theArpParms.pattern);
+				if (engine->theMeanderState.theArpParms.pattern==-3)
+					snprintf(text, sizeof(text), "%d: -2", engine->theMeanderState.theArpParms.pattern);
 				else
 					snprintf(text, sizeof(text), "%s", "      ");  // since text is used above, needs to be cleared in fallthrough case
 				
@@ -4755,28 +3620,28 @@ struct MeanderWidget : ModuleWidget
 				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_BASS_PARAM].pos, labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Volume (0-10)");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_VOLUME_PARAM].pos, labeltext, theMeanderState.theBassParms.volume, 1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_VOLUME_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.volume, 1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Target Oct.(1-6)");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_TARGETOCTAVE_PARAM].pos, labeltext, theMeanderState.theBassParms.target_octave, 0);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_TARGETOCTAVE_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.target_octave, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Notes on 1/");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_DIVISOR_PARAM].pos, labeltext, theMeanderState.theBassParms.note_length_divisor, 0);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_BASS_DIVISOR_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.note_length_divisor, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Staccato");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_BASS_STACCATO_PARAM].pos, labeltext, theMeanderState.theBassParms.enable_staccato, -1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_ENABLE_BASS_STACCATO_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.enable_staccato, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Accent");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_ACCENT_PARAM].pos, labeltext, theMeanderState.theBassParms.accent, -1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_ACCENT_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.accent, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Syncopate");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_SYNCOPATE_PARAM].pos, labeltext, theMeanderState.theBassParms.syncopate, -1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_SYNCOPATE_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.syncopate, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Shuffle");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_SHUFFLE_PARAM].pos, labeltext, theMeanderState.theBassParms.shuffle, -1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_SHUFFLE_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.shuffle, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Octaves");
-				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_OCTAVES_PARAM].pos, labeltext, theMeanderState.theBassParms.octave_enabled, -1);
+				drawBassControlParamLine(args,ParameterRectLocal[Meander::BUTTON_BASS_OCTAVES_PARAM].pos, labeltext, engine->theMeanderState.theBassParms.octave_enabled, -1);
 
 
 
@@ -4811,31 +3676,32 @@ struct MeanderWidget : ModuleWidget
 				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_FBM_OCTAVES_PARAM].pos.plus(Vec(37,-13)), labeltext, 0, -1);
 		
 				snprintf(labeltext, sizeof(labeltext), "%s", "Octaves (1-6)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_FBM_OCTAVES_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.noctaves, 0);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_FBM_OCTAVES_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.noctaves, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Period Sec. (1-100)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_FBM_PERIOD_PARAM].pos, labeltext, theMeanderState.theHarmonyParms.period, 1);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_HARMONY_FBM_PERIOD_PARAM].pos, labeltext, engine->theMeanderState.theHarmonyParms.period, 1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Melody");
 				drawBassControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_FBM_OCTAVES_PARAM].pos.plus(Vec(41,-13)), labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Octaves (1-6)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_FBM_OCTAVES_PARAM].pos, labeltext, theMeanderState.theMelodyParms.noctaves, 0);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_FBM_OCTAVES_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.noctaves, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Period Sec. (1-100)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_FBM_PERIOD_PARAM].pos, labeltext, theMeanderState.theMelodyParms.period, 1);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_MELODY_FBM_PERIOD_PARAM].pos, labeltext, engine->theMeanderState.theMelodyParms.period, 1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "32nds");
 				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_FBM_OCTAVES_PARAM].pos.plus(Vec(47,-13)), labeltext, 0, -1);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Octaves (1-6)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_FBM_OCTAVES_PARAM].pos, labeltext, theMeanderState.theArpParms.noctaves, 0);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_FBM_OCTAVES_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.noctaves, 0);
 
 				snprintf(labeltext, sizeof(labeltext), "%s", "Period Sec. (1-100)");
-				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_FBM_PERIOD_PARAM].pos, labeltext, theMeanderState.theArpParms.period, 1);
+				drawfBmControlParamLine(args,ParameterRectLocal[Meander::CONTROL_ARP_FBM_PERIOD_PARAM].pos, labeltext, engine->theMeanderState.theArpParms.period, 1);
 
 				
 			} 
+			frameProfiler.mark(FRAME_PARAM_LINES);
 
 			if (true)  // draw rounded corner rects  for input jacks border 
 			{
@@ -5019,7 +3885,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=0; i<7; ++i)
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==1)
 				{
 					vertical_offset1=root_key_sharps_vertical_display_offset[num_sharps1];
 					pos=Vec(beginEdge+20+(num_sharps1*5), beginTop+24+(vertical_offset1*yHalfLineSpacing));
@@ -5035,7 +3901,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=6; i>=0; --i)
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==-1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==-1)
 				{
 					vertical_offset1=root_key_flats_vertical_display_offset[num_flats1];
 					pos=Vec(beginEdge+20+(num_flats1*5), beginTop+24+(vertical_offset1*yHalfLineSpacing));
@@ -5131,22 +3997,22 @@ struct MeanderWidget : ModuleWidget
 			
 			nvgFontSize(args.vg, 40);
 			pos=Vec(beginEdge+53, beginTop+33);
-			snprintf(text, sizeof(text), "%d",time_sig_top);
+			snprintf(text, sizeof(text), "%d",engine->time_sig_top);
 			nvgText(args.vg, pos.x, pos.y, text, NULL);
 
 			nvgFontSize(args.vg, 40);
 			pos=Vec(beginEdge+53, beginTop+69);
-			snprintf(text, sizeof(text), "%d",time_sig_top);  
+			snprintf(text, sizeof(text), "%d",engine->time_sig_top);  
 			nvgText(args.vg, pos.x, pos.y, text, NULL);
 
 			nvgFontSize(args.vg, 40);
 			pos=Vec(beginEdge+53, beginTop+45);
-			snprintf(text, sizeof(text), "%d",time_sig_bottom);
+			snprintf(text, sizeof(text), "%d",engine->time_sig_bottom);
 			nvgText(args.vg, pos.x, pos.y, text, NULL);
 
 			nvgFontSize(args.vg, 40);
 			pos=Vec(beginEdge+53, beginTop+81);
-			snprintf(text, sizeof(text), "%d",time_sig_bottom);  
+			snprintf(text, sizeof(text), "%d",engine->time_sig_bottom);  
 			nvgText(args.vg, pos.x, pos.y, text, NULL);
 
 			// do root_key signature
@@ -5160,7 +4026,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=0; i<7; ++i)
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==1)
 				{
 					vertical_offset1=root_key_sharps_vertical_display_offset[num_sharps1];
 					pos=Vec(beginEdge+20+(num_sharps1*5), beginTop+24+(vertical_offset1*yHalfLineSpacing));
@@ -5176,7 +4042,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=6; i>=0; --i)  
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==-1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==-1)
 				{
 					vertical_offset1=root_key_flats_vertical_display_offset[num_flats1];
 					pos=Vec(beginEdge+20+(num_flats1*5), beginTop+24+(vertical_offset1*yHalfLineSpacing));
@@ -5197,7 +4063,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=0; i<7; ++i)
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==1)
 				{
 					vertical_offset1=root_key_sharps_vertical_display_offset[num_sharps1];
 					pos=Vec(beginEdge+20+(num_sharps1*5), beginTop+67+(vertical_offset1*yHalfLineSpacing));
@@ -5213,7 +4079,7 @@ struct MeanderWidget : ModuleWidget
 			for (int i=6; i>=0; --i)
 			{
 				nvgBeginPath(args.vg);
-				if (root_key_signatures_chromaticForder[notate_mode_as_signature_root_key][i]==-1)
+				if (root_key_signatures_chromaticForder[engine->notate_mode_as_signature_root_key][i]==-1)
 				{
 					vertical_offset1=root_key_flats_vertical_display_offset[num_flats1];
 					pos=Vec(beginEdge+20+(num_flats1*5), beginTop+67+(vertical_offset1*yHalfLineSpacing));
@@ -5225,41 +4091,42 @@ struct MeanderWidget : ModuleWidget
 			
 
 			//****************
+			frameProfiler.mark(FRAME_PANEL_REST);
 				
 			float display_note_position=0; 
 
-			if (globalsInitialized)  // global fully initialized if Module!=NULL
+			if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 			{
 				nvgFontSize(args.vg, 30);
 				nvgFontFaceId(args.vg, musicfont->handle);
 				nvgTextLetterSpacing(args.vg, -1);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF));
 
-				for (int i=0; ((i<bar_note_count)&&(i<256)); ++i)
+				for (int i=0; ((i<engine->bar_note_count)&&(i<256)); ++i)
 				{
-					int display_note=played_notes_circular_buffer[i].note;
-					if (doDebug) DEBUG("display_note=%d %s", display_note, note_desig[display_note%12]);
+					int display_note=engine->played_notes_circular_buffer[i].note;
+					if (doDebug) DEBUG("display_note=%d %s", display_note, engine->note_desig[display_note%12]);
 				
 					int scale_note=0;
-					if (strstr(note_desig[display_note%12],"C"))
+					if (strstr(engine->note_desig[display_note%12],"C"))
 						scale_note=0;
 					else
-					if (strstr(note_desig[display_note%12],"D"))
+					if (strstr(engine->note_desig[display_note%12],"D"))
 						scale_note=1;
 					else
-					if (strstr(note_desig[display_note%12],"E"))
+					if (strstr(engine->note_desig[display_note%12],"E"))
 						scale_note=2;
 					else
-					if (strstr(note_desig[display_note%12],"F"))
+					if (strstr(engine->note_desig[display_note%12],"F"))
 						scale_note=3;
 					else
-					if (strstr(note_desig[display_note%12],"G"))
+					if (strstr(engine->note_desig[display_note%12],"G"))
 						scale_note=4;
 					else
-					if (strstr(note_desig[display_note%12],"A"))
+					if (strstr(engine->note_desig[display_note%12],"A"))
 						scale_note=5;
 					else
-					if (strstr(note_desig[display_note%12],"B"))
+					if (strstr(engine->note_desig[display_note%12],"B"))
 						scale_note=6;
 					if (doDebug) DEBUG("scale_note=%d", scale_note%12);
 				
@@ -5270,46 +4137,46 @@ struct MeanderWidget : ModuleWidget
 					if (doDebug) DEBUG("display_note_position=%d", (int)display_note_position);
 				
 					
-					float note_x_spacing= 230.0/(32*time_sig_top/time_sig_bottom);  // experimenting with note spacing function of time_signature.  barts_count_limit is not in scope, needs to be global
-					pos=Vec(beginEdge+70+(played_notes_circular_buffer[i].time32s*note_x_spacing), beginTop+display_note_position);  
+					float note_x_spacing= 230.0/(32*engine->time_sig_top/engine->time_sig_bottom);  // experimenting with note spacing function of time_signature.  barts_count_limit is not in scope, needs to be global
+					pos=Vec(beginEdge+70+(engine->played_notes_circular_buffer[i].time32s*note_x_spacing), beginTop+display_note_position);  
 					if (true)  // color code notes in staff rendering
 					{ 
-						if (played_notes_circular_buffer[i].noteType==NOTE_TYPE_CHORD)
+						if (engine->played_notes_circular_buffer[i].noteType==NOTE_TYPE_CHORD)
 							nvgFillColor(args.vg, nvgRGBA(0xFF, 0x0, 0x0, 0xFF)); 
 						else
-						if (played_notes_circular_buffer[i].noteType==NOTE_TYPE_MELODY)
+						if (engine->played_notes_circular_buffer[i].noteType==NOTE_TYPE_MELODY)
 							nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 						else
-						if (played_notes_circular_buffer[i].noteType==NOTE_TYPE_ARP)
+						if (engine->played_notes_circular_buffer[i].noteType==NOTE_TYPE_ARP)
 							nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0xFF, 0xFF)); 
 						else
-						if (played_notes_circular_buffer[i].noteType==NOTE_TYPE_BASS)
+						if (engine->played_notes_circular_buffer[i].noteType==NOTE_TYPE_BASS)
 							nvgFillColor(args.vg, nvgRGBA(0x0, 0xFF, 0x0, 0xFF)); 
 						
 					}
 
 					
 					nvgFontSize(args.vg, 30);
-					if (played_notes_circular_buffer[i].length==1)
+					if (engine->played_notes_circular_buffer[i].length==1)
 						snprintf(text, sizeof(text), "%s", "w");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					else
-					if (played_notes_circular_buffer[i].length==2)
+					if (engine->played_notes_circular_buffer[i].length==2)
 						snprintf(text, sizeof(text), "%s", "h");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					else
-					if (played_notes_circular_buffer[i].length==4)
+					if (engine->played_notes_circular_buffer[i].length==4)
 						snprintf(text, sizeof(text), "%s", "q");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					else
-					if (played_notes_circular_buffer[i].length==8)
+					if (engine->played_notes_circular_buffer[i].length==8)
 						snprintf(text, sizeof(text), "%s", "e");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					else
-					if (played_notes_circular_buffer[i].length==16)
+					if (engine->played_notes_circular_buffer[i].length==16)
 						snprintf(text, sizeof(text), "%s", "s");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					else
-					if (played_notes_circular_buffer[i].length==32)
+					if (engine->played_notes_circular_buffer[i].length==32)
 						snprintf(text, sizeof(text), "%s", "s");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
 					nvgText(args.vg, pos.x, pos.y, text, NULL);
 
-					if (played_notes_circular_buffer[i].length==32)  // do overstrike for 1/32 symbol
+					if (engine->played_notes_circular_buffer[i].length==32)  // do overstrike for 1/32 symbol
 					{
 						nvgFontSize(args.vg, 15);
 						snprintf(text, sizeof(text), "%s", "e");  // mnemonic W=whole, h=half, q-quarter, e=eighth, s=sixteenth notes
@@ -5332,10 +4199,11 @@ struct MeanderWidget : ModuleWidget
 					} 
 				}
 			}
+			frameProfiler.mark(FRAME_STAFF_NOTES);
 			
 			//*********************
 
-			if (globalsInitialized)  // global fully initialized if Module!=NULL
+			if (engine->globalsInitialized)  // engine fully initialized if Module!=NULL
 			{
 				nvgFontSize(args.vg, 14);
 				nvgFontFaceId(args.vg, textfont->handle);
@@ -5344,16 +4212,16 @@ struct MeanderWidget : ModuleWidget
 
 				// write last melody note played 
 				pos=convertSVGtoNVG(261.4, 120.3, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theMelodyParms.last[0].note%12)], (int)(theMeanderState.theMelodyParms.last[0].note/12 ));
+				snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theMelodyParms.last[0].note%12)], (int)(engine->theMeanderState.theMelodyParms.last[0].note/12 ));
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 				nvgText(args.vg, pos.x, pos.y, text, NULL);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 
 				// write last arp note played 
-				if (theMeanderState.theArpParms.note_count>0)
+				if (engine->theMeanderState.theArpParms.note_count>0)
 				{
 					pos=convertSVGtoNVG(261.4, 120.3, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-					snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].note%12)], (int)(theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].note/12 ));
+					snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theArpParms.last[engine->theMeanderState.theArpParms.note_count].note%12)], (int)(engine->theMeanderState.theArpParms.last[engine->theMeanderState.theArpParms.note_count].note/12 ));
 					nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0xFF, 0xFF)); 
 					nvgText(args.vg, pos.x+20, pos.y+200, text, NULL);
 					nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
@@ -5361,21 +4229,21 @@ struct MeanderWidget : ModuleWidget
 				
 				// write last harmony note played 1
 				pos=convertSVGtoNVG(187.8, 119.8, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theHarmonyParms.last[0].note%12)] , theMeanderState.theHarmonyParms.last[0].note/12);
+				snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theHarmonyParms.last[0].note%12)] , engine->theMeanderState.theHarmonyParms.last[0].note/12);
 				nvgFillColor(args.vg, nvgRGBA(0xFF, 0x0, 0x0, 0xFF)); 
 				nvgText(args.vg, pos.x, pos.y, text, NULL);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 
 				// write last harmony note played 2
 				pos=convertSVGtoNVG(199.1, 119.8, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theHarmonyParms.last[1].note%12)], theMeanderState.theHarmonyParms.last[1].note/12);
+				snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theHarmonyParms.last[1].note%12)], engine->theMeanderState.theHarmonyParms.last[1].note/12);
 				nvgFillColor(args.vg, nvgRGBA(0xFF, 0x0, 0x0, 0xFF)); 
 				nvgText(args.vg, pos.x, pos.y, text, NULL);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 
 				// write last harmony note played 3
 				pos=convertSVGtoNVG(210.4, 119.8, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theHarmonyParms.last[2].note%12)], theMeanderState.theHarmonyParms.last[2].note/12);
+				snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theHarmonyParms.last[2].note%12)], engine->theMeanderState.theHarmonyParms.last[2].note/12);
 				nvgFillColor(args.vg, nvgRGBA(0xFF, 0x0, 0x0, 0xFF)); 
 				nvgText(args.vg, pos.x, pos.y, text, NULL);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
@@ -5383,8 +4251,8 @@ struct MeanderWidget : ModuleWidget
 				// write last harmony note played 4
 			
 				pos=convertSVGtoNVG(221.7, 119.8, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				if ((theMeanderState.theHarmonyParms.last_chord_type==2)||(theMeanderState.theHarmonyParms.last_chord_type==3)||(theMeanderState.theHarmonyParms.last_chord_type==4)||(theMeanderState.theHarmonyParms.last_chord_type==5))
-					snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theHarmonyParms.last[3].note%12)], theMeanderState.theHarmonyParms.last[3].note/12);
+				if ((engine->theMeanderState.theHarmonyParms.last_chord_type==2)||(engine->theMeanderState.theHarmonyParms.last_chord_type==3)||(engine->theMeanderState.theHarmonyParms.last_chord_type==4)||(engine->theMeanderState.theHarmonyParms.last_chord_type==5))
+					snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theHarmonyParms.last[3].note%12)], engine->theMeanderState.theHarmonyParms.last[3].note/12);
 				else
 					snprintf(text, sizeof(text), "%s", "   ");
 				nvgFillColor(args.vg, nvgRGBA(0xFF, 0x0, 0x0, 0xFF)); 
@@ -5394,102 +4262,91 @@ struct MeanderWidget : ModuleWidget
 						
 				// write last bass note played 
 				pos=convertSVGtoNVG(319.1, 121.0, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-				snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theBassParms.last[0].note%12)], (theMeanderState.theBassParms.last[0].note/12));
+				snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theBassParms.last[0].note%12)], (engine->theMeanderState.theBassParms.last[0].note/12));
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0xFF, 0x0, 0xFF)); 
 				nvgText(args.vg, pos.x, pos.y, text, NULL);
 				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 
 				// write last octave bass note played 
-				if (theMeanderState.theBassParms.octave_enabled)
+				if (engine->theMeanderState.theBassParms.octave_enabled)
 				{
 					pos=convertSVGtoNVG(330.1, 121.0, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
-					snprintf(text, sizeof(text), "%s%d", note_desig[(theMeanderState.theBassParms.last[1].note%12)], (theMeanderState.theBassParms.last[1].note/12));
+					snprintf(text, sizeof(text), "%s%d", engine->note_desig[(engine->theMeanderState.theBassParms.last[1].note%12)], (engine->theMeanderState.theBassParms.last[1].note/12));
 					nvgFillColor(args.vg, nvgRGBA(0x0, 0xFF, 0x0, 0xFF)); 
 					nvgText(args.vg, pos.x, pos.y, text, NULL);
 					nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF)); 
 				}
 			}
 
-			int last_chord_root=theMeanderState.last_harmony_chord_root_note%12;
-			int last_chord_bass_note=theMeanderState.theHarmonyParms.last[0].note%12;
+			int last_chord_root=engine->theMeanderState.last_harmony_chord_root_note%12;
+			int last_chord_bass_note=engine->theMeanderState.theHarmonyParms.last[0].note%12;
 		//	pos=convertSVGtoNVG(110, 60, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
 			pos=convertSVGtoNVG(110, 62, 12.1, 6.5);  // X,Y,W,H in Inkscape mm units
 			nvgFontSize(args.vg, 30);
 
 			char chord_type_desc[16];
-			if (theMeanderState.theHarmonyParms.last_chord_type==0)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==0)
 				strcpy(chord_type_desc, "");
-			if (theMeanderState.theHarmonyParms.last_chord_type==2)  // dom
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==2)  // dom
 				strcpy(chord_type_desc, "dom7");
-			if (theMeanderState.theHarmonyParms.last_chord_type==1)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==1)
 				strcpy(chord_type_desc, "m");
-			if (theMeanderState.theHarmonyParms.last_chord_type==3)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==3)
 				strcpy(chord_type_desc, "7");
-			if (theMeanderState.theHarmonyParms.last_chord_type==4)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==4)
 				strcpy(chord_type_desc, "m7");
-			if (theMeanderState.theHarmonyParms.last_chord_type==5)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==5)
 				strcpy(chord_type_desc, "dim7");
-			if (theMeanderState.theHarmonyParms.last_chord_type==6)
+			if (engine->theMeanderState.theHarmonyParms.last_chord_type==6)
 				strcpy(chord_type_desc, "dim");
 
 			if (last_chord_bass_note!=last_chord_root) 
-				snprintf(text, sizeof(text), "%s%s/%s", note_desig[last_chord_root], chord_type_desc, note_desig[last_chord_bass_note]);
+				snprintf(text, sizeof(text), "%s%s/%s", engine->note_desig[last_chord_root], chord_type_desc, engine->note_desig[last_chord_bass_note]);
 			else
-				snprintf(text, sizeof(text), "%s%s", note_desig[last_chord_root], chord_type_desc);
+				snprintf(text, sizeof(text), "%s%s", engine->note_desig[last_chord_root], chord_type_desc);
 
 			nvgText(args.vg, pos.x, pos.y, text, NULL);
 			
 		//	drawGrid(args);  // here after all updates are completed so grid is on top
 
-
+			frameProfiler.mark(FRAME_PANEL_REST);
 					
 			if (doDebug) DEBUG("UpdatePanel()-end");
 		}  // end UpdatePanel()
 
 	   
-		double smoothedDt=.016;  // start out at 1/60
-		int numZeroes=0;
-		
+		// the frame time overlay, turned on from the context menu
+		void drawFrameTimes(const DrawArgs &args)
+		{
+			nvgFontSize(args.vg, 12);
+			nvgFontFaceId(args.vg, textfont->handle);
+			nvgTextAlign(args.vg,NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE); 
+			nvgTextLetterSpacing(args.vg, -1);
+			nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF));
+			char text[128];
+			for (int i=0; i<NUM_FRAME_SECTIONS; ++i)
+			{
+				Vec pos=Vec(10, 338-12*(NUM_FRAME_SECTIONS-1-i));
+				frameProfiler.describe(i, text, sizeof(text));
+				nvgText(args.vg, pos.x, pos.y, text, NULL);
+			}
+		}
+
 		void draw(const DrawArgs &args) override 
 		{   
 			if (true)  // disable nanovg rendering for testing
 			{
-				#if defined(_USE_WINDOWS_PERFTIME)
-				LARGE_INTEGER t;
-				QueryPerformanceFrequency(&t);
-				double frequency=double(t.QuadPart);
-				QueryPerformanceCounter(&t);
-				int64_t n= t.QuadPart;
-				double count= (double)(n)/frequency;
-				double time1=count;
-				#endif
-
-									
+				frameProfiler.beginFrame();
 
-				DrawCircle5ths(args, root_key);  // has to be done each frame as panel redraws as SVG and needs to be blanked and cirecles redrawn
-				DrawDegreesSemicircle(args,  root_key);
+				DrawCircle5ths(args, engine->root_key);  // has to be done each frame as panel redraws as SVG and needs to be blanked and cirecles redrawn
+				frameProfiler.mark(FRAME_CIRCLE);
+				DrawDegreesSemicircle(args,  engine->root_key);
+				frameProfiler.mark(FRAME_DEGREES);
 				updatePanel(args);
-				 
-				
-				#if defined(_USE_WINDOWS_PERFTIME)
-				QueryPerformanceCounter(&t);
-				n= t.QuadPart;
-				count= (double)(n)/frequency;
-				double time2=count;
-				double deltaTime=time2-time1;
-				smoothedDt=(.9*smoothedDt) + (.1*(deltaTime));
-				
-				nvgFontSize(args.vg, 12);
-				nvgFontFaceId(args.vg, textfont->handle);
-				nvgTextAlign(args.vg,NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE); 
-				nvgTextLetterSpacing(args.vg, -1);
-				nvgFillColor(args.vg, nvgRGBA(0x0, 0x0, 0x0, 0xFF));
-				Vec pos=Vec(10, 338);
-				char text[128];
-				snprintf(text, sizeof(text), "UI   %.2lf ms", smoothedDt*1000.0);
-				nvgText(args.vg, pos.x, pos.y, text, NULL);
-				#endif
-				
+
+				frameProfiler.endFrame();
+				if (frameProfiler.enabled)
+					drawFrameTimes(args);
 			} 
 		}
 
@@ -5497,11 +4354,12 @@ struct MeanderWidget : ModuleWidget
 	
 	};  // end struct CircleOf5thsDisplay
 
+	CircleOf5thsDisplay* circleDisplay=nullptr;
+
 	MeanderWidget(Meander* module)   // all plugins I've looked at use this constructor with module*, even though docs show it deprecated.  
 	{ 
 		if (doDebug) DEBUG("MeanderWidget()");
 		setModule(module);  // most plugins do this
-		this->module = module;  //  most plugins do not do this.  It was introduced in singleton implementation
 
 		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Meander.svg")));
 					
@@ -5510,29 +4368,25 @@ struct MeanderWidget : ModuleWidget
 			
 		 if (true)   // must be executed in order to see ModuleWidget panel display in preview, module* is checked for null below as it is null in browser preview
 		 {
-			if ((module) &&(!module->instanceRunning)) 
-			{
-				box.size.x = mm2px(5.08 * 32);
-				int middle = box.size.x / 2 + 7;
-			
-				addChild(new RSLabelCentered(middle, (box.size.y / 2), "DISABLED", 28));	
-				addChild(new RSLabelCentered(middle, (box.size.y / 2)+30, "ONLY ONE INSTANCE OF MEANDER REQUIRED",20));
-				return;
-			}
-
-				
 			RootKeySelectLineDisplay *MeanderRootKeySelectDisplay = createWidget<RootKeySelectLineDisplay>(Vec(120.,198.));  
 			MeanderRootKeySelectDisplay->box.size = Vec(40, 22); 
+			if (module) 
+				MeanderRootKeySelectDisplay->engine = module;
 			addChild(MeanderRootKeySelectDisplay);
 
 			ScaleSelectLineDisplay *MeanderScaleSelectDisplay = createWidget<ScaleSelectLineDisplay>(Vec(40.,225.));  
 			MeanderScaleSelectDisplay->box.size = Vec(120, 22); 
+			if (module) 
+				MeanderScaleSelectDisplay->engine = module;
 			addChild(MeanderScaleSelectDisplay);
 
 			CircleOf5thsDisplay *display = new CircleOf5thsDisplay();
+			circleDisplay = display;
 			display->ParameterRectLocal=ParameterRect;
 			display->InportRectLocal=InportRect;  
 			display->OutportRectLocal=OutportRect;  
+			if (module) 
+				display->engine = module;
 									
 			display->box.pos = Vec(0, 0);
 			display->box.size = Vec(box.size.x, box.size.y);
@@ -5556,7 +4410,7 @@ struct MeanderWidget : ModuleWidget
 			SigTopDisplay->box.pos = Vec(130,130);
 			SigTopDisplay->box.size = Vec(25, 20);
 			if (module) 
-				SigTopDisplay->value = &time_sig_top;
+				SigTopDisplay->value = &module->time_sig_top;
 			addChild(SigTopDisplay);
 			//SIG TOP KNOB
 		
@@ -5565,7 +4419,7 @@ struct MeanderWidget : ModuleWidget
 			SigBottomDisplay->box.pos = Vec(130,150);
 			SigBottomDisplay->box.size = Vec(25, 20);
 			if (module) 
-				SigBottomDisplay->value = &time_sig_bottom;
+				SigBottomDisplay->value = &module->time_sig_bottom;
 			addChild(SigBottomDisplay);
 			
 			//*************   Note: Each LEDButton needs its light and that light needs a unique ID, needs to be added to an array and then needs to be repositioned along with the button.  Also needs to be enumed with other lights so lights[] picks it up.
@@ -6424,9 +5278,9 @@ struct MeanderWidget : ModuleWidget
 		Meander *module = dynamic_cast<Meander*>(this->module);  // some plugins do this
 		if(module == NULL) return;
 	
-	   	if ((module != NULL)&&(module->instanceRunning))  
+	   	if (module != NULL)  
 		{ 
-			theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=0;
+			module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=0;
 			for (CableWidget* cwIn : APP->scene->rack->getCablesOnPort(inPortWidgets[Meander::IN_PROG_STEP_EXT_CV]))
 			{
 			//	DEBUG("cwIn!==NULL cableID=%d", cwIn->cable->id);
@@ -6436,7 +5290,7 @@ struct MeanderWidget : ModuleWidget
 					if (cwOut->cable->id == cwIn->cable->id)
 					{
 					//	DEBUG("cwOut!==NULL cableID=%d STEP in port connected to OUT_CLOCK_BAR_OUTPUT port", cwOut->cable->id);
-						theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BAR_OUTPUT;
+						module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BAR_OUTPUT;
 					}
 					
 				}
@@ -6445,7 +5299,7 @@ struct MeanderWidget : ModuleWidget
 					if (cwOut->cable->id == cwIn->cable->id)
 					{
 					//	DEBUG("cwOut!==NULL cableID=%d STEP in port connected to OUT_CLOCK_BEAT_OUTPUT port", cwOut->cable->id);
-						theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEAT_OUTPUT;
+						module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEAT_OUTPUT;
 					}
 					
 				}
@@ -6454,7 +5308,7 @@ struct MeanderWidget : ModuleWidget
 					if (cwOut->cable->id == cwIn->cable->id)
 					{
 					//	DEBUG("cwOut!==NULL cableID=%d STEP in port connected to OUT_CLOCK_BEATX2_OUTPUT port", cwOut->cable->id);
-						theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX2_OUTPUT;
+						module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX2_OUTPUT;
 					}
 					
 				}
@@ -6463,7 +5317,7 @@ struct MeanderWidget : ModuleWidget
 					if (cwOut->cable->id == cwIn->cable->id)
 					{
 					//	DEBUG("cwOut!==NULL cableID=%d STEP in port connected to 	OUT_CLOCK_BEATX4_OUTPUT port", cwOut->cable->id);
-						theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX4_OUTPUT;
+						module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX4_OUTPUT;
 					}
 					
 				}
@@ -6472,7 +5326,7 @@ struct MeanderWidget : ModuleWidget
 					if (cwOut->cable->id == cwIn->cable->id)
 					{
 					//	DEBUG("cwOut!==NULL cableID=%d STEP in port connected to OUT_CLOCK_BEATX8_OUTPUT port", cwOut->cable->id);
-						theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX8_OUTPUT;
+						module->theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port=Meander::OUT_CLOCK_BEATX8_OUTPUT;
 					}
 					
 				}
@@ -6485,6 +5339,165 @@ struct MeanderWidget : ModuleWidget
 		ModuleWidget::step();
 	} // end step()
 
+	struct HarmonyPresetBankItem : MenuItem
+	{
+		Meander* module;
+		bool load=false;  // ask for a bank file, else go back to the built-in presets
+
+		void onAction(const event::Action &e) override
+		{
+			if (load)
+			{
+				osdialog_filters* filters=osdialog_filters_parse("Preset bank:txt");
+				char* file=osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
+				osdialog_filters_free(filters);
+				if (!file)
+					return;
+				if (!module->useHarmonyPresetBank(file))
+					osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "No valid progression presets in that file");
+				free(file);
+			}
+			else
+				module->useHarmonyPresetBank("");
+		}
+	};
+
+	struct fBmWavetableItem : MenuItem
+	{
+		Meander* module;
+		bool wavetable=false;
+
+		void onAction(const event::Action &e) override
+		{
+			if (wavetable && !module->fBm_wavetable)
+				module->preparefBmWavetables();
+			module->fBm_wavetable=wavetable;
+		}
+	};
+
+	struct fBmCVItem : MenuItem
+	{
+		Meander* module;
+		bool smooth=false;
+		int channels=0;  // 0 leaves the channel count as it is
+
+		void onAction(const event::Action &e) override
+		{
+			module->fBm_cv_smooth=smooth;
+			if (channels>0)
+				module->fBm_cv_channels=channels;
+			module->fBm_cv_index=Meander::FBM_CV_BLOCK;  // start a new block now
+		}
+	};
+
+	struct ProfilingItem : MenuItem
+	{
+		Meander* module;
+
+		void onAction(const event::Action &e) override
+		{
+			module->profiler.enable(!module->profiler.enabled);
+		}
+	};
+
+	struct FrameTimesItem : MenuItem
+	{
+		MeanderFrameProfiler* frameProfiler;
+
+		void onAction(const event::Action &e) override
+		{
+			frameProfiler->enable(!frameProfiler->enabled);
+		}
+	};
+
+	// one section's timings, updated while the menu is open
+	struct ProfileSectionLabel : MenuLabel
+	{
+		Meander* module;
+		int section=0;
+
+		void step() override
+		{
+			char line[128];
+			module->profiler.describe(section, line, sizeof(line));
+			text=line;
+			MenuLabel::step();
+		}
+	};
+
+	void appendContextMenu(Menu* menu) override
+	{
+		Meander* module=dynamic_cast<Meander*>(this->module);
+		if (!module)
+			return;
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Progression presets"));
+
+		HarmonyPresetBankItem* builtinItem=createMenuItem<HarmonyPresetBankItem>("Built-in", CHECKMARK(module->harmonyPresetBankPath.empty()));
+		builtinItem->module=module;
+		menu->addChild(builtinItem);
+
+		std::string bankName=(module->harmonyPresetBankPath.empty()) ? "" : rack::string::filename(module->harmonyPresetBankPath);
+		HarmonyPresetBankItem* loadItem=createMenuItem<HarmonyPresetBankItem>("Load bank...", bankName);
+		loadItem->module=module;
+		loadItem->load=true;
+		menu->addChild(loadItem);
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("fBm noise"));
+
+		fBmWavetableItem* computedItem=createMenuItem<fBmWavetableItem>("Computed", CHECKMARK(!module->fBm_wavetable));
+		computedItem->module=module;
+		menu->addChild(computedItem);
+
+		fBmWavetableItem* wavetableItem=createMenuItem<fBmWavetableItem>("Wavetable", CHECKMARK(module->fBm_wavetable));
+		wavetableItem->module=module;
+		wavetableItem->wavetable=true;
+		menu->addChild(wavetableItem);
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("fBm outputs"));
+
+		fBmCVItem* steppedItem=createMenuItem<fBmCVItem>("Stepped on notes", CHECKMARK(!module->fBm_cv_smooth));
+		steppedItem->module=module;
+		menu->addChild(steppedItem);
+
+		const int channelCounts[]={1, 2, 4, 8, 16};
+		for (int channels : channelCounts)
+		{
+			std::string text=(channels==1) ? "Smooth" : "Smooth, "+std::to_string(channels)+" channels";
+			fBmCVItem* smoothItem=createMenuItem<fBmCVItem>(text, CHECKMARK(module->fBm_cv_smooth && (module->fBm_cv_channels==channels)));
+			smoothItem->module=module;
+			smoothItem->smooth=true;
+			smoothItem->channels=channels;
+			menu->addChild(smoothItem);
+		}
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Profiling"));
+
+		ProfilingItem* profilingItem=createMenuItem<ProfilingItem>("Time process() sections", CHECKMARK(module->profiler.enabled));
+		profilingItem->module=module;
+		menu->addChild(profilingItem);
+
+		if (circleDisplay)
+		{
+			FrameTimesItem* frameTimesItem=createMenuItem<FrameTimesItem>("Show panel frame times", CHECKMARK(circleDisplay->frameProfiler.enabled));
+			frameTimesItem->frameProfiler=&circleDisplay->frameProfiler;
+			menu->addChild(frameTimesItem);
+		}
+
+		if (module->profiler.enabled)
+			for (int i=0; i<NUM_PROFILE_SECTIONS; ++i)
+			{
+				ProfileSectionLabel* sectionLabel=createMenuLabel<ProfileSectionLabel>("");
+				sectionLabel->module=module;
+				sectionLabel->section=i;
+				menu->addChild(sectionLabel);
+			}
+	}
+
 };  // end struct MeanderWidget
 
 
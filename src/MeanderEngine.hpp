@@ -0,0 +1,3092 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// The Meander composition engine: music theory tables, harmony presets, per-instance state and the harmony, melody,
+// arp and bass generators.  Nothing here depends on rack::Module, so it can also be built headless (see tools/).
+
+#pragma once
+
+#if defined(MEANDER_HEADLESS)
+#include "MeanderHeadless.hpp"
+#else
+#include <rack.hpp>
+using namespace rack;
+#endif
+
+#include "Common-Noise.hpp" 
+#include "MeanderProfiler.hpp"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <cstdint>
+#include <atomic>
+
+bool doDebug = false;  // set this to true to enable verbose DEBUG() logging
+
+bool Audit_enable=false;  
+
+#define CV_MAX10 (10.0f)
+#define CV_MAXn5 (5.0f)
+#define AUDIO_MAX (6.0f)
+#define VOCT_MAX (8.0f)
+#define AMP_MAX (2.0f)       
+ 
+#define MAX_NOTES 12
+#define MAX_STEPS 16
+#define MAX_CIRCLE_STATIONS 12
+#define MAX_HARMONIC_DEGREES 7
+
+#define MAX_PARAMS 200
+#define MAX_INPORTS 100
+#define MAX_OUTPORTS 100
+
+struct inPortState
+{
+	bool inTransition=false;
+	float lastValue=-999.;
+};
+
+
+
+
+
+
+
+// make it a power of 8
+#define MAXSHORTSTRLEN 16
+
+struct CircleElement
+{
+	// this data is mostly static, once created
+	int chordType=0;  // may be overridden by degree semicircle
+	float startDegree; // of annular segment
+	float endDegree;   // of annular segment
+	Vec pt1;  //vertices of annular ring segment
+	Vec pt2;
+	Vec pt3;
+	Vec pt4;
+	Vec radialDirection;
+};
+
+
+struct DegreeElement
+{
+	// this data varies with root_key and mode
+	int chordType=0;
+	float startDegree;  // of pie slice
+	float endDegree;
+	Vec pt1; //vertices of annular ring segment
+	Vec pt2;
+	Vec pt3;
+	Vec pt4;
+	Vec radialDirection;
+	int Degree=1; // 1-7 corresponding to I-VII
+	int CircleIndex=0;  // correspondence between degree element and circle element.  All degrees have one.
+};
+
+
+struct DegreeSemiCircle
+{
+	int RootKeyCircle5thsPosition=0;    // semicircle [index] of "I" degree 
+	int OffsetSteps=0;  // how many 30 degree steps the semicircle must be rotated to display correctly
+	DegreeElement degreeElements[MAX_HARMONIC_DEGREES];
+};
+
+
+struct CircleOf5ths
+{
+	float OuterCircleRadius=mm2px(47);        
+	float MiddleCircleRadius=mm2px(39);
+	float InnerCircleRadius=mm2px(26);
+	Vec CircleCenter= Vec(mm2px(116.75),mm2px(67.75));
+	
+	int root_keyCirclePosition=0;
+	int root_key_note=0;
+	struct CircleElement Circle5ths[MAX_CIRCLE_STATIONS];
+	struct DegreeElement degreeElements[MAX_CIRCLE_STATIONS];
+	const struct DegreeSemiCircle* theDegreeSemiCircle=nullptr;  // points into theKeyModeTables for the current root_key and mode
+		
+};
+
+
+
+constexpr int semiCircleDegrees[]={1, 5, 2, 6, 3, 7, 4};  // default order if starting at C
+int circleDegreeLookup[]= {0, 0, 2, 4, 6, 1, 3, 5};  // to convert from arabic roman equivalents to circle degrees
+
+
+
+//*******************************************
+
+
+struct HarmonyProgressionStepSettings  // not currently utilized
+{
+	int CircleOf5thsPosition=0;
+	int ChordType=0;
+	int Inversion=1;
+	int Spread=0;
+	int NumNotes=3; 
+};
+
+struct HarmonyProgressionStepSettings HarmonicProgression[MAX_STEPS];  // up to 16 steps in a progression
+
+int NumHarmonicProgressionSteps=4;  // what is this?
+
+constexpr int mode_step_intervals[7][13]=
+{  // num mode scale notes, semitones to next note  7 modes
+	{ 7, 2,2,2,1,2,2,1,0,0,0,0,0},                // Lydian  	        
+	{ 7, 2,2,1,2,2,2,1,0,0,0,0,0},                // Major/Ionian      
+	{ 7, 2,2,1,2,2,1,2,0,0,0,0,0},                // Mixolydian	   
+	{ 7, 2,1,2,2,2,1,2,0,0,0,0,0},                // Dorian           
+	{ 7, 2,1,2,2,1,2,2,0,0,0,0,0},                // NMinor/Aeolian   
+	{ 7, 1,2,2,2,1,2,2,0,0,0,0,0},                // Phrygian         
+	{ 7, 1,2,2,1,2,2,2,0,0,0,0,0}                 // Locrian            
+}; 
+
+
+
+int root_key_signatures_chromaticForder[12][7]=  // chromatic order 0=natural, 1=sharp, -1=flat
+{  // F  C  G  D  A  E  B  in order of root_key signature sharps and flats starting with F
+  	{ 0, 0, 0, 0, 0, 0, 0},  // C  - 0
+	{ 0, 0,-1,-1,-1,-1,-1},  // Db - 1
+	{ 1, 1, 0, 0, 0, 0, 0},  // D  - 2
+	{ 0, 0, 0, 0,-1,-1,-1},  // Eb - 3
+	{ 1, 1, 1, 1, 0, 0, 0},  // E  - 4
+	{ 0, 0, 0, 0, 0, 0,-1},  // F  - 5
+	{ 1, 1, 1, 1, 1, 1, 0},  // F# - 6
+	{ 1, 0, 0, 0, 0, 0, 0},  // G  - 7
+	{ 0, 0, 0,-1,-1,-1,-1},  // Ab - 8
+	{ 1, 1, 1, 0, 0, 0, 0},  // A  - 9
+	{ 0, 0, 0, 0, 0,-1,-1},  // Bb - 10
+	{ 1, 1, 1, 1, 1, 0, 0},  // B  - 11
+	
+};
+
+int root_key_sharps_vertical_display_offset[]={1, 4, 0, 3, 6, 2};  // left to right
+int root_key_flats_vertical_display_offset[]={5, 2, 6, 3, 7, 4};   // right to left
+
+
+#define MAX_MODES 7
+int num_modes=MAX_MODES;
+constexpr char mode_names[MAX_MODES][16]={"Lydian", "Ionian/Major", "Mixolydian", "Dorian", "Aeolian/NMinor", "Phrygian", "Locrian"};
+
+
+enum noteTypes
+{
+	NOTE_TYPE_CHORD,
+	NOTE_TYPE_MELODY,
+	NOTE_TYPE_ARP,
+	NOTE_TYPE_BASS,
+	NOTE_TYPE_EXTERNAL
+};
+
+
+struct note
+{
+	int note;
+	int noteType; // NOTE_TYPE_CHORD etc.
+	int time32s;
+	int length;  // 1/1,2,4,8
+	int countInBar;
+};
+
+
+
+
+const char* noteNames[MAX_NOTES] = {"C","C#/Db","D","D#/Eb","E","F","F#/Gb","G","G#/Ab","A","A#/Bb","B"};
+const char* CircleNoteNames[MAX_NOTES] = {"C","G","D","A","E","B","F#","Db","Ab","Eb","Bb","F"};
+
+#define MAX_ROOT_KEYS 12
+
+// any mode and root_key is equivalent to a maj key by transposing down these numbers of major scale semitones
+// Mode        Transpose down by interval  or semitones
+// Ionian						Perfrect Unison    0
+// Dorian						Major second       2
+// Phrygian						Major third		   4 
+// Lydian						Perfect fourth     5
+// Mixolydian					Perfect fifth	   7
+// Aeolian						Major sixth        9
+// Locrian						Major seventh     11
+
+// more simply modes can also be transposed to major scale by using the mode natural roots semitone counts for white keys CDEFGAB
+int mode_natural_roots[MAX_MODES] = {  // for which scale is all white notes  these can also be used as transpose semitones if modes in IDPLMAL order
+	0,  //C  Ionian
+	2,  //D  Dorian 
+	4,  //E  Phrygian
+	5,  //F  Lydian
+	7,  //G  Mixolydian
+	9,  //A  Aeolian
+	11  //B  Locrian
+};
+
+int mode_root_key_signature_offset[]={3,0,4,1,5,2,6};  // index into mode_natural_roots[] using the IDPLyMALo = 1,2,3,4,5,6,7 rule for Meander mode ordering
+
+constexpr char root_key_names[MAX_ROOT_KEYS][MAXSHORTSTRLEN]={"C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"};
+
+#define MAX_NOTES_CANDIDATES 130
+
+constexpr char note_desig_default[MAX_NOTES][MAXSHORTSTRLEN]={"C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"};  // mixed spelling used until a root_key is chosen
+constexpr char note_desig_sharps[MAX_NOTES][MAXSHORTSTRLEN]={"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+constexpr char note_desig_flats[MAX_NOTES][MAXSHORTSTRLEN]={"C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B"};
+
+struct HarmonyParms
+{
+	bool enabled=true;
+	float volume=10.0f;  // 0-10 V
+	int note_length_divisor=1;  // 1, 2, 4, 8   doHarmony() on these boundaries
+	int target_octave=4;
+	double note_octave_range=1.0;
+	double note_avg_target=target_octave/10.0;  
+	double range_top=    note_avg_target + (note_octave_range/10.0);
+	double range_bottom= note_avg_target - (note_octave_range/10.0);
+	double r1=(range_top-range_bottom); 
+	double note_avg= note_avg_target;  
+	double alpha=.1;
+	double seed=1234;
+	int noctaves=3;
+	float period=100.0;
+	int last_circle_step=-1;  // used for Markov chains
+	int markov_history=-1;  // last steps encoded for a higher order MarkovChain, -1 to start over
+	int last_chord_type=0;
+	int bar_harmony_chords_counted_note=0;
+	bool enable_all_7ths=false;
+	bool enable_V_7ths=false;
+    bool enable_staccato=false;
+	int pending_step_edit=0;
+	struct note last[4];
+	float lastCircleDegreeIn=0;
+	int STEP_inport_connected_to_Meander_trigger_port=0;
+};  
+
+struct MelodyParms  
+{
+	bool enabled=true;
+	bool chordal=true;
+	bool scaler=false;
+	float volume=8.0f;  // 0-10 V
+	int note_length_divisor=4;
+	double target_octave=3.0;  // 4=middle-C C4 0v  must be an integer value
+	double note_octave_range=1.0;
+	double note_avg_target=target_octave/10.0;  
+	double range_top=    note_avg_target + (note_octave_range/10.0);
+	double range_bottom= note_avg_target - (note_octave_range/10.0);
+	double r1=(range_top-range_bottom); 
+
+	double note_avg= note_avg_target;  
+	double alpha=.9;
+	double seed=12345;
+	int noctaves=4;
+	float period=10.0;
+	bool destutter=false;
+	bool stutter_detected=false;
+	int last_stutter_step=0;
+	int last_chord_note_index=0;
+	int last_step=1; 
+	int bar_melody_counted_note=0;
+    bool enable_staccato=true;
+	struct note last[1];
+	float lastMelodyDegreeIn=0.0f;
+}; 
+
+struct ArpParms
+{
+	bool enabled=false;
+	bool chordal=true;
+	bool scaler=false;
+	int count=3;
+	int note_length_divisor=16;  // 8, 16, 32
+	float decay=0;
+	int pattern=0;
+	int note_count=0;  // number of arp notes played per current melody note
+	double seed=123344;
+	int noctaves=5;
+	float period=1.0;
+	struct note last[32];  // may not need this if arp is considered melody
+}; 
+
+struct BassParms
+{
+	bool enabled=true; 
+	int target_octave=2;
+	int note_length_divisor=1;  // 1, 2, 4, 8   doHarmony() on these boundaries
+	bool octave_enabled=true;  // play bass as 2 notes an octave apart
+	float volume=10.0f;  // 0-10 V
+	int bar_bass_counted_note=0;
+    bool accent=false;  // enables accents
+	bool syncopate=false;
+	bool shuffle=false;
+	struct note last[4];
+    bool enable_staccato= true;
+    bool note_accented=false;  // is current played note accented
+}; 
+
+
+struct MeanderState
+{
+	HarmonyParms  theHarmonyParms;
+	MelodyParms theMelodyParms;
+	BassParms theBassParms;
+	ArpParms theArpParms;
+	bool userControllingHarmonyFromCircle=false;
+	int last_harmony_chord_root_note=0;
+	int last_harmony_step=0;
+	int circleDegree=1;
+	bool userControllingMelody=false;
+};
+
+ 
+constexpr char chord_type_name[30][MAXSHORTSTRLEN]={"Major", "Minor", "7th", "maj7th", "min7th", "dim7th", "Dim", "Aug", "6th", "min6th", "dim6th", "9th", "10th", "11th", "13th", "Quartel", "Perf5th", "Scalar"};
+constexpr int chord_type_intervals[30][16]={
+	{0, 4, 7},                    // Major
+	{0, 3, 7},                    // Minor
+	{0, 4, 7, 10},                // 7th, usually a dominant 7th chord is a major triad with minor 7th
+	{0, 4, 7, 11},                // maj7th
+	{0, 3, 7, 10},                // min7th
+	{0, 3, 6, 10},                // dim7th
+	{0, 3, 6},                    // Dim
+	{0, 4, 8},                    // Aug
+	{0, 4, 7, 9},                 // 6th
+	{0, 3, 7, 9},                 // min6th
+	{0, 4, 6, 9},                 // dim6th
+	{0, 4, 7, 10, 14},            // 9th
+	{0, 9},                       // 10th
+	{0, 4, 7, 10, 14, 17},        // 11th
+	{0, 4, 7, 10, 14, 17, 21},    // 13th
+	{0, 5, 10, 15},               // Quartel
+	{0, 7, 14, 21},               // Perf5th
+	{0, 4, 7}                     // Scalar
+};
+constexpr int chord_type_num_notes[30]={3, 3, 4, 4, 4, 4, 3, 3, 4, 4, 4, 5, 2, 6, 7, 4, 4, 3};
+
+enum HarmonyProgressions  // how the harmony generator walks a preset's steps
+{
+	PROGRESSION_STEPS,  // in order
+	PROGRESSION_RANDOM_COMING_HOME,  // random number of steps from the end, then in order back to I
+	PROGRESSION_RANDOM_ORDER,
+	PROGRESSION_MARKOV,  // first order Markov chain over degrees I-VII, see theMarkovMatrices
+	PROGRESSION_MARKOV_CHAIN  // Markov chain of order 1-3 over the preset's steps, see MarkovChain
+};
+
+struct MarkovMatrix;
+struct MarkovChain;
+
+struct HarmonyType
+{
+	int    harmony_type;  // used by theActiveHarmonyType
+	char   harmony_type_desc[64]=""; 
+	char   harmony_degrees_desc[128]=""; 
+	int    num_harmony_steps=1;
+	int    min_steps=1;
+	int    max_steps=1;
+	int    harmony_step_chord_type[MAX_STEPS]={};
+	int    harmony_steps[MAX_STEPS]={1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};  // initialize to a valid step degree
+	int    progression=PROGRESSION_STEPS;
+	bool   harmony_step_seventh[MAX_STEPS]={};  // play the step as a 7th chord whatever the 7ths buttons say
+	const MarkovMatrix* markov_matrix=nullptr;  // when progression is PROGRESSION_MARKOV
+	const MarkovChain* markov_chain=nullptr;  // when progression is PROGRESSION_MARKOV_CHAIN
+};
+
+
+constexpr int circle_of_fifths[MAX_CIRCLE_STATIONS]={0, 7, 2, 9, 4, 11, 6, 1, 8, 3, 10, 5};
+
+char circle_of_fifths_degrees[][MAXSHORTSTRLEN]= {
+	"I", "V", "II", "vi", "iii", "vii", "IV"
+};
+
+char circle_of_fifths_arabic_degrees[][MAXSHORTSTRLEN]= {
+	"", "I", "II", "III", "IV", "V", "IV", "VII"
+};
+
+char circle_of_fifths_degrees_UC[][MAXSHORTSTRLEN]= {
+	"I", "V", "II", "VI", "III", "VII", "IV"
+};
+
+char circle_of_fifths_degrees_LC[][MAXSHORTSTRLEN]= {
+	"i", "v", "ii", "vi", "iii", "vii", "iv"
+};
+
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixTemplate[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // I
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // II
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // III
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // IV
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // V
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // VI
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrix_I_IV_V[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.00, 0.00, 0.60, 0.40, 0.00, 0.00},  // I
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // II
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // III
+	{0.00, 0.20, 0.00, 0.00, 0.00, 0.80, 0.00, 0.00},  // IV
+	{0.00, 0.70, 0.00, 0.00, 0.30, 0.00, 0.00, 0.00},  // V
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // VI
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixBach1[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.18, 0.01, 0.20, 0.41, 0.09, 0.12},  // I
+	{0.00, 0.01, 0.00, 0.03, 0.00, 0.89, 0.00, 0.07},  // II
+	{0.00, 0.06, 0.06, 0.00, 0.25, 0.19, 0.31, 0.13},  // III
+	{0.00, 0.22, 0.14, 0.00, 0.00, 0.48, 0.00, 0.15},  // IV
+	{0.00, 0.80, 0.00, 0.02, 0.06, 0.00, 0.10, 0.20},  // V
+	{0.00, 0.03, 0.54, 0.03, 0.14, 0.19, 0.00, 0.08},  // VI
+	{0.00, 0.81, 0.00, 0.01, 0.03, 0.15, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixBach2[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.15, 0.01, 0.28, 0.41, 0.09, 0.06},  // I
+	{0.00, 0.01, 0.00, 0.00, 0.00, 0.71, 0.01, 0.25},  // II
+	{0.00, 0.03, 0.03, 0.00, 0.52, 0.06, 0.32, 0.03},  // III
+	{0.00, 0.22, 0.13, 0.00, 0.00, 0.39, 0.02, 0.23},  // IV
+	{0.00, 0.82, 0.01, 0.00, 0.07, 0.00, 0.09, 0.00},  // V
+	{0.00, 0.15, 0.29, 0.05, 0.11, 0.32, 0.00, 0.09},  // VI
+	{0.00, 0.91, 0.00, 0.01, 0.02, 0.04, 0.03, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixMozart1[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.08, 0.00, 0.07, 0.68, 0.06, 0.11},  // I
+	{0.00, 0.37, 0.00, 0.00, 0.00, 0.46, 0.00, 0.17},  // II
+	{0.00, 0.00, 0.00, 0.00, 1.00, 0.00, 0.00, 0.00},  // III
+	{0.00, 0.42, 0.10, 0.00, 0.00, 0.39, 0.00, 0.09},  // IV
+	{0.00, 0.82, 0.00, 0.00, 0.05, 0.00, 0.07, 0.05},  // V
+	{0.00, 0.14, 0.51, 0.00, 0.16, 0.05, 0.00, 0.14},  // VI
+	{0.00, 0.76, 0.01, 0.00, 0.00, 0.23, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixMozart2[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.13, 0.00, 0.15, 0.62, 0.05, 0.05},  // I
+	{0.00, 0.49, 0.00, 0.01, 0.00, 0.40, 0.01, 0.09},  // II
+	{0.00, 0.67, 0.00, 0.00, 0.00, 0.00, 0.33, 0.00},  // III
+	{0.00, 0.64, 0.14, 0.00, 0.00, 0.15, 0.00, 0.07},  // IV
+	{0.00, 0.94, 0.00, 0.00, 0.01, 0.00, 0.04, 0.01},  // V
+	{0.00, 0.11, 0.51, 0.00, 0.14, 0.20, 0.00, 0.04},  // VI
+	{0.00, 0.82, 0.00, 0.01, 0.01, 0.16, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixPalestrina1[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.15, 0.13, 0.28, 0.14, 0.22, 0.08},  // I
+	{0.00, 0.08, 0.00, 0.15, 0.13, 0.28, 0.14, 0.22},  // II
+	{0.00, 0.22, 0.08, 0.00, 0.15, 0.13, 0.28, 0.14},  // III
+	{0.00, 0.14, 0.22, 0.08, 0.00, 0.15, 0.13, 0.28},  // IV
+	{0.00, 0.28, 0.14, 0.22, 0.08, 0.00, 0.15, 0.13},  // V
+	{0.00, 0.13, 0.28, 0.14, 0.22, 0.08, 0.00, 0.15},  // VI
+	{0.00, 0.15, 0.13, 0.28, 0.14, 0.22, 0.08, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixBeethoven1[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.10, 0.01, 0.13, 0.52, 0.02, 0.22},  // I
+	{0.00, 0.06, 0.00, 0.02, 0.00, 0.87, 0.00, 0.05},  // II
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.67, 0.33, 0.00},  // III
+	{0.00, 0.33, 0.03, 0.07, 0.00, 0.40, 0.03, 0.13},  // IV
+	{0.00, 0.56, 0.22, 0.01, 0.04, 0.00, 0.07, 0.11},  // V
+	{0.00, 0.06, 0.44, 0.00, 0.06, 0.11, 0.00, 0.33},  // VI
+	{0.00, 0.80, 0.00, 0.00, 0.03, 0.17, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// Markov 1st order row to column transition probabiliites
+float MarkovProgressionTransitionMatrixTraditional1[8][8]={  // 8x8 so degrees can be 1 indexed
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy
+	{0.00, 0.00, 0.00, 0.25, 0.25, 0.25, 0.25, 0.00},  // I
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.50, 0.00, 0.50},  // II
+	{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 1.00, 0.00},  // III
+	{0.00, 0.25, 0.25, 0.00, 0.00, 0.25, 0.00, 0.25},  // IV
+	{0.00, 0.50, 0.00, 0.00, 0.00, 0.00, 0.50, 0.00},  // V
+	{0.00, 0.00, 0.50, 0.00, 0.50, 0.00, 0.00, 0.00},  // VI
+	{0.00, 0.50, 0.00, 0.00, 0.00, 0.50, 0.00, 0.00}}; // VII
+//   dummy  I     II    III   IV    V     VI    VII 
+
+// A transition matrix compiled for sampling when it is loaded.  cumulative[row][i] is the probability of moving from
+// degree row to any of degrees 1..i, so sample() turns a uniform draw into a step with 7 compares and no search.
+struct MarkovMatrix
+{
+	std::string name;  // the built-in name, or the file a user matrix was loaded from
+	float transitions[8][8]={};  // 8x8 so degrees can be 1 indexed, like the MarkovProgressionTransitionMatrix tables
+	float cumulative[8][8]={};
+
+	// next 0 based harmony step after lastStep.  Step 1 if the row does not reach rnd, as the original search left it.
+	int sample(int lastStep, float rnd) const
+	{
+		const float* top=cumulative[clamp(lastStep+1, 0, 7)];
+		int below=(rnd>top[1])+(rnd>top[2])+(rnd>top[3])+(rnd>top[4])+(rnd>top[5])+(rnd>top[6])+(rnd>top[7]);
+		return ((rnd>0.f)&(below<7)) ? below : 1;
+	}
+};
+
+std::list<MarkovMatrix> theMarkovMatrices;  // never freed, presets point at their matrix
+
+// User matrices are normalized so each row sums to 1.  The built-in ones are compiled as written, some rows do not quite
+// sum to 1, so that existing patches keep playing the same progressions.
+const MarkovMatrix* addMarkovMatrix(const std::string &name, const float transitions[8][8], bool normalize)
+{
+	MarkovMatrix matrix;
+	matrix.name=name;
+	for (int row=1; row<8; ++row)
+	{
+		float sum=0;
+		for (int i=1; i<8; ++i)
+			sum+=transitions[row][i];
+		float scale=((normalize)&&(sum>0)) ? 1.f/sum : 1.f;
+		float bottom=0;
+		for (int i=1; i<8; ++i)
+		{
+			matrix.transitions[row][i]=transitions[row][i]*scale;
+			matrix.cumulative[row][i]=bottom+matrix.transitions[row][i];
+			bottom=matrix.cumulative[row][i];
+		}
+	}
+	theMarkovMatrices.push_back(matrix);
+	return &theMarkovMatrices.back();
+}
+
+void initMarkovMatrices()
+{
+	addMarkovMatrix("Bach1", MarkovProgressionTransitionMatrixBach1, false);
+	addMarkovMatrix("Bach2", MarkovProgressionTransitionMatrixBach2, false);
+	addMarkovMatrix("Mozart1", MarkovProgressionTransitionMatrixMozart1, false);
+	addMarkovMatrix("Mozart2", MarkovProgressionTransitionMatrixMozart2, false);
+	addMarkovMatrix("Palestrina1", MarkovProgressionTransitionMatrixPalestrina1, false);
+	addMarkovMatrix("Beethoven1", MarkovProgressionTransitionMatrixBeethoven1, false);
+	addMarkovMatrix("Traditional1", MarkovProgressionTransitionMatrixTraditional1, false);
+	addMarkovMatrix("I_IV_V", MarkovProgressionTransitionMatrix_I_IV_V, false);
+}
+
+// A user matrix file is JSON with a 7x7 "matrix" array, one row per degree I-VII giving the weights of moving to
+// degrees I-VII:  {"name": "my chorales", "matrix": [[0, 0.2, 0, 0.3, 0.4, 0.1, 0], ...]}
+// Weights must not be negative.  Each file is parsed and compiled once, nullptr if it is not a valid matrix.
+const MarkovMatrix* loadMarkovMatrix(const std::string &path)
+{
+	for (const MarkovMatrix &matrix : theMarkovMatrices)
+		if (matrix.name==path)
+			return &matrix;
+
+	FILE* file=fopen(path.c_str(), "r");
+	if (!file)
+		return nullptr;
+	std::string text;
+	char buffer[1024];
+	size_t n;
+	while ((n=fread(buffer, 1, sizeof(buffer), file))>0)
+		text.append(buffer, n);
+	fclose(file);
+
+	size_t key=text.find("\"matrix\"");
+	if (key==std::string::npos)
+		return nullptr;
+	const char* p=strchr(text.c_str()+key, '[');
+	if (!p)
+		return nullptr;
+
+	float transitions[8][8]={};
+	int row=0;
+	int column=0;
+	int depth=0;
+	for (; *p; ++p)
+	{
+		if (*p=='[')
+		{
+			if (++depth>2)
+				return nullptr;
+			if (depth==2)
+			{
+				if (++row>7)
+					return nullptr;
+				column=0;
+			}
+		}
+		else
+		if (*p==']')
+		{
+			if ((depth==2)&&(column!=7))
+				return nullptr;
+			if (--depth==0)
+				break;
+		}
+		else
+		if ((depth==2)&&(strchr("+-.0123456789", *p)))
+		{
+			char* end;
+			float weight=strtof(p, &end);
+			if ((weight<0)||(++column>7))
+				return nullptr;
+			transitions[row][column]=weight;
+			p=end-1;
+		}
+	}
+	if ((depth!=0)||(row!=7))
+		return nullptr;
+	if (doDebug)  DEBUG("loaded Markov matrix %s", path.c_str());
+	return addMarkovMatrix(path, transitions, true);
+}
+
+struct chord_type_info 
+{
+	char name[MAXSHORTSTRLEN]="";
+	int num_notes=0;
+	int intervals[8]={0,0,0,0,0,0,0,0};
+};
+struct chord_type_info chordTypeInfo[30];
+
+
+// Everything derived from the root key and mode, precomputed for all 12 x 7 combinations by initKeyModeTables() at
+// plugin load.  A root key or mode change, from the panel or from IN_ROOT_KEY_EXT_CV/IN_SCALE_EXT_CV, then only
+// repoints the engine at another set of tables (MeanderEngine::selectKeyModeTables()) so it is safe at audio rate.
+
+#define MAX_CIRCLE_CHORD_TYPES 7  // the triads and 7ths setup_harmony() can put on a circle position
+
+struct ModeNotesTable  // root_key_notes depend only on the mode
+{
+	int root_key_notes[MAX_ROOT_KEYS][MAX_NOTES_CANDIDATES];
+	int num_root_key_notes[MAX_ROOT_KEYS];
+};
+
+struct KeyModeTable
+{
+	DegreeSemiCircle theDegreeSemiCircle;
+	int circle_chord_type[MAX_CIRCLE_STATIONS];  // triad at each circle position before any 7ths are applied, major off the semicircle
+	int arabicStepDegreeSemicircleIndex[8];  // where is 1, 2... step in degree semicircle  // [8] so 1 based indexing can be used
+	int degree_circle_position[8];  // 1 based degree -> circle of 5ths position on the degree semicircle.  [0] unused
+	int circle_position_degree[MAX_CIRCLE_STATIONS];  // circle of 5ths position -> 1 based degree, 0 if not on the semicircle
+	int notes[MAX_NOTES_CANDIDATES];
+	int num_notes=0;
+	int scale_note_index[128];  // MIDI note -> index into root_key_notes[root_key] of that note, or of the scale note just below it
+	int notate_mode_as_signature_root_key=0;
+	bool flats=false;  // spell with note_desig_flats rather than note_desig_sharps
+	const ModeNotesTable* modeNotes=nullptr;
+};
+
+struct ChordNotesTable  // one chord type stacked on every octave of its root, as setup_harmony() plays it
+{
+	int notes[MAX_NOTES_CANDIDATES];
+	int num_notes=0;
+};
+
+CircleElement theDefaultCircle5ths[MAX_CIRCLE_STATIONS];
+ModeNotesTable theModeNotesTables[MAX_MODES];
+KeyModeTable theKeyModeTables[MAX_ROOT_KEYS][MAX_MODES];  // [circle_root_key][mode]
+ChordNotesTable theChordNotesTables[MAX_NOTES][MAX_CIRCLE_CHORD_TYPES];  // [chord root note][chord type]
+
+void init_notes(ModeNotesTable &t, int mode)
+{
+	if (doDebug)  DEBUG("init_notes(mode=%d)", mode);
+	int nmn=mode_step_intervals[mode][0];  // number of mode notes
+	int num_mode_notes=10*nmn; // the [0] entry is the notes per scale value, times 10 ocatves of midi
+	for (int j=0;j<MAX_ROOT_KEYS;++j)
+	{
+		t.root_key_notes[j][0]=j;
+		t.num_root_key_notes[j]=1;
+		for (int i=1;i<num_mode_notes ;++i)
+		{
+			t.root_key_notes[j][i]=t.root_key_notes[j][i-1]+
+				mode_step_intervals[mode][((i-1)%nmn)+1];  
+			++t.num_root_key_notes[j];
+		}
+	}
+}
+
+void init_notes(KeyModeTable &t, int root_key, int mode)
+{
+	t.notes[0]=root_key;  
+	int nmn=mode_step_intervals[mode][0];  // number of mode notes
+	t.num_notes=0;                                                                
+	for (int i=1;i<127;++i)                                                         
+	{     
+		t.notes[i]=t.notes[i-1]+                                                    
+			mode_step_intervals[mode][((i-1)%nmn)+1];  
+		++t.num_notes;                                                            
+		if (t.notes[i]>=127) break;                                               
+	}     
+
+	const int* scale=t.modeNotes->root_key_notes[root_key];
+	int num_scale=t.modeNotes->num_root_key_notes[root_key];
+	int index=0;
+	for (int n=0; n<128; ++n)
+	{
+		while ((index+1<num_scale)&&(scale[index+1]<=n))
+			++index;
+		t.scale_note_index[n]=index;
+	}
+
+	t.notate_mode_as_signature_root_key=((root_key-(mode_natural_roots[mode_root_key_signature_offset[mode]]))+12)%12;
+	t.flats=((t.notate_mode_as_signature_root_key==1)   // Db
+	  ||(t.notate_mode_as_signature_root_key==3)   // Eb
+	  ||(t.notate_mode_as_signature_root_key==5)   // F
+	  ||(t.notate_mode_as_signature_root_key==8)   // Ab
+	  ||(t.notate_mode_as_signature_root_key==10)); // Bb
+}
+
+void ConstructDegreesSemicircle(KeyModeTable &t, int circleRootKey, int mode)
+{
+	if (doDebug)  DEBUG("ConstructDegreesSemicircle(%d, %d)", circleRootKey, mode);
+	CircleOf5ths geometry;  // only for the default radii and center
+	DegreeSemiCircle &semicircle=t.theDegreeSemiCircle;
+	const float rotate90 = (M_PI) / 2.0;
+	float offsetDegree=((circleRootKey-mode+12)%12)*(2.0*M_PI/12.0);
+	semicircle.OffsetSteps=(circleRootKey-mode); 
+	semicircle.RootKeyCircle5thsPosition=-semicircle.OffsetSteps+circleRootKey;
+
+	for (int i=0; i<MAX_CIRCLE_STATIONS; ++i)
+	{
+		t.circle_chord_type[i]=0;
+		t.circle_position_degree[i]=0;
+	}
+	for (int i=0; i<8; ++i)
+	{
+		t.arabicStepDegreeSemicircleIndex[i]=0;
+		t.degree_circle_position[i]=0;
+	}
+
+	int chord_type=0;
+	for (int i=0; i<MAX_HARMONIC_DEGREES; ++i)
+	{
+		DegreeElement &element=semicircle.degreeElements[i];
+
+		// construct degree annulus sector
+		element.startDegree = (M_PI * 2.0 * ((double)i - 0.5) / MAX_CIRCLE_STATIONS) - rotate90 + offsetDegree;
+		element.endDegree = (M_PI * 2.0 * ((double)i + 0.5) / MAX_CIRCLE_STATIONS) - rotate90 + offsetDegree;
+                        
+		double ax1= cos(element.startDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.x;
+		double ay1= sin(element.startDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.y;
+		double ax2= cos(element.endDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.x;
+		double ay2= sin(element.endDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.y;
+		double bx1= cos(element.startDegree) * geometry.OuterCircleRadius + geometry.CircleCenter.x;
+		double by1= sin(element.startDegree) * geometry.OuterCircleRadius + geometry.CircleCenter.y;
+		double bx2= cos(element.endDegree) * geometry.OuterCircleRadius + geometry.CircleCenter.x;
+		double by2= sin(element.endDegree) * geometry.OuterCircleRadius + geometry.CircleCenter.y;
+
+		element.pt1=Vec(ax1, ay1);
+		element.pt2=Vec(bx1, by1);
+		element.pt3=Vec(ax2, ay2);
+		element.pt4=Vec(bx2, by2);
+
+		Vec radialLine1=Vec(ax1,ay1).minus(geometry.CircleCenter);
+		Vec radialLine2=Vec(ax2,ay2).minus(geometry.CircleCenter);
+		Vec centerLine=(radialLine1.plus(radialLine2)).div(2.);
+		element.radialDirection=centerLine.normalize();
+
+		// set circle and degree elements correspondence interlinkage
+		element.CircleIndex=(semicircle.OffsetSteps+i+12)%12; 
+        
+		if((i == 0)||(i == 1)||(i == 2)) 
+			chord_type=0; // major
+		else
+		if((i == 3)||(i == 4)||(i == 5)) 
+			chord_type=1; // minor
+		else
+		if(i == 6)
+			chord_type=6; // diminished
+            
+		element.chordType=chord_type;
+		t.circle_chord_type[element.CircleIndex]=chord_type;
+		element.Degree=semiCircleDegrees[(i - semicircle.RootKeyCircle5thsPosition+7)%7]; 
+
+		if ((element.Degree>=1)&&(element.Degree<=7))
+		{
+			t.arabicStepDegreeSemicircleIndex[element.Degree]=i;
+			t.degree_circle_position[element.Degree]=element.CircleIndex;
+			t.circle_position_degree[element.CircleIndex]=element.Degree;
+		}
+	}
+}
+
+void init_chord_notes(ChordNotesTable &t, int root, int chordType)
+{
+	t.num_notes=0;
+	for (int octave=0; octave<10; ++octave)  // same 10 octaves root_key_notes covers
+	{
+		for (int k=0;k<chord_type_num_notes[chordType];++k)
+			t.notes[t.num_notes++]=root+12*octave+chord_type_intervals[chordType][k];
+	}
+
+	// if this is not done, the chord notes begin with the root note.   If done, chord spread is limited but smoother wandering through innversions
+	int skip=(11-root)/3;
+	for (int j=0;j+skip<t.num_notes;++j)
+		t.notes[j]=t.notes[j+skip];
+	t.num_notes-=skip;
+}
+
+void initKeyModeTables()
+{
+	if (doDebug) DEBUG("initKeyModeTables()");
+	for (int mode=0; mode<MAX_MODES; ++mode)
+		init_notes(theModeNotesTables[mode], mode);
+	for (int circleRootKey=0; circleRootKey<MAX_ROOT_KEYS; ++circleRootKey)
+	{
+		for (int mode=0; mode<MAX_MODES; ++mode)
+		{
+			KeyModeTable &t=theKeyModeTables[circleRootKey][mode];
+			t.modeNotes=&theModeNotesTables[mode];
+			ConstructDegreesSemicircle(t, circleRootKey, mode);
+			init_notes(t, circle_of_fifths[circleRootKey], mode);
+		}
+	}
+	for (int root=0; root<MAX_NOTES; ++root)
+	{
+		for (int chordType=0; chordType<MAX_CIRCLE_CHORD_TYPES; ++chordType)
+			init_chord_notes(theChordNotesTables[root][chordType], root, chordType);
+	}
+}
+
+// Higher order Markov chains.  The next step is conditioned on the last `order` steps, packed into one history number
+//   h = (s[t-order]*B + ... + s[t-2])*B + s[t-1],   B = num_symbols+1
+// where symbol num_symbols stands for "before the first step", so chains also learn how progressions begin.  The
+// symbols are the harmony steps of the preset playing the chain.  row_of_history[h] is the sampling row for h; a history
+// never seen in training was pointed at the row of its longest seen suffix when the chain was compiled, so there is no
+// backoff search at run time.  Each row is a Walker alias table, so a draw is one multiply, two loads and a select
+// whatever the order or number of symbols, and nothing is allocated once the chain is loaded.
+
+#define MAX_MARKOV_ORDER 3
+#define MAX_MARKOV_SYMBOLS MAX_STEPS
+
+struct MarkovChain
+{
+	std::string name;  // the file it was loaded from
+	int order=1;
+	int num_symbols=0;
+	int history_size=0;  // B^order
+	int history_modulus=0;  // B^(order-1), drops the oldest step from a history
+	int start_history=0;  // nothing played yet
+	std::vector<uint16_t> row_of_history;  // [history_size]
+	std::vector<float> alias_probability;  // [row*num_symbols+column] chance of keeping column rather than its alias
+	std::vector<uint8_t> alias_symbol;  // [row*num_symbols+column]
+
+	void setShape(int chainOrder, int symbols)
+	{
+		order=chainOrder;
+		num_symbols=symbols;
+		history_modulus=1;
+		for (int k=1; k<order; ++k)
+			history_modulus*=num_symbols+1;
+		history_size=history_modulus*(num_symbols+1);
+		start_history=history_size-1;
+	}
+
+	int nextHistory(int history, int symbol) const
+	{
+		return (history%history_modulus)*(num_symbols+1)+symbol;
+	}
+
+	int sample(int history, float rnd) const
+	{
+		int row=row_of_history[history]*num_symbols;
+		float scaled=rnd*num_symbols;
+		int column=std::min((int)scaled, num_symbols-1);
+		return (scaled-column<alias_probability[row+column]) ? column : alias_symbol[row+column];
+	}
+};
+
+// Weighted transition counts for every order up to a chain's order, the input to compileMarkovChain().
+// counts[k][hk*num_symbols+next] is the weight of next following the length k history hk (same encoding as above,
+// B^k histories), so counts[0] is just how often each symbol occurs.
+struct MarkovChainCounts
+{
+	int order=1;
+	int num_symbols=0;
+	std::vector<double> counts[MAX_MARKOV_ORDER+1];
+
+	void init(int chainOrder, int symbols)
+	{
+		order=chainOrder;
+		num_symbols=symbols;
+		int histories=1;
+		for (int k=0; k<=order; ++k)
+		{
+			counts[k].assign((size_t)histories*num_symbols, 0.);
+			histories*=num_symbols+1;
+		}
+	}
+
+	// history holds the last `order` symbols oldest first, num_symbols where there is no step yet
+	void add(const int* history, int next, double weight)
+	{
+		int hk=0;
+		int scale=1;
+		for (int k=0; k<=order; ++k)
+		{
+			counts[k][(size_t)hk*num_symbols+next]+=weight;
+			if (k<order)
+			{
+				hk+=history[order-1-k]*scale;
+				scale*=num_symbols+1;
+			}
+		}
+	}
+
+	void addSequence(const int* symbols, int length, double weight)
+	{
+		int history[MAX_MARKOV_ORDER];
+		for (int k=0; k<order; ++k)
+			history[k]=num_symbols;
+		for (int i=0; i<length; ++i)
+		{
+			add(history, symbols[i], weight);
+			for (int k=0; k+1<order; ++k)
+				history[k]=history[k+1];
+			history[order-1]=symbols[i];
+		}
+	}
+};
+
+// Vose's alias method, probabilities need not be normalized
+void buildAliasRow(const double* weights, int n, float* probability, uint8_t* alias)
+{
+	double total=0;
+	for (int i=0; i<n; ++i)
+		total+=weights[i];
+	double scaled[MAX_MARKOV_SYMBOLS];
+	int small[MAX_MARKOV_SYMBOLS], large[MAX_MARKOV_SYMBOLS];
+	int numSmall=0, numLarge=0;
+	for (int i=0; i<n; ++i)
+	{
+		scaled[i]=(total>0) ? weights[i]*n/total : 1.;
+		alias[i]=(uint8_t)i;
+		if (scaled[i]<1.)
+			small[numSmall++]=i;
+		else
+			large[numLarge++]=i;
+	}
+	while ((numSmall>0)&&(numLarge>0))
+	{
+		int less=small[--numSmall];
+		int more=large[--numLarge];
+		probability[less]=(float)scaled[less];
+		alias[less]=(uint8_t)more;
+		scaled[more]-=1.-scaled[less];
+		if (scaled[more]<1.)
+			small[numSmall++]=more;
+		else
+			large[numLarge++]=more;
+	}
+	while (numLarge>0)
+		probability[large[--numLarge]]=1.f;
+	while (numSmall>0)  // only rounding error left
+		probability[small[--numSmall]]=1.f;
+}
+
+bool compileMarkovChain(const MarkovChainCounts &counts, MarkovChain &chain)
+{
+	const int n=counts.num_symbols;
+	if ((counts.order<1)||(counts.order>MAX_MARKOV_ORDER)||(n<1)||(n>MAX_MARKOV_SYMBOLS))
+		return false;
+	chain.setShape(counts.order, n);
+	chain.row_of_history.assign(chain.history_size, 0);
+	chain.alias_probability.clear();
+	chain.alias_symbol.clear();
+
+	std::vector<int> rowOf[MAX_MARKOV_ORDER+1];  // row already built for an order k history, -1 if none yet
+	int histories=1;
+	for (int k=0; k<=chain.order; ++k)
+	{
+		rowOf[k].assign(histories, -1);
+		histories*=n+1;
+	}
+
+	for (int h=0; h<chain.history_size; ++h)
+	{
+		// longest suffix of h with any counts, down to the plain symbol frequencies
+		int k=chain.order;
+		int hk=h;
+		int modulus=chain.history_size;
+		for (; k>0; --k)
+		{
+			double total=0;
+			for (int i=0; i<n; ++i)
+				total+=counts.counts[k][(size_t)hk*n+i];
+			if (total>0)
+				break;
+			modulus/=n+1;
+			hk=h%modulus;
+		}
+		if (rowOf[k][hk]<0)
+		{
+			rowOf[k][hk]=(int)(chain.alias_probability.size()/n);
+			if (rowOf[k][hk]>65535)
+				return false;
+			chain.alias_probability.resize(chain.alias_probability.size()+n);
+			chain.alias_symbol.resize(chain.alias_symbol.size()+n);
+			buildAliasRow(&counts.counts[k][(size_t)hk*n], n, &chain.alias_probability[(size_t)rowOf[k][hk]*n], &chain.alias_symbol[(size_t)rowOf[k][hk]*n]);
+		}
+		chain.row_of_history[h]=(uint16_t)rowOf[k][hk];
+	}
+	return true;
+}
+
+// Compiled chain file, little endian, loaded straight into MarkovChain:
+//   "MNDRMKV1", int32 order, int32 num_symbols, int32 num_rows,
+//   uint16 row_of_history[B^order], float alias_probability[num_rows*num_symbols], uint8 alias_symbol[num_rows*num_symbols]
+static const char markov_chain_magic[8]={'M','N','D','R','M','K','V','1'};
+
+bool saveMarkovChain(const MarkovChain &chain, const std::string &path)
+{
+	FILE* file=fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+	int32_t header[3]={chain.order, chain.num_symbols, (int32_t)(chain.alias_probability.size()/chain.num_symbols)};
+	bool ok=(fwrite(markov_chain_magic, sizeof(markov_chain_magic), 1, file)==1)
+		&& (fwrite(header, sizeof(header), 1, file)==1)
+		&& (fwrite(chain.row_of_history.data(), sizeof(uint16_t), chain.row_of_history.size(), file)==chain.row_of_history.size())
+		&& (fwrite(chain.alias_probability.data(), sizeof(float), chain.alias_probability.size(), file)==chain.alias_probability.size())
+		&& (fwrite(chain.alias_symbol.data(), 1, chain.alias_symbol.size(), file)==chain.alias_symbol.size());
+	return (fclose(file)==0)&&(ok);
+}
+
+std::list<MarkovChain> theMarkovChains;  // never freed, presets point at their chain
+
+// Each file is read once.  Returns nullptr if it is not a valid chain file.
+const MarkovChain* loadMarkovChain(const std::string &path)
+{
+	for (const MarkovChain &chain : theMarkovChains)
+		if (chain.name==path)
+			return &chain;
+
+	FILE* file=fopen(path.c_str(), "rb");
+	if (!file)
+		return nullptr;
+	MarkovChain chain;
+	chain.name=path;
+	char magic[sizeof(markov_chain_magic)];
+	int32_t header[3];
+	bool ok=(fread(magic, sizeof(magic), 1, file)==1)&&(memcmp(magic, markov_chain_magic, sizeof(magic))==0)
+		&& (fread(header, sizeof(header), 1, file)==1)
+		&& (header[0]>=1)&&(header[0]<=MAX_MARKOV_ORDER)&&(header[1]>=1)&&(header[1]<=MAX_MARKOV_SYMBOLS)&&(header[2]>=1)&&(header[2]<=65536);
+	if (ok)
+	{
+		chain.setShape(header[0], header[1]);
+		size_t entries=(size_t)header[2]*header[1];
+		chain.row_of_history.resize(chain.history_size);
+		chain.alias_probability.resize(entries);
+		chain.alias_symbol.resize(entries);
+		ok=(fread(chain.row_of_history.data(), sizeof(uint16_t), chain.row_of_history.size(), file)==chain.row_of_history.size())
+			&& (fread(chain.alias_probability.data(), sizeof(float), entries, file)==entries)
+			&& (fread(chain.alias_symbol.data(), 1, entries, file)==entries);
+		for (size_t i=0; (ok)&&(i<chain.row_of_history.size()); ++i)
+			ok=(chain.row_of_history[i]<header[2]);
+		for (size_t i=0; (ok)&&(i<entries); ++i)
+			ok=(chain.alias_symbol[i]<header[1])&&(chain.alias_probability[i]>=0.f)&&(chain.alias_probability[i]<=1.f);
+	}
+	fclose(file);
+	if (!ok)
+		return nullptr;
+	if (doDebug)  DEBUG("loaded order %d Markov chain over %d steps from %s", chain.order, chain.num_symbols, path.c_str());
+	theMarkovChains.push_back(chain);
+	return &theMarkovChains.back();
+}
+
+// Harmony presets are data: one preset per line, the same format for the built-in bank below and for user bank files
+//   description | degrees description | steps [| progression]
+// steps are up to MAX_STEPS scale degrees 1-7, with a 7 appended to always play that step as a 7th chord ("57" is V7).
+// progression is "random home", "random" or "markov <matrix>", and the steps are played in order if it is left out.
+// matrix is a built-in name from initMarkovMatrices() or a .json matrix file (see loadMarkovMatrix()), both with
+// exactly 7 steps, or a .mkc chain file (see loadMarkovChain()) with as many steps as the chain has symbols.  Files are
+// relative to the bank file.  Blank lines and lines starting with # are skipped.  A bank is parsed once; selecting a preset only copies it, and setup_harmony()
+// maps its degrees onto the circle for the current key and mode.
+
+constexpr const char* builtin_harmony_presets[]={
+	"50's Classic R&R do-wop and jazz | I - VI - II - V | 1 6 2 5",  // 1
+	"elem.. classical 1 | I - IV - I - V | 1 4 1 5",  // 2
+	"romantic - alt root_keys | I - IV - V - I - VI - II - III - VI | 1 4 5 1 6 2 3 6",  // 3
+	"custom |  | 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1",  // 4
+	"the classic  I - IV - V | I - IV - V - I | 1 4 5 1",  // 5
+	"elem. classical 3 | I - IV - V - IV | 1 4 5 4",  // 6
+	"strong return by 4ths | I - III - VI - IV - V | 1 3 6 4 5",  // 7
+	"stay on I | I | 1",  // 8
+	"harmonic+ CW 5ths | I - V - II - VI - III - VII - IV | 2 6 3 7 4 1 5",  // 9
+	"circle- CCW up by 4ths | I - IV - VII - III - VI - II - V | 1 5 1 4 7 3 6",  // 10
+	"tonal+ | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7",  // 11
+	"tonal- | I - VII - VI - V - IV - III - II | 1 7 6 5 4 3 2",  // 12
+	"12 bar blues 1 traditional | I - I - I - I - IV - IV - I - I - V - V - I - I | 1 1 1 1 4 4 1 1 5 5 1 1",  // 13
+	"12 bar blues 2 shuffle | I - I - I - I - IV - IV - I - I - V - IV - I - I | 1 1 1 1 4 4 1 1 5 4 1 1",  // 14
+	"country 1 | I - IV - V - I - I - IV - V - I | 1 4 5 1 1 4 5 1",  // 15
+	"country 2 | I - I - V - V - IV - IV - I - I | 1 1 5 5 4 4 1 1",  // 16
+	"country 3 | I - IV - I - V - I - IV - V - I | 1 4 1 5 1 4 5 1",  // 17
+	"50's R&R | I - VI - IV - V | 1 6 4 5",  // 18
+	"rock | I - IV | 1 4",  // 19
+	"folk 1 | I - V - I - V | 1 5 1 5",  // 20
+	"folk 2 | I - I - I - V - V - V - I | 1 1 1 5 5 5 5 1",  // 21
+	"random coming home by 4ths | I - VI - II - V | 1 3 6 2 5 | random home",  // 22
+	"random order | I - IV - V | 1 4 5 | random",  // 23
+	"Hallelujah | I - VI - I - VI - IV - V - I - I - I - IV - V - VI - IV - V - III - VI | 1 6 1 6 4 5 1 1 1 4 5 6 4 5 3 6",  // 24
+	"Canon - DMaj | I - V - VI - III - IV - I - IV - V | 1 5 6 3 4 1 4 5",  // 25
+	"Pop Rock Classic Sensitive | I - V - VI - IV | 1 5 6 4",  // 26
+	"Andalusion Cadence 1 | I - VII - VI - V | 1 7 6 5",  // 27
+	"16 Bar Blues | I - I - I - I - I - I - I - I - IV - IV - I - I - V - IV - I - I | 1 1 1 1 1 1 1 1 4 4 1 1 5 4 1 1",  // 28
+	"Black Stones | I - VII - III - VII - I - I - I - I - I - VII - III - VII - IV - IV - V - V | 1 7 3 7 1 1 1 1 1 7 3 7 4 4 5 5",  // 29
+	"V - I | V - I | 5 1",  // 30
+	"Markov Chain-Bach 1 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Bach1",  // 31
+	"Pop | I - II - IV - V | 1 2 4 5",  // 32
+	"Classical | I - V - I - VI - II - V - I | 1 5 1 6 2 5 1",  // 33
+	"Mozart | I - II - V - I | 1 2 5 1",  // 34
+	"Classical Tonal | I - V - I - IV | 1 5 1 4",  // 35
+	"Sensitive | VI - IV - I - V | 6 4 1 5",  // 36
+	"Jazz | II - V - I | 2 5 1",  // 37
+	"Pop and jazz | I - IV - II - V | 1 4 2 5",  // 38
+	"Pop | I - II - III - IV - V | 1 2 3 4 5",  // 39
+	"Pop | I - III - IV - IV | 1 3 4 4",  // 40
+	"Andalusian Cadence 2 | VI - V - IV - III | 6 5 4 3",  // 41
+	"Markov Chain - Bach 2 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Bach2",  // 42
+	"Markov Chain-Mozart 1 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Mozart1",  // 43
+	"Markov Chain-Mozart 2 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Mozart2",  // 44
+	"Markov Chain-Palestrina 1 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Palestrina1",  // 45
+	"Markov Chain-Beethoven 1 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Beethoven1",  // 46
+	"Markov Chain-Traditional 1 | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov Traditional1",  // 47
+	"Markov Chain- I - IV - V | I - II - III - IV - V - VI - VII | 1 2 3 4 5 6 7 | markov I_IV_V",  // 48
+	"Jazz 2 | I - VI - II - V | 1 6 2 5",  // 49
+	"Jazz 3 | III - VI - II - V | 3 6 2 5",  // 50
+	"Jazz 4 | I - IV - III - VI | 1 4 3 6",  // 51
+	"I-VI alt maj/ rel. min | I - VI | 1 6",  // 52
+	"12 bar blues variation 1 | I - I - I - I - IV - IV - I - I - V - IV - I - V | 1 1 1 1 4 4 1 1 5 4 1 5",  // 53
+	"12 bar blues variation 2 | I - I - I - I - IV - IV - I - I - IV - V - I - V | 1 1 1 1 4 4 1 1 4 5 1 5",  // 54
+	"12 bar blues turnaround 1 | I - IV - I - I - IV - IV - I - I - V - IV - I - V | 1 4 1 1 4 4 1 1 5 4 1 5",  // 55
+	"8 bar blues traditional | I - V - IV - IV - I - V - I - V | 1 5 4 4 1 5 1 5",  // 56
+	"8 bar blues variation 1 | I - I - I - I - IV - IV - V - I | 1 1 1 1 4 4 5 1",  // 57
+	"8 bar blues variation 2 | I - I - I - I - IV - IV - V - V | 1 1 1 1 4 4 5 5",  // 58
+	"II - V - I cadential | II - V - I | 2 5 1",  // 59
+};
+
+struct HarmonyPresetBank
+{
+	std::string path;  // empty for the built-in bank
+	std::vector<HarmonyType> presets;  // [0] is unused so preset numbers stay 1 based
+
+	int size() const { return (int)presets.size()-1; }
+};
+
+HarmonyPresetBank theBuiltinHarmonyPresetBank;
+std::list<HarmonyPresetBank> theUserHarmonyPresetBanks;  // loaded on demand and never freed, since engines point into them
+
+// copy one '|' separated field with the surrounding blanks trimmed, returns the start of the next field or nullptr
+const char* parseHarmonyPresetField(const char* text, char* field, int size)
+{
+	while ((*text==' ')||(*text=='\t'))
+		++text;
+	const char* end=text;
+	while ((*end!='|')&&(*end!='\0')&&(*end!='\r')&&(*end!='\n'))
+		++end;
+	const char* next=(*end=='|') ? end+1 : nullptr;
+	while ((end>text)&&((end[-1]==' ')||(end[-1]=='\t')))
+		--end;
+	snprintf(field, size, "%.*s", (int)(end-text), text);
+	return next;
+}
+
+bool parseHarmonyPreset(const char* line, HarmonyType &preset, const std::string &directory)
+{
+	char steps[256];
+	char progression[64]="";
+
+	while ((*line==' ')||(*line=='\t'))
+		++line;
+	if ((*line=='#')||(*line=='\0')||(*line=='\r')||(*line=='\n'))
+		return false;
+
+	preset=HarmonyType();
+	const char* next=parseHarmonyPresetField(line, preset.harmony_type_desc, sizeof(preset.harmony_type_desc));
+	if (next)
+		next=parseHarmonyPresetField(next, preset.harmony_degrees_desc, sizeof(preset.harmony_degrees_desc));
+	if (!next)
+		return false;
+	next=parseHarmonyPresetField(next, steps, sizeof(steps));
+	if (next)
+		parseHarmonyPresetField(next, progression, sizeof(progression));
+
+	int num_steps=0;
+	char* text=steps;
+	while (num_steps<MAX_STEPS)
+	{
+		char* end;
+		long degree=strtol(text, &end, 10);
+		if (end==text)
+			break;
+		bool seventh=((degree>10)&&(degree%10==7));
+		if (seventh)
+			degree/=10;
+		if ((degree<1)||(degree>MAX_HARMONIC_DEGREES))
+			return false;
+		preset.harmony_step_seventh[num_steps]=seventh;
+		preset.harmony_steps[num_steps++]=(int)degree;
+		text=end;
+	}
+	if (num_steps==0)
+		return false;
+	preset.num_harmony_steps=num_steps;
+	preset.min_steps=1;
+	preset.max_steps=num_steps;
+
+	if (strcmp(progression, "random home")==0)
+		preset.progression=PROGRESSION_RANDOM_COMING_HOME;
+	else
+	if (strcmp(progression, "random")==0)
+		preset.progression=PROGRESSION_RANDOM_ORDER;
+	else
+	if (strncmp(progression, "markov ", 7)==0)
+	{
+		std::string name=progression+7;
+		std::string file=((directory.empty())||(name[0]=='/')) ? name : directory+"/"+name;
+		if ((name.size()>4)&&(name.compare(name.size()-4, 4, ".mkc")==0))
+		{
+			preset.markov_chain=loadMarkovChain(file);
+			if ((!preset.markov_chain)||(num_steps!=preset.markov_chain->num_symbols))  // the steps are the chain's symbols
+				return false;
+			preset.progression=PROGRESSION_MARKOV_CHAIN;
+			return true;
+		}
+		for (const MarkovMatrix &matrix : theMarkovMatrices)
+			if (matrix.name==name)
+				preset.markov_matrix=&matrix;
+		if ((!preset.markov_matrix)&&(name.size()>5)&&(name.compare(name.size()-5, 5, ".json")==0))
+			preset.markov_matrix=loadMarkovMatrix(file);
+		if ((!preset.markov_matrix)||(num_steps!=MAX_HARMONIC_DEGREES))  // the steps are the matrix rows
+			return false;
+		preset.progression=PROGRESSION_MARKOV;
+	}
+	else
+	if (progression[0]!='\0')
+		return false;
+	return true;
+}
+
+void addHarmonyPreset(HarmonyPresetBank &bank, const char* line, const std::string &directory)
+{
+	HarmonyType preset;
+	if (parseHarmonyPreset(line, preset, directory))
+	{
+		preset.harmony_type=bank.size()+1;
+		bank.presets.push_back(preset);
+	}
+	else
+	if (doDebug)  DEBUG("harmony preset skipped: %s", line);
+}
+
+void init_harmony(HarmonyPresetBank &bank)
+{
+	if (doDebug)  DEBUG("init_harmony");
+	bank.presets.assign(1, HarmonyType());
+	for (const char* line : builtin_harmony_presets)
+		addHarmonyPreset(bank, line, "");
+}
+
+// Parse a user bank file once.  Later requests for the same file get the same bank, nullptr if it has no valid presets.
+const HarmonyPresetBank* loadHarmonyPresetBank(const std::string &path)
+{
+	for (const HarmonyPresetBank &bank : theUserHarmonyPresetBanks)
+		if (bank.path==path)
+			return &bank;
+
+	FILE* file=fopen(path.c_str(), "r");
+	if (!file)
+		return nullptr;
+	HarmonyPresetBank bank;
+	bank.path=path;
+	bank.presets.assign(1, HarmonyType());
+	size_t slash=path.find_last_of("/\\");
+	std::string directory=(slash==std::string::npos) ? "" : path.substr(0, slash);
+	char line[512];
+	while (fgets(line, sizeof(line), file))
+		addHarmonyPreset(bank, line, directory);
+	fclose(file);
+	if (bank.size()<1)
+		return nullptr;
+	if (doDebug)  DEBUG("loaded %d harmony presets from %s", bank.size(), path.c_str());
+	theUserHarmonyPresetBanks.push_back(bank);
+	return &theUserHarmonyPresetBanks.back();
+}
+
+// Circle of 5ths geometry does not depend on key or mode, so it is computed once and copied by each instance
+void ConstructCircle5ths(CircleElement Circle5ths[])
+{
+	if (doDebug)  DEBUG("ConstructCircle5ths()");
+	CircleOf5ths geometry;  // only for the default radii and center
+
+	for (int i=0; i<MAX_CIRCLE_STATIONS; ++i)
+	{
+		const float rotate90 = (M_PI) / 2.0;
+                        
+		// construct root_key annulus sector
+                        
+		Circle5ths[i].startDegree = (M_PI * 2.0 * ((double)i - 0.5) / MAX_CIRCLE_STATIONS) - rotate90;
+		Circle5ths[i].endDegree = 	(M_PI * 2.0 * ((double)i + 0.5) / MAX_CIRCLE_STATIONS) - rotate90;
+                    
+		double ax1= cos(Circle5ths[i].startDegree) * geometry.InnerCircleRadius + geometry.CircleCenter.x;
+		double ay1= sin(Circle5ths[i].startDegree) * geometry.InnerCircleRadius + geometry.CircleCenter.y;
+		double ax2= cos(Circle5ths[i].endDegree) * geometry.InnerCircleRadius + geometry.CircleCenter.x;
+		double ay2= sin(Circle5ths[i].endDegree) * geometry.InnerCircleRadius + geometry.CircleCenter.y;
+		double bx1= cos(Circle5ths[i].startDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.x;
+		double by1= sin(Circle5ths[i].startDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.y;
+		double bx2= cos(Circle5ths[i].endDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.x;
+		double by2= sin(Circle5ths[i].endDegree) * geometry.MiddleCircleRadius + geometry.CircleCenter.y;
+
+		Circle5ths[i].pt1=Vec(ax1, ay1);
+		Circle5ths[i].pt2=Vec(bx1, by1);
+		Circle5ths[i].pt3=Vec(ax2, ay2);
+		Circle5ths[i].pt4=Vec(bx2, by2);
+
+		Vec radialLine1=Vec(ax1,ay1).minus(geometry.CircleCenter);
+		Vec radialLine2=Vec(ax2,ay2).minus(geometry.CircleCenter);
+		Vec centerLine=(radialLine1.plus(radialLine2)).div(2.);
+		Circle5ths[i].radialDirection=centerLine.normalize();
+	}		
+}
+
+
+void init_vars()
+{
+	if (doDebug) DEBUG("init_vars()");
+
+	initPerlin();  // the noise gradients are shared, each engine hashes with its own NoiseContext
+
+	ConstructCircle5ths(theDefaultCircle5ths);
+	initMarkovMatrices();
+	init_harmony(theBuiltinHarmonyPresetBank);
+	initKeyModeTables();
+}
+
+// Counter based random numbers.  Rather than stepping a generator, each draw hashes its own coordinates
+// (seed, bar, 32nd note tick, part, draw number within the tick), so any draw can be recomputed in O(1) without
+// replaying what came before.  The mixing is two rounds of the splitmix64 finalizer.
+
+enum RandomParts
+{
+	RANDOM_PART_HARMONY,
+	RANDOM_PART_MELODY,
+	RANDOM_PART_ARP,
+	RANDOM_PART_BASS,
+	NUM_RANDOM_PARTS
+};
+
+inline uint64_t counterRandomMix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+inline uint64_t counterRandom(uint64_t seed, uint32_t bar, uint32_t tick, uint32_t part, uint32_t draw)
+{
+	uint64_t counter = ((uint64_t)bar << 32) | ((uint64_t)(tick & 0xffff) << 16) | ((part & 0xff) << 8) | (draw & 0xff);
+	return counterRandomMix(counterRandomMix(seed + 0x9e3779b97f4a7c15ULL) ^ (counter * 0x9e3779b97f4a7c15ULL));
+}
+
+inline float counterRandomUniform(uint64_t seed, uint32_t bar, uint32_t tick, uint32_t part, uint32_t draw)
+{
+	return (counterRandom(seed, bar, tick, part, draw) >> 40) / 16777216.f;  // 24 bits, [0,1)
+}
+
+// All of the per-instance musical state.  Each Meander module owns one of these, so any number of Meander
+// instances can run side by side.  Read-only theory tables above are shared and are built once by init_vars().
+struct MeanderEngine
+{
+	enum ParamIds 
+	{
+		BUTTON_RUN_PARAM,
+		BUTTON_RESET_PARAM,
+
+		CONTROL_TEMPOBPM_PARAM,
+		CONTROL_TIMESIGNATURETOP_PARAM,
+		CONTROL_TIMESIGNATUREBOTTOM_PARAM,
+
+		CONTROL_ROOT_KEY_PARAM,
+		CONTROL_SCALE_PARAM,
+
+		BUTTON_CIRCLESTEP_C_PARAM,
+		BUTTON_CIRCLESTEP_G_PARAM,
+		BUTTON_CIRCLESTEP_D_PARAM,
+		BUTTON_CIRCLESTEP_A_PARAM,
+		BUTTON_CIRCLESTEP_E_PARAM,
+		BUTTON_CIRCLESTEP_B_PARAM,
+		BUTTON_CIRCLESTEP_GBFS_PARAM,
+		BUTTON_CIRCLESTEP_DB_PARAM,
+		BUTTON_CIRCLESTEP_AB_PARAM,
+		BUTTON_CIRCLESTEP_EB_PARAM,
+		BUTTON_CIRCLESTEP_BB_PARAM,
+		BUTTON_CIRCLESTEP_F_PARAM,
+
+	
+		BUTTON_HARMONY_SETSTEP_1_PARAM,
+		BUTTON_HARMONY_SETSTEP_2_PARAM,
+		BUTTON_HARMONY_SETSTEP_3_PARAM,
+		BUTTON_HARMONY_SETSTEP_4_PARAM,
+		BUTTON_HARMONY_SETSTEP_5_PARAM,
+		BUTTON_HARMONY_SETSTEP_6_PARAM,
+		BUTTON_HARMONY_SETSTEP_7_PARAM,
+		BUTTON_HARMONY_SETSTEP_8_PARAM,
+		BUTTON_HARMONY_SETSTEP_9_PARAM,
+		BUTTON_HARMONY_SETSTEP_10_PARAM,
+		BUTTON_HARMONY_SETSTEP_11_PARAM,
+		BUTTON_HARMONY_SETSTEP_12_PARAM,
+		BUTTON_HARMONY_SETSTEP_13_PARAM,
+		BUTTON_HARMONY_SETSTEP_14_PARAM,
+		BUTTON_HARMONY_SETSTEP_15_PARAM,
+		BUTTON_HARMONY_SETSTEP_16_PARAM,
+
+		BUTTON_ENABLE_MELODY_PARAM,
+		CONTROL_MELODY_VOLUME_PARAM,
+		BUTTON_MELODY_DESTUTTER_PARAM,
+		CONTROL_MELODY_NOTE_LENGTH_DIVISOR_PARAM,
+		CONTROL_MELODY_TARGETOCTAVE_PARAM,
+		CONTROL_MELODY_ALPHA_PARAM,
+		CONTROL_MELODY_RANGE_PARAM,
+
+
+		BUTTON_ENABLE_ARP_PARAM,
+		CONTROL_ARP_COUNT_PARAM,
+		CONTROL_ARP_INCREMENT_PARAM,
+		CONTROL_ARP_DECAY_PARAM,
+		CONTROL_ARP_PATTERN_PARAM,
+		BUTTON_ENABLE_ARP_CHORDAL_PARAM,
+		BUTTON_ENABLE_ARP_SCALER_PARAM,
+
+
+		BUTTON_ENABLE_HARMONY_PARAM,
+		BUTTON_HARMONY_DESTUTTER_PARAM,
+		CONTROL_HARMONY_VOLUME_PARAM,
+		CONTROL_HARMONY_STEPS_PARAM,
+		CONTROL_HARMONY_TARGETOCTAVE_PARAM,
+		CONTROL_HARMONY_ALPHA_PARAM,
+		CONTROL_HARMONY_RANGE_PARAM,
+		CONTROL_HARMONY_DIVISOR_PARAM,
+		CONTROL_HARMONYPRESETS_PARAM,
+
+		BUTTON_ENABLE_BASS_PARAM,
+		CONTROL_BASS_VOLUME_PARAM,
+		CONTROL_BASS_TARGETOCTAVE_PARAM,
+		BUTTON_BASS_ACCENT_PARAM,
+		BUTTON_BASS_SYNCOPATE_PARAM,
+		BUTTON_BASS_SHUFFLE_PARAM,
+		CONTROL_BASS_DIVISOR_PARAM,
+
+				
+		CONTROL_HARMONY_FBM_OCTAVES_PARAM,
+		CONTROL_MELODY_FBM_OCTAVES_PARAM,
+		CONTROL_ARP_FBM_OCTAVES_PARAM,
+
+		CONTROL_HARMONY_FBM_PERIOD_PARAM,
+		CONTROL_MELODY_FBM_PERIOD_PARAM,
+		CONTROL_ARP_FBM_PERIOD_PARAM,
+
+		BUTTON_ENABLE_MELODY_CHORDAL_PARAM,
+		BUTTON_ENABLE_MELODY_SCALER_PARAM,
+
+		BUTTON_ENABLE_HARMONY_ALL7THS_PARAM,
+		BUTTON_ENABLE_HARMONY_V7THS_PARAM,
+
+		BUTTON_ENABLE_HARMONY_STACCATO_PARAM,
+		BUTTON_ENABLE_MELODY_STACCATO_PARAM,
+		BUTTON_ENABLE_BASS_STACCATO_PARAM,
+
+		BUTTON_BASS_OCTAVES_PARAM,
+
+		BUTTON_PROG_STEP_PARAM,
+				
+		
+		NUM_PARAMS
+	};
+
+	enum InputIds 
+	{
+		IN_RUN_EXT_CV,
+		IN_RESET_EXT_CV,
+		IN_TEMPO_EXT_CV,
+		IN_TIMESIGNATURETOP_EXT_CV,
+		IN_TIMESIGNATUREBOTTOM_EXT_CV,
+		IN_ROOT_KEY_EXT_CV,
+		IN_SCALE_EXT_CV,
+		IN_CLOCK_EXT_CV,
+		IN_HARMONY_CIRCLE_DEGREE_EXT_CV,
+		IN_HARMONY_CIRCLE_DEGREE_GATE_EXT_CV,
+
+		
+		IN_MELODY_ENABLE_EXT_CV,			
+		IN_MELODY_VOLUME_EXT_CV,
+		IN_MELODY_DESTUTTER_EXT_CV,
+		IN_MELODY_NOTE_LENGTH_DIVISOR_EXT_CV,
+		IN_MELODY_TARGETOCTAVE_EXT_CV,
+		IN_MELODY_ALPHA_EXT_CV,
+		IN_MELODY_RANGE_EXT_CV,
+
+		IN_ARP_ENABLE_EXT_CV,
+		IN_ARP_COUNT_EXT_CV,
+		IN_ARP_INCREMENT_EXT_CV,
+		IN_ARP_DECAY_EXT_CV,
+		IN_ARP_PATTERN_EXT_CV,
+		IN_ENABLE_ARP_CHORDAL_EXT_CV,
+		IN_ENABLE_ARP_SCALER_EXT_CV,
+
+
+		IN_HARMONY_ENABLE_EXT_CV,
+		IN_HARMONY_DESTUTTER_EXT_CV,
+		IN_HARMONY_VOLUME_EXT_CV,
+		IN_HARMONY_STEPS_EXT_CV,
+		IN_HARMONY_TARGETOCTAVE_EXT_CV,
+		IN_HARMONY_ALPHA_EXT_CV,
+		IN_HARMONY_RANGE_EXT_CV,
+		IN_HARMONY_DIVISOR_EXT_CV,
+		IN_HARMONYPRESETS_EXT_CV,
+
+		IN_BASS_ENABLE_EXT_CV,
+		IN_BASS_VOLUME_EXT_CV,
+		IN_BASS_TARGETOCTAVE_EXT_CV,
+		IN_BASS_ACCENT_EXT_CV,
+		IN_BASS_SYNCOPATE_EXT_CV,
+		IN_BASS_SHUFFLE_EXT_CV,
+		IN_BASS_DIVISOR_EXT_CV,
+
+				
+		IN_HARMONY_FBM_OCTAVES_EXT_CV,
+		IN_MELODY_FBM_OCTAVES_EXT_CV,
+		IN_ARP_FBM_OCTAVES_EXT_CV,
+
+		IN_HARMONY_FBM_PERIOD_EXT_CV,
+		IN_MELODY_FBM_PERIOD_EXT_CV,
+		IN_ARP_FBM_PERIOD_EXT_CV,
+
+		IN_ENABLE_MELODY_CHORDAL_EXT_CV,
+		IN_MELODY_SCALER_EXT_CV,
+
+		IN_ENABLE_HARMONY_ALL7THS_EXT_CV,
+		IN_ENABLE_HARMONY_V7THS_EXT_CV,
+
+		IN_ENABLE_HARMONY_STACCATO_EXT_CV,
+		IN_ENABLE_MELODY_STACCATO_EXT_CV,
+		IN_ENABLE_BASS_STACCATO_EXT_CV,
+
+		IN_BASS_OCTAVES_EXT_CV,
+
+		IN_PROG_STEP_EXT_CV,
+
+		IN_MELODY_SCALE_DEGREE_EXT_CV,
+		IN_MELODY_SCALE_GATE_EXT_CV,
+				
+
+		NUM_INPUTS
+		
+	};
+	
+	
+
+	enum OutputIds 
+	{
+		OUT_RUN_OUT,
+		OUT_RESET_OUT,
+		OUT_TEMPO_OUT,
+		OUT_CLOCK_OUT, 
+		OUT_MELODY_GATE_OUTPUT,
+		OUT_HARMONY_GATE_OUTPUT,
+		OUT_BASS_GATE_OUTPUT,
+		OUT_FBM_HARMONY_OUTPUT,
+		OUT_MELODY_CV_OUTPUT,
+		OUT_FBM_MELODY_OUTPUT,
+		OUT_BASS_CV_OUTPUT,
+		OUT_HARMONY_CV_OUTPUT,
+		OUT_CLOCK_BEATX2_OUTPUT,
+		OUT_CLOCK_BAR_OUTPUT,
+		OUT_CLOCK_BEATX4_OUTPUT,
+		OUT_CLOCK_BEATX8_OUTPUT,
+		OUT_CLOCK_BEAT_OUTPUT,
+		OUT_BASS_TRIGGER_OUTPUT,
+		OUT_HARMONY_TRIGGER_OUTPUT,
+		OUT_MELODY_TRIGGER_OUTPUT,
+		OUT_FBM_ARP_OUTPUT,
+		OUT_MELODY_VOLUME_OUTPUT,
+		OUT_HARMONY_VOLUME_OUTPUT,
+		OUT_BASS_VOLUME_OUTPUT,
+		OUT_EXT_POLY_SCALE_OUTPUT,
+	
+		NUM_OUTPUTS
+	};
+
+	enum LightIds 
+	{
+		LIGHT_LEDBUTTON_HARMONY_ENABLE,
+		LIGHT_LEDBUTTON_MELODY_ENABLE,
+		LIGHT_LEDBUTTON_ARP_ENABLE,
+		LIGHT_LEDBUTTON_ARP_ENABLE_CHORDAL,
+		LIGHT_LEDBUTTON_ARP_ENABLE_SCALER,
+		LIGHT_LEDBUTTON_BASS_ENABLE,
+		LIGHT_LEDBUTTON_RUN,
+		LIGHT_LEDBUTTON_RESET,
+		LIGHT_LEDBUTTON_MELODY_DESTUTTER,
+		LIGHT_LEDBUTTON_CIRCLESTEP_1,
+		LIGHT_LEDBUTTON_CIRCLESTEP_2,
+		LIGHT_LEDBUTTON_CIRCLESTEP_3,
+		LIGHT_LEDBUTTON_CIRCLESTEP_4,
+		LIGHT_LEDBUTTON_CIRCLESTEP_5,
+		LIGHT_LEDBUTTON_CIRCLESTEP_6,
+		LIGHT_LEDBUTTON_CIRCLESTEP_7,
+		LIGHT_LEDBUTTON_CIRCLESTEP_8,
+		LIGHT_LEDBUTTON_CIRCLESTEP_9,
+		LIGHT_LEDBUTTON_CIRCLESTEP_10,
+		LIGHT_LEDBUTTON_CIRCLESTEP_11,
+		LIGHT_LEDBUTTON_CIRCLESTEP_12,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_1_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_2_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_3_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_4_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_5_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_6_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_7_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_8_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_9_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_10_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_11_LIGHT,
+		LIGHT_CIRCLE_ROOT_KEY_POSITION_12_LIGHT,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_1,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_2,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_3,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_4,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_5,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_6,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_7,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_8,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_9,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_10,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_11,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_12,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_13,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_14,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_15,
+		LIGHT_LEDBUTTON_CIRCLESETSTEP_16,
+		LIGHT_CLOCK_IN_LIGHT,
+		LIGHT_LEDBUTTON_MELODY_ENABLE_CHORDAL,
+		LIGHT_LEDBUTTON_MELODY_ENABLE_SCALER,
+
+		LIGHT_LEDBUTTON_ENABLE_HARMONY_ALL7THS_PARAM,
+		LIGHT_LEDBUTTON_ENABLE_HARMONY_V7THS_PARAM,
+		LIGHT_LEDBUTTON_BASS_SYNCOPATE_PARAM,
+		LIGHT_LEDBUTTON_BASS_ACCENT_PARAM,
+		LIGHT_LEDBUTTON_BASS_SHUFFLE_PARAM,
+
+		LIGHT_LEDBUTTON_ENABLE_HARMONY_STACCATO_PARAM,
+		LIGHT_LEDBUTTON_ENABLE_MELODY_STACCATO_PARAM,
+		LIGHT_LEDBUTTON_ENABLE_BASS_STACCATO_PARAM,
+
+		LIGHT_LEDBUTTON_BASS_OCTAVES_PARAM,
+
+		LIGHT_LEDBUTTON_PROG_STEP_PARAM,
+		
+		NUM_LIGHTS
+	};
+
+	// Output hooks.  The generators only ever talk to the outside world through these, the Rack module routes them
+	// to its ports, lights and gate pulses, and headless hosts can record them.
+	virtual void setOutputChannels(int outputId, int channels) {}
+	virtual void setOutputVoltage(int outputId, float voltage, int channel=0) {}
+	virtual void setLightBrightness(int lightId, float brightness) {}
+	virtual void triggerGate(int outputId, float duration) {}  // duration in seconds
+	virtual void resetGate(int outputId) {}
+	virtual void triggerClockPulse(int division) {}  // 1=bar, 2, 4, 8, 16, 32=32nd note
+	virtual void onNotePlayed(const struct note &playedNote) {}
+
+	virtual ~MeanderEngine() {}
+
+	bool globalsInitialized=false;  // set by MeanderMusicStructuresInitialize(), prevents process() and the panel from using this state before then
+
+	struct inPortState inportStates[MAX_INPORTS];
+
+	int time_sig_top = 4;
+	int time_sig_bottom = 4;
+
+	CircleOf5ths theCircleOf5ths;
+
+	MeanderProfiler profiler;  // section timers, off unless turned on from the menu
+
+	bool circleChanged=true;
+	int harmonyPresetChanged=0; 
+
+	const KeyModeTable* theKeyModeTable=&theKeyModeTables[0][1];  // current root_key and mode, see selectKeyModeTables()
+
+	const int* arabicStepDegreeSemicircleIndex=theKeyModeTable->arabicStepDegreeSemicircleIndex;  // where is 1, 2... step in degree semicircle  // [8] so 1 based indexing can be used
+
+	int  mode=1;  // Ionian/Major
+
+	int bar_note_count=0;  // how many notes have been played in bar.  Use it as index into  played_notes_circular_buffer[]
+	struct note played_notes_circular_buffer[256];  // worst case maximum of 256 harmony, melody and bass notes can be played per bar.  
+
+	int circle_root_key=0; // root_key position on the circle 0,1,2... CW
+	int root_key=0;  // 0 initially
+	int notate_mode_as_signature_root_key=0; // 0 initially
+
+	// these all point into theKeyModeTable
+	const int* notes=theKeyModeTable->notes;
+	int  num_notes=0;
+	const int (*root_key_notes)[MAX_NOTES_CANDIDATES]=theModeNotesTables[1].root_key_notes;
+	const int* num_root_key_notes=theModeNotesTables[1].num_root_key_notes;
+
+	// inverse lookups.  circle_position_step is rebuilt by buildInverseMaps() whenever the harmony preset changes
+	const int* scale_note_index=theKeyModeTable->scale_note_index;  // MIDI note -> index into root_key_notes[root_key] of that note, or of the scale note just below it
+	const int* degree_circle_position=theKeyModeTable->degree_circle_position;  // 1 based degree -> circle of 5ths position on the degree semicircle.  [0] unused
+	const int* circle_position_degree=theKeyModeTable->circle_position_degree;  // circle of 5ths position -> 1 based degree, 0 if not on the semicircle
+	int  circle_position_step[MAX_CIRCLE_STATIONS];  // circle of 5ths position -> first harmony step playing it, -1 if none
+
+	int meter_numerator=4;  // need to unify with sig_top...
+	int meter_denominator=4;
+
+	const char (*note_desig)[MAXSHORTSTRLEN]=note_desig_default;  // current spelling, switched between sharps and flats as root_key changes
+
+	MeanderState theMeanderState;
+
+	int  current_chord_notes[16];
+
+	const HarmonyPresetBank* harmonyPresetBank=&theBuiltinHarmonyPresetBank;
+	int    harmony_type=14;  // 1- numHarmonyPresets()
+	bool randomize_harmony=false;
+
+	struct HarmonyType theHarmonyPreset;  // harmony_type as loaded from the bank, plus any step edits from the panel
+	struct HarmonyType theActiveHarmonyType;
+
+	int    home_circle_position;
+	int    current_circle_position;
+	int    last_circle_position;
+
+	const int* step_chord_notes[MAX_STEPS]={};  // point into theChordNotesTables
+	int  num_step_chord_notes[MAX_STEPS]={};
+	int  step_chord_type[MAX_STEPS]={};
+
+	// clock
+	float tempo =120.0f;
+	float frequency = 2.0f;
+
+	
+	int i16ts_count_limit = 2;// 32s notes per sixteenth note
+	int i8ts_count_limit = 4;   // 32s notes per eighth note
+	int i4ts_count_limit = 8;  // 32s notes per quarter note
+	int i2ts_count_limit =16;  // 32s notes per half note
+	int barts_count_limit = 32;     // 32s notes per bar
+	
+	float min_bpm = 10.0f;
+	float max_bpm = 300.0f;
+
+	int bar_count = 0;  // number of bars running count
+	
+	int i16ts_count = 0;  // counted 32s notes per sixteenth note
+	int i8ts_count = 0;  // counted 32s notes per eighth note
+	int i4ts_count = 0; // counted 32s notes per quarter note
+	int i2ts_count = 0; // counted 32s notes per half note
+	int barts_count = 0;     // counted 32s notes per bar
+
+	float last_melody_note=0;
+	float current_melody_note=0;
+
+	int circle_step_index=0;
+
+	bool CircleStepStates[MAX_STEPS]={};
+	bool CircleStepSetStates[MAX_STEPS]={};
+
+	bool prog_step_input_connected=false;  // something is patched into IN_PROG_STEP_EXT_CV, set by the host
+
+	// every random choice and the fBm time base derive from this seed and the musical position, see counterRandom()
+	uint64_t random_seed=1;
+	long long random_draw_tick=-1;
+	uint32_t random_draw_count[NUM_RANDOM_PARTS]={};
+
+	long long songTick()  // 32nd notes since bar 0
+	{
+		return (long long)bar_count*barts_count_limit + barts_count;
+	}
+
+	float randomUniform(int part)
+	{
+		long long tick=songTick();
+		if (tick!=random_draw_tick)
+		{
+			random_draw_tick=tick;
+			for (int i=0; i<NUM_RANDOM_PARTS; ++i)
+				random_draw_count[i]=0;
+		}
+		return counterRandomUniform(random_seed, (uint32_t)bar_count, (uint32_t)barts_count, part, random_draw_count[part]++);
+	}
+
+	// fBm time base in seconds of score time at the 120 BPM reference tempo, so the noise follows the music
+	// rather than the CPU clock, and is the same on every run and at every tempo
+	double musicalTime()
+	{
+		return songTick()/16.0;
+	}
+
+	// this instance's noise permutation.  Only this engine writes it, see setNoiseSeed()
+	NoiseContext noise;
+
+	// 0 is the reference permutation, which every instance used before instances had their own
+	void setNoiseSeed(uint64_t seed)
+	{
+		noise.reseed(seed);
+		fBm_batch_tick=-1;  // drop the batch fBm values cached for the old seed
+	}
+
+	// per part offset into the fBm so the seed also varies the noise
+	double fBmSeedOffset(int part)
+	{
+		return (counterRandom(random_seed, 0, 0, part, 0xff) >> 40) / 4096.0;  // 0-4096
+	}
+
+	double fBmArgument(int part, double parmsSeed, double period)
+	{
+		return parmsSeed + fBmSeedOffset(part) + (1.0/period)*musicalTime();
+	}
+
+	// where channel's fBm starts, for the polyphonic smooth fBm outputs.  Channel 0 is the noise the part plays from,
+	// the others are other stretches of it, as with a different seed
+	double fBmChannelOrigin(int part, double parmsSeed, int channel)
+	{
+		double origin=parmsSeed + fBmSeedOffset(part);
+		if (channel>0)
+			origin+=(counterRandom(random_seed, 0, channel, part, 0xfe) >> 40) / 4096.0;  // 0-4096
+		return origin;
+	}
+
+	// harmony, melody and arp fBm for the current tick.  They mostly play on the same ticks, so the first part to ask
+	// evaluates all three in one FastfBm1DNoiseBatch() call and the others read the result.  Three points fill no AVX2
+	// vector, so this runs one SSE2 pair and one scalar point and saves little over three FastfBm1DNoise() calls; the
+	// wider batch versions are for callers with many points, such as bench_noise and noise_suite
+	long long fBm_batch_tick=-1;
+	double fBm_batch_arg[RANDOM_PART_ARP+1]={};
+	int fBm_batch_octaves[RANDOM_PART_ARP+1]={};
+	double fBm_batch_value[RANDOM_PART_ARP+1]={};
+
+	// wavetable fBm: a constant-cost table read instead of the octaves, at most 0.0015 off FastfBm1DNoise() (see
+	// fBm1DWavetable).  Each part's table starts at its seed.  Off by default so existing patches play exactly as before.
+	// The tables hold 60 units of the noise, 30 bars at a period of 1, and the fBm is computed past them rather than
+	// read from the table's loop, so it never repeats.
+	//
+	// A set of tables takes over 1 ms to build, so buildfBmWavetables() builds it on the thread that turns the tables
+	// on or sets the seeds, and hands it to the audio thread through fBm_wavetables_ready.  Of the three sets one is
+	// being read, one may be handed over and not yet taken, and the third is free to build into.  The audio thread only
+	// reads a finished set, and computes the fBm as usual until one for the current seeds has arrived.
+	bool fBm_wavetable=false;
+	fBm1DWavetable fBm_wavetables[3][RANDOM_PART_ARP+1];
+	std::atomic<int> fBm_wavetables_ready{-1};  // the set handed over, -1 once the audio thread has taken it
+	int fBm_wavetables_read=-1;    // audio thread: the set it reads
+	int fBm_wavetables_queued=-1;  // building thread: the last set it handed over
+	int fBm_wavetables_taken=-1;   // building thread: the last set it knows the audio thread took
+
+	// not from the audio thread.  withNoise has the noise seed process() will be using
+	void buildfBmWavetables(const NoiseContext& withNoise)
+	{
+		int set=0;
+		while ((set==fBm_wavetables_taken)||(set==fBm_wavetables_queued))
+			++set;
+		fBm_wavetables[set][RANDOM_PART_HARMONY].build(theMeanderState.theHarmonyParms.seed + fBmSeedOffset(RANDOM_PART_HARMONY), withNoise);
+		fBm_wavetables[set][RANDOM_PART_MELODY].build(theMeanderState.theMelodyParms.seed + fBmSeedOffset(RANDOM_PART_MELODY), withNoise);
+		fBm_wavetables[set][RANDOM_PART_ARP].build(theMeanderState.theArpParms.seed + fBmSeedOffset(RANDOM_PART_ARP), withNoise);
+		if (fBm_wavetables_ready.exchange(set)<0)
+			fBm_wavetables_taken=fBm_wavetables_queued;  // and so no longer reads any set before it
+		fBm_wavetables_queued=set;
+	}
+
+	// part's table, or nullptr while there is none for the current seeds
+	const fBm1DWavetable* fBmWavetable(int part, double parmsSeed)
+	{
+		if (fBm_wavetables_ready.load(std::memory_order_relaxed)>=0)
+			fBm_wavetables_read=fBm_wavetables_ready.exchange(-1);
+		if (fBm_wavetables_read<0)
+			return nullptr;
+		const fBm1DWavetable& wavetable=fBm_wavetables[fBm_wavetables_read][part];
+		if ((wavetable.origin!=parmsSeed + fBmSeedOffset(part))||(wavetable.noise_seed!=noise.seed))
+			return nullptr;
+		return &wavetable;
+	}
+
+	double fBmValue(int part, double parmsSeed, double period, int noctaves)
+	{
+		if (fBm_wavetable)
+		{
+			const fBm1DWavetable* wavetable=fBmWavetable(part, parmsSeed);
+			double u=(1.0/period)*musicalTime();
+			if (wavetable && wavetable->covers(u))
+				return (wavetable->lookup(u, noctaves) +1.)/2;
+		}
+		double fBmarg=fBmArgument(part, parmsSeed, period);
+		long long tick=songTick();
+		if ((tick!=fBm_batch_tick)||(fBmarg!=fBm_batch_arg[part])||(noctaves!=fBm_batch_octaves[part]))
+		{
+			fBm_batch_tick=tick;
+			fBm_batch_arg[RANDOM_PART_HARMONY]=fBmArgument(RANDOM_PART_HARMONY, theMeanderState.theHarmonyParms.seed, theMeanderState.theHarmonyParms.period);
+			fBm_batch_arg[RANDOM_PART_MELODY]=fBmArgument(RANDOM_PART_MELODY, theMeanderState.theMelodyParms.seed, theMeanderState.theMelodyParms.period);
+			fBm_batch_arg[RANDOM_PART_ARP]=fBmArgument(RANDOM_PART_ARP, theMeanderState.theArpParms.seed, theMeanderState.theArpParms.period);
+			fBm_batch_octaves[RANDOM_PART_HARMONY]=theMeanderState.theHarmonyParms.noctaves;
+			fBm_batch_octaves[RANDOM_PART_MELODY]=theMeanderState.theMelodyParms.noctaves;
+			fBm_batch_octaves[RANDOM_PART_ARP]=theMeanderState.theArpParms.noctaves;
+			fBm_batch_arg[part]=fBmarg;
+			fBm_batch_octaves[part]=noctaves;
+			FastfBm1DNoiseBatch(fBm_batch_arg, fBm_batch_octaves, fBm_batch_value, RANDOM_PART_ARP+1, noise);
+		}
+		return (fBm_batch_value[part] +1.)/2; 
+	}
+
+	// point this instance at the precomputed tables for circle_root_key and mode.  Nothing is computed here, so it
+	// is cheap enough to run on the audio thread every time the key or mode changes
+	void selectKeyModeTables()
+	{
+		theKeyModeTable=&theKeyModeTables[clamp(circle_root_key, 0, MAX_ROOT_KEYS-1)][clamp(mode, 0, MAX_MODES-1)];
+		if (doDebug)  DEBUG("selectKeyModeTables() circle_root_key=%d mode=%d", circle_root_key, mode);
+
+		theCircleOf5ths.theDegreeSemiCircle=&theKeyModeTable->theDegreeSemiCircle;
+		arabicStepDegreeSemicircleIndex=theKeyModeTable->arabicStepDegreeSemicircleIndex;
+		notes=theKeyModeTable->notes;
+		num_notes=theKeyModeTable->num_notes;
+		root_key_notes=theKeyModeTable->modeNotes->root_key_notes;
+		num_root_key_notes=theKeyModeTable->modeNotes->num_root_key_notes;
+		scale_note_index=theKeyModeTable->scale_note_index;
+		degree_circle_position=theKeyModeTable->degree_circle_position;
+		circle_position_degree=theKeyModeTable->circle_position_degree;
+		notate_mode_as_signature_root_key=theKeyModeTable->notate_mode_as_signature_root_key;
+		note_desig=(theKeyModeTable->flats) ? note_desig_flats : note_desig_sharps;
+	}
+
+	void AuditHarmonyData(int source)
+	{
+		 if (!Audit_enable)
+		   return;
+		 if (doDebug)  DEBUG("AuditHarmonyData()-begin-source=%d", source);
+		 for (int j=1;j<=numHarmonyPresets();++j)
+	      {
+			const HarmonyType &preset=harmonyPresetBank->presets[j];
+			if ((preset.num_harmony_steps<1)||(preset.num_harmony_steps>MAX_STEPS))
+			{
+				if (doDebug)  DEBUG("  warning-harmony preset %d num_harmony_steps=%d", j, preset.num_harmony_steps);
+			}
+			for (int i=0;i<MAX_STEPS;++i)
+	          {
+	         	if ((preset.harmony_steps[i]<1)||(preset.harmony_steps[i]>MAX_HARMONIC_DEGREES))
+				{ 
+					if (doDebug)  DEBUG("  warning-harmony preset %d harmony_steps[%d]=%d", j, i, preset.harmony_steps[i]);
+				}
+	          }
+	      }
+		  if (doDebug)  DEBUG("AuditHarmonyData()-end");
+	}
+
+	int numHarmonyPresets() const
+	{
+		return harmonyPresetBank->size();
+	}
+
+	// reload harmony_type from the bank, dropping any step edits
+	void init_harmony()
+	{
+		if (doDebug)  DEBUG("init_harmony");
+		harmony_type=clamp(harmony_type, 1, numHarmonyPresets());
+		theHarmonyPreset=harmonyPresetBank->presets[harmony_type];
+	}
+
+	void copyHarmonyTypeToActiveHarmonyType(int harmType)
+	{
+		theActiveHarmonyType=theHarmonyPreset;
+		theActiveHarmonyType.harmony_type=harmType;  // the parent harmony_type
+	}
+
+	// Fill circle_position_step so the generators never have to search the harmony steps.  The key and mode
+	// dependent inverse maps are precomputed in theKeyModeTables.
+	void buildInverseMaps()
+	{
+		if (doDebug)  DEBUG("buildInverseMaps()");
+
+		for (int i=0; i<MAX_CIRCLE_STATIONS; ++i)
+			circle_position_step[i]=-1;
+		for (int j=MAX_STEPS-1; j>=0; --j)  // backwards so the first step using a degree wins
+		{
+			int degree=theHarmonyPreset.harmony_steps[j];
+			if ((degree>=1)&&(degree<=7))
+				circle_position_step[degree_circle_position[degree]]=j;
+		}
+	}
+
+	void setup_harmony()
+	{
+		if (doDebug)  DEBUG("setup_harmony-begin"); 
+	    int i;
+	    int circle_position=0;
+		int circleDegree=0;
+
+		buildInverseMaps();
+
+		for (i=0; i<MAX_CIRCLE_STATIONS; ++i)  // plain triads, 7ths are applied per step below
+			theCircleOf5ths.Circle5ths[i].chordType=theKeyModeTable->circle_chord_type[i];
+		
+	    if (doDebug)  DEBUG("harmony preset %d num_harmony_steps=%d", harmony_type, theActiveHarmonyType.num_harmony_steps);   	
+	    for(i=0;i<theActiveHarmonyType.num_harmony_steps;++i)              /* for each of the harmony steps         */
+	     {           
+		   if (doDebug)  DEBUG("step=%d", i);                                /* build proper chord notes              */
+		   num_step_chord_notes[i]=0;
+		   //find semicircle degree that matches step degree
+		   if ((theActiveHarmonyType.harmony_steps[i]>=1)&&(theActiveHarmonyType.harmony_steps[i]<=7))
+		   {
+			   circleDegree=theActiveHarmonyType.harmony_steps[i];
+			   circle_position=degree_circle_position[circleDegree];
+		   }
+		   else
+		   {
+			   if (doDebug)  DEBUG("  warning circleposition could not be found 1");
+		   }
+	 
+		   if (doDebug)  DEBUG("  circle_position=%d  num_root_key_notes[circle_position]=%d", circle_position, num_root_key_notes[circle_position]);
+
+		   int thisStepChordType=theCircleOf5ths.Circle5ths[circle_position].chordType;
+
+			if (true)  // attempting to handle 7ths
+			{
+				if  ((theMeanderState.theHarmonyParms.enable_all_7ths)|| (theMeanderState.theHarmonyParms.enable_V_7ths))  // override V chord to 7th
+				//	 ((theMeanderState.theHarmonyParms.enable_V_7ths)&&(circleDegree==5)))  // override V chord to 7th
+				{	
+					if ((theMeanderState.theHarmonyParms.enable_V_7ths)&&(circleDegree==5))
+					{
+						if (thisStepChordType==0)  // maj
+							thisStepChordType=2; // 7dom  .  A dom7 sounds better than a maj7
+						else
+						if (thisStepChordType==1)  // min
+							thisStepChordType=4; // 7min
+						else
+						if (thisStepChordType==6)  // dim
+							thisStepChordType=5; // dim7
+						theCircleOf5ths.Circle5ths[circle_position].chordType=thisStepChordType;
+					}
+					else
+					if (theMeanderState.theHarmonyParms.enable_all_7ths)  // actually only use most popular 7ths
+					{ 
+						if (circleDegree==2)  // II
+						{
+							if (thisStepChordType==1)  // min
+								thisStepChordType=4;   // 7thmin  
+						}
+						else
+						if (circleDegree==4)  // IV
+						{
+							if (thisStepChordType==0)  // maj
+							//	thisStepChordType=2;   // 7thdom  
+								thisStepChordType=3;   // 7thmaj  
+						}
+						else
+						if (circleDegree==5)  // V
+						{
+							if (thisStepChordType==0)  // maj
+								thisStepChordType=2;   // 7thdom  
+						}
+						else
+						if (circleDegree==7)  // VII
+						{
+							if (thisStepChordType==6)  // dim
+								thisStepChordType=5;   // 7thdim  
+						}
+						theCircleOf5ths.Circle5ths[circle_position].chordType=thisStepChordType;
+					}
+				
+				}
+			}
+
+		   if (theActiveHarmonyType.harmony_step_seventh[i])  // only this step, so the circle position keeps its chord
+		   {
+			   if (thisStepChordType==0)  // maj
+				   thisStepChordType=2;   // 7thdom
+			   else
+			   if (thisStepChordType==1)  // min
+				   thisStepChordType=4;   // 7thmin
+			   else
+			   if (thisStepChordType==6)  // dim
+				   thisStepChordType=5;   // 7thdim
+		   }
+		   step_chord_type[i]=thisStepChordType;
+
+		   const ChordNotesTable &chord=theChordNotesTables[circle_of_fifths[circle_position]][clamp(thisStepChordType, 0, MAX_CIRCLE_CHORD_TYPES-1)];
+		   step_chord_notes[i]=chord.notes;
+		   num_step_chord_notes[i]=chord.num_notes;
+		   if (doDebug)  DEBUG("  step_chord_notes[%d] %d notes from %s", i, num_step_chord_notes[i], note_desig[step_chord_notes[i][0]%MAX_NOTES]);
+	     }
+		 AuditHarmonyData(1);
+		 if (doDebug)  DEBUG("setup_harmony-end");
+	}
+
+
+	void MeanderMusicStructuresInitialize()
+	{
+		if (doDebug)  DEBUG("MeanderMusicStructuresInitialize()");
+	
+		ConstructCircle5ths(circle_root_key, mode);
+		selectKeyModeTables();
+		note_desig=note_desig_default;
+		init_harmony();
+		copyHarmonyTypeToActiveHarmonyType(harmony_type);
+		setup_harmony();
+		globalsInitialized=true;  // prevents process() from doing anything before initialization and also prevents some access by ModuleWidget
+	} 
+
+
+	void ConstructCircle5ths(int circleRootKey, int mode)
+	{
+		for (int i=0; i<MAX_CIRCLE_STATIONS; ++i)
+			theCircleOf5ths.Circle5ths[i]=theDefaultCircle5ths[i];
+	}
+
+	void recordPlayedNote(const struct note &playedNote)
+	{
+		if (bar_note_count<256)
+			played_notes_circular_buffer[bar_note_count++]=playedNote;
+		if (!seeking)
+			onNotePlayed(playedNote);
+	}
+
+	void userPlaysCirclePositionHarmony(int circle_position, float octaveOffset)  // C=0   play immediate
+	{
+		if (doDebug) DEBUG("userPlaysCirclePositionHarmony(%d)", circle_position); 
+		if (doDebug) DEBUG("circle_position=%d", circle_position);
+	
+		theMeanderState.last_harmony_chord_root_note=circle_of_fifths[circle_position];
+
+		if (octaveOffset>9)
+			octaveOffset=9;
+
+		if (circle_position_step[circle_position]>=0) // melody and bass will use this to accompany 
+			theMeanderState.last_harmony_step=circle_position_step[circle_position];
+
+		theMeanderState.theMelodyParms.last_step=theMeanderState.last_harmony_step;
+		int note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[theMeanderState.last_harmony_step]);		// not sure this is necessary
+		theMeanderState.theMelodyParms.last_chord_note_index= note_index;
+		 
+		int current_chord_note=0;
+		int root_key_note=circle_of_fifths[circle_position]; 
+		if (doDebug) DEBUG("root_key_note=%d %s", root_key_note, note_desig[root_key_note%12]); 
+		int circle_chord_type= theCircleOf5ths.Circle5ths[circle_position].chordType;
+		theMeanderState.theHarmonyParms.last_chord_type=circle_chord_type;
+		if (doDebug) DEBUG("circle_chord_type=%d", circle_chord_type);
+		int num_chord_members=chord_type_num_notes[circle_chord_type];
+		if (doDebug) DEBUG("num_chord_members=%d", num_chord_members);
+
+		if (((theMeanderState.theHarmonyParms.enable_all_7ths)||(theMeanderState.theHarmonyParms.enable_V_7ths))			
+			&& ((circle_chord_type==2)
+			||  (circle_chord_type==3)
+			||  (circle_chord_type==4)
+			||  (circle_chord_type==5)))
+				setOutputChannels(OUT_HARMONY_CV_OUTPUT, 4);  // set polyphony
+			else
+				setOutputChannels(OUT_HARMONY_CV_OUTPUT, 3);  // set polyphony
+
+		for (int j=0;j<num_chord_members;++j) 
+		{
+			current_chord_note=(int)((int)root_key_note+(int)chord_type_intervals[circle_chord_type][j]);
+			if (doDebug) DEBUG("  current_chord_note=%d %s", current_chord_note, note_desig[current_chord_note%12]);
+			int note_to_play=current_chord_note+(octaveOffset*12);
+			setOutputVoltage(OUT_HARMONY_CV_OUTPUT, (note_to_play/12.0)-4.0,j);  // (note, channel) 
+					
+			if (j<4)
+			{
+				theMeanderState.theHarmonyParms.last[j].note=note_to_play;
+				theMeanderState.theHarmonyParms.last[j].noteType=NOTE_TYPE_CHORD;
+				theMeanderState.theHarmonyParms.last[j].length=1;  // whole  note for now
+				theMeanderState.theHarmonyParms.last[j].time32s=barts_count;
+				theMeanderState.theHarmonyParms.last[j].countInBar=bar_note_count;
+				recordPlayedNote(theMeanderState.theHarmonyParms.last[j]);
+				
+			}
+            
+		}
+		float durationFactor=1.0;
+		if (theMeanderState.theHarmonyParms.enable_staccato)
+			durationFactor=0.5;
+		else
+			durationFactor=1.0;
+		
+		float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theHarmonyParms.note_length_divisor);
+		resetGate(OUT_HARMONY_GATE_OUTPUT);  // kill the pulse in case it is active
+		triggerGate(OUT_HARMONY_GATE_OUTPUT, note_duration);  
+	}
+
+	void doHarmony(int barChordNumber=1, bool playFlag=false)
+	{
+		MeanderProfiler::Scope profile(profiler, PROFILE_HARMONY);
+		if (doDebug) DEBUG("doHarmony");
+		if (doDebug) DEBUG("doHarmony() theActiveHarmonyType.min_steps=%d, theActiveHarmonyType.max_steps=%d", theActiveHarmonyType.min_steps, theActiveHarmonyType.max_steps );
+
+		setOutputVoltage(OUT_HARMONY_VOLUME_OUTPUT, theMeanderState.theHarmonyParms.volume);
+		
+		if (doDebug) DEBUG("\nHarmony: barCount=%d Time=%.3lf", bar_count, musicalTime());
+													
+		current_melody_note += 1.0/12.0;
+		current_melody_note=fmod(current_melody_note, 1.0f);	
+
+		
+	
+		for (int i=0; i<MAX_CIRCLE_STATIONS; ++i) {
+			CircleStepStates[i] = false;
+			setLightBrightness(LIGHT_LEDBUTTON_CIRCLESTEP_1+i, 0.0f);
+		}
+
+		for (int i=0; i<16; ++i) {
+			if (i<theActiveHarmonyType.num_harmony_steps)
+				setLightBrightness(LIGHT_LEDBUTTON_CIRCLESETSTEP_1+i, 0.25f);
+			else
+				setLightBrightness(LIGHT_LEDBUTTON_CIRCLESETSTEP_1+i, 0.0f);
+				
+		}
+	
+	
+     	if (doDebug) DEBUG("harmony preset %d num_harmony_steps=%d", harmony_type, theActiveHarmonyType.num_harmony_steps);
+		int step=(bar_count%theActiveHarmonyType.num_harmony_steps);  // 0-(n-1)
+ 
+ 		if ((theActiveHarmonyType.progression==PROGRESSION_RANDOM_COMING_HOME)&&(step==0)&&(barChordNumber==0))  // random coming home
+		{
+			float rnd = randomUniform(RANDOM_PART_HARMONY);
+			int temp_num_harmony_steps=1 + (int)((rnd*(theHarmonyPreset.num_harmony_steps-1)));
+			bar_count += (theHarmonyPreset.num_harmony_steps-temp_num_harmony_steps);
+		}
+
+		if (randomize_harmony) // this could be used to randomize any progression
+		{
+			if (barChordNumber==0)
+			{
+				float rnd = randomUniform(RANDOM_PART_HARMONY);
+				step = (int)((rnd*theActiveHarmonyType.num_harmony_steps));
+				step=step%theActiveHarmonyType.num_harmony_steps;
+			}
+			else
+			{
+				step=theMeanderState.theHarmonyParms.last_circle_step;
+			}
+		}
+		else
+		if (theActiveHarmonyType.progression==PROGRESSION_RANDOM_COMING_HOME) // random coming home
+		{
+			if (barChordNumber!=0)
+			{
+				step=theMeanderState.theHarmonyParms.last_circle_step;
+			}
+		}
+		else
+		if (theActiveHarmonyType.progression==PROGRESSION_RANDOM_ORDER) // random order
+		{
+			if (barChordNumber==0)
+			{
+				float rnd = randomUniform(RANDOM_PART_HARMONY);
+				step = (int)((rnd*theActiveHarmonyType.num_harmony_steps));
+				step=step%theActiveHarmonyType.num_harmony_steps;
+			}
+			else
+			{
+				step=theMeanderState.theHarmonyParms.last_circle_step;
+			}
+		}
+		else
+		if (theActiveHarmonyType.progression==PROGRESSION_MARKOV_CHAIN)  // higher order Markov chains
+		{
+			if (barChordNumber==0)
+			{
+				const MarkovChain* chain=theActiveHarmonyType.markov_chain;
+				int &history=theMeanderState.theHarmonyParms.markov_history;
+				if ((theMeanderState.theHarmonyParms.last_circle_step==-1)||(history<0)||(history>=chain->history_size))
+					history=chain->start_history;
+				step=chain->sample(history, randomUniform(RANDOM_PART_HARMONY));
+				history=chain->nextHistory(history, step);
+			}
+			else
+			{
+				step=theMeanderState.theHarmonyParms.last_circle_step;
+			}
+		}
+		else
+		if (theActiveHarmonyType.progression==PROGRESSION_MARKOV)  // Markov chains
+		{   
+			if (barChordNumber==0)
+			{
+				float rnd = randomUniform(RANDOM_PART_HARMONY);
+				if (doDebug) DEBUG("rnd=%.2f",rnd);
+			
+
+				if (theMeanderState.theHarmonyParms.last_circle_step==-1)
+				{
+					step=0;
+				}
+				else
+				{
+					step=theActiveHarmonyType.markov_matrix->sample(theMeanderState.theHarmonyParms.last_circle_step, rnd);
+				}
+			}
+			else
+			{
+				step=theMeanderState.theHarmonyParms.last_circle_step;
+			}
+			
+		}
+		
+    	
+
+		if (doDebug) DEBUG("step=%d", step);
+
+		int degreeStep=(theActiveHarmonyType.harmony_steps[step])%8;  
+		if (doDebug) DEBUG("degreeStep=%d", degreeStep);
+	
+		theMeanderState.theHarmonyParms.last_circle_step=step;  // used for Markov chain
+
+		//find this in semicircle
+		if (degreeStep>=1)
+			current_circle_position = degree_circle_position[degreeStep]; 
+		else
+		{
+	    	if (doDebug) DEBUG("  warning circleposition could not be found 2");
+		}
+				
+		setLightBrightness(LIGHT_LEDBUTTON_CIRCLESETSTEP_1+step, 1.0f);
+		setLightBrightness(LIGHT_LEDBUTTON_CIRCLESTEP_1+ (current_circle_position)%12, 1.0f);
+		
+		if (doDebug) DEBUG("current_circle_position=%d root=%d %s", current_circle_position, circle_of_fifths[current_circle_position], note_desig[circle_of_fifths[current_circle_position]]);		
+		if (doDebug) DEBUG("theCircleOf5ths.Circle5ths[current_circle_position].chordType=%d", theCircleOf5ths.Circle5ths[current_circle_position].chordType);
+		
+		
+	    double fBmrand=fBmValue(RANDOM_PART_HARMONY, theMeanderState.theHarmonyParms.seed, theMeanderState.theHarmonyParms.period, theMeanderState.theHarmonyParms.noctaves); 
+			
+		theMeanderState.theHarmonyParms.note_avg = 
+			(1.0-theMeanderState.theHarmonyParms.alpha)*theMeanderState.theHarmonyParms.note_avg + 
+			theMeanderState.theHarmonyParms.alpha*(theMeanderState.theHarmonyParms.range_bottom + (fBmrand*theMeanderState.theHarmonyParms.r1));
+					
+		if (theMeanderState.theHarmonyParms.note_avg>theMeanderState.theHarmonyParms.range_top)
+		theMeanderState.theHarmonyParms.note_avg=theMeanderState.theHarmonyParms.range_top;
+		if (theMeanderState.theHarmonyParms.note_avg<theMeanderState.theHarmonyParms.range_bottom)
+		theMeanderState.theHarmonyParms.note_avg=theMeanderState.theHarmonyParms.range_bottom;
+					
+		int step_chord_type=this->step_chord_type[step];  // as setup_harmony() left it, 7ths included
+		theCircleOf5ths.Circle5ths[current_circle_position].chordType=step_chord_type;  // two steps on one position can differ
+		
+		if ((step_chord_type==2)||(step_chord_type==3)||(step_chord_type==4)||(step_chord_type==5))
+			setOutputChannels(OUT_HARMONY_CV_OUTPUT, 4);  // set polyphony
+		else
+			setOutputChannels(OUT_HARMONY_CV_OUTPUT, 3);  // set polyphony
+		
+		if (doDebug) DEBUG("step_chord_type=%d", step_chord_type);
+		int num_chord_members=chord_type_num_notes[step_chord_type]; 
+		if (doDebug) DEBUG("num_chord_members=%d", num_chord_members);
+		
+	
+		theMeanderState.theHarmonyParms.last_chord_type=step_chord_type;
+		theMeanderState.last_harmony_chord_root_note=circle_of_fifths[current_circle_position];
+		theMeanderState.last_harmony_step=step;
+	
+
+		if (doDebug) DEBUG("theMeanderState.last_harmony_chord_root_note=%d %s", theMeanderState.last_harmony_chord_root_note, note_desig[theMeanderState.last_harmony_chord_root_note%MAX_NOTES]);
+
+		if (doDebug) DEBUG("1st 3 step_chord_notes=%d %s, %d %s, %d %s", step_chord_notes[step][0], note_desig[step_chord_notes[step][0]%MAX_NOTES], step_chord_notes[step][1], note_desig[step_chord_notes[step][1]%MAX_NOTES], step_chord_notes[step][2], note_desig[step_chord_notes[step][2]%MAX_NOTES]);
+			
+		bool tonicFound=false;
+		for (int j=0;j<num_chord_members;++j) 
+		{
+				if (doDebug) DEBUG("num_step_chord_notes[%d]=%d", step, num_step_chord_notes[step]);
+				current_chord_notes[j]= step_chord_notes[step][(int)(theMeanderState.theHarmonyParms.note_avg*num_step_chord_notes[step])+j]; // may create inversion
+				if (doDebug) DEBUG("current_chord_notes[%d]=%d %s", j, current_chord_notes[j], note_desig[current_chord_notes[j]%MAX_NOTES]);
+						
+				int note_to_play=current_chord_notes[j]-12;  // drop it an octave to get target octave right
+				if (doDebug) DEBUG("    h_note_to_play=%d %s", note_to_play, note_desig[note_to_play%MAX_NOTES]);
+							
+				if (playFlag)  
+				{
+					if (j<4)
+					{
+						theMeanderState.theHarmonyParms.last[j].note=note_to_play;
+						theMeanderState.theHarmonyParms.last[j].noteType=NOTE_TYPE_CHORD;
+						theMeanderState.theHarmonyParms.last[j].length=1;  // need chords per measure
+						theMeanderState.theHarmonyParms.last[j].time32s=barts_count;
+						theMeanderState.theHarmonyParms.last[j].countInBar=bar_note_count;
+						recordPlayedNote(theMeanderState.theHarmonyParms.last[j]);
+					}
+				
+					//  get tonic in channel 0
+											
+					if ( (note_to_play%MAX_NOTES)==(theMeanderState.last_harmony_chord_root_note%MAX_NOTES))
+					{
+						setOutputVoltage(OUT_HARMONY_CV_OUTPUT, (note_to_play/12.0)-4.0,0);  // (note, channel)
+						tonicFound=true;
+					}
+					else
+					{
+						if (!tonicFound)
+							setOutputVoltage(OUT_HARMONY_CV_OUTPUT, (note_to_play/12.0)-4.0,j+1);  // (note, channel)
+						else
+							setOutputVoltage(OUT_HARMONY_CV_OUTPUT, (note_to_play/12.0)-4.0,j);  // (note, channel)
+					}
+					
+				
+				}
+		}
+		
+		if (playFlag)
+		{ 
+			setOutputVoltage(OUT_HARMONY_VOLUME_OUTPUT, theMeanderState.theHarmonyParms.volume);
+
+			// output some fBm noise
+			setOutputChannels(OUT_FBM_HARMONY_OUTPUT, 1);  // set polyphony  
+		
+			float durationFactor=1.0;
+			if (theMeanderState.theHarmonyParms.enable_staccato)
+				durationFactor=0.5;
+			else
+				durationFactor=0.95;
+
+					
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BAR_OUTPUT)
+				durationFactor*=1.0;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEAT_OUTPUT)
+				durationFactor*=.25;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX2_OUTPUT)
+				durationFactor*=.125;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX4_OUTPUT)
+				durationFactor*=.0625;	
+			else
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX8_OUTPUT)
+				durationFactor*=.03125;	
+			else
+			if ( prog_step_input_connected) // something is connected to the circle STEP input but we do not know what. Assume it is an 16X BPM frequency
+		   		durationFactor *= .01562;  
+			
+						
+			float note_duration=durationFactor*4/(frequency*theMeanderState.theHarmonyParms.note_length_divisor);
+			resetGate(OUT_HARMONY_GATE_OUTPUT);  // kill the pulse in case it is active
+			triggerGate(OUT_HARMONY_GATE_OUTPUT, note_duration);  
+		}
+
+		setOutputVoltage(OUT_FBM_HARMONY_OUTPUT, (float)clamp((10.f*fBmrand), 0.f, 10.f) ,0); // rescale fBm output to 0-10V so it can be used better for CV.  Output even if harmony disabled
+
+		++circle_step_index;
+		if (circle_step_index>=theActiveHarmonyType.num_harmony_steps)
+			circle_step_index=0;
+
+		if ((theActiveHarmonyType.progression==PROGRESSION_RANDOM_COMING_HOME)&&(step==0)&&(barChordNumber==0))  // random coming home
+		{
+			float rnd = randomUniform(RANDOM_PART_HARMONY);
+			int temp_num_harmony_steps=1 + (int)((rnd*(theHarmonyPreset.num_harmony_steps-1)));
+			bar_count += (theHarmonyPreset.num_harmony_steps-temp_num_harmony_steps);
+		}
+
+	}
+
+	void userPlaysScaleDegreeMelody(int degree, float octaveOffset)  // C=0   play immediate
+	{
+		if (degree<1)
+			degree=1;
+		if (degree>7)
+			degree=7;
+
+		
+
+		int	note_to_play=root_key_notes[root_key][degree-1]+(octaveOffset*12); 
+		setOutputVoltage(OUT_MELODY_CV_OUTPUT, (note_to_play/12.0)-4.0,0);  // (note, channel)  shift down 1 ocatve/v
+					
+		theMeanderState.theMelodyParms.last[0].note=note_to_play;
+		theMeanderState.theMelodyParms.last[0].noteType=NOTE_TYPE_MELODY;
+		theMeanderState.theMelodyParms.last[0].length=1;  // whole  note for now
+		theMeanderState.theMelodyParms.last[0].time32s=barts_count;
+		theMeanderState.theMelodyParms.last[0].countInBar=bar_note_count;
+
+		recordPlayedNote(theMeanderState.theMelodyParms.last[0]);
+			
+		float durationFactor=1.0;
+		if (theMeanderState.theMelodyParms.enable_staccato)
+			durationFactor=0.5;
+		else
+			durationFactor=1.0;
+		
+		float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theMelodyParms.note_length_divisor);
+		resetGate(OUT_MELODY_GATE_OUTPUT);  // kill the pulse in case it is active
+		triggerGate(OUT_MELODY_GATE_OUTPUT, note_duration);  
+	}
+
+	void doMelody()
+	{
+		MeanderProfiler::Scope profile(profiler, PROFILE_MELODY);
+		if (doDebug) DEBUG("doMelody()");
+
+		setOutputVoltage(OUT_MELODY_VOLUME_OUTPUT, theMeanderState.theMelodyParms.volume);
+	
+		if (doDebug) DEBUG("Melody: Time=%.3lf",  musicalTime());
+
+		++theMeanderState.theMelodyParms.bar_melody_counted_note;
+
+		theMeanderState.theArpParms.note_count=0;  // where does this really go, at the begining of a melody note
+	
+		double fBmrand=fBmValue(RANDOM_PART_MELODY, theMeanderState.theMelodyParms.seed, theMeanderState.theMelodyParms.period, theMeanderState.theMelodyParms.noctaves); 
+			
+		theMeanderState.theMelodyParms.note_avg = 
+			(1.0-theMeanderState.theMelodyParms.alpha)*theMeanderState.theMelodyParms.note_avg + 
+			theMeanderState.theMelodyParms.alpha*(theMeanderState.theMelodyParms.range_bottom + (fBmrand*theMeanderState.theMelodyParms.r1));
+					
+		if (theMeanderState.theMelodyParms.note_avg>theMeanderState.theMelodyParms.range_top)
+		theMeanderState.theMelodyParms.note_avg=theMeanderState.theMelodyParms.range_top;
+		if (theMeanderState.theMelodyParms.note_avg<theMeanderState.theMelodyParms.range_bottom)
+		theMeanderState.theMelodyParms.note_avg=theMeanderState.theMelodyParms.range_bottom;
+		
+		int step=theMeanderState.last_harmony_step;	
+		theMeanderState.theMelodyParms.last_step= step;
+		int note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[step]);		
+		theMeanderState.theMelodyParms.last_chord_note_index= note_index;
+		int note_to_play=step_chord_notes[step][note_index]; 
+
+		if (theMeanderState.theMelodyParms.chordal)
+		{
+			note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_step_chord_notes[step]);	
+			note_to_play=step_chord_notes[step][note_index]; 
+	
+		}
+		else
+		if (theMeanderState.theMelodyParms.scaler)
+		{
+			note_index=	(int)(theMeanderState.theMelodyParms.note_avg*num_root_key_notes[root_key]);
+			note_to_play=root_key_notes[root_key][note_index]; 
+		}
+
+
+        if (false) // accidentals are probably not notated correctly  Flat accidentals may sound better than sharp
+		{
+			if ((theMeanderState.theMelodyParms.bar_melody_counted_note!=1)&&(theMeanderState.theMelodyParms.bar_melody_counted_note==(theMeanderState.theMelodyParms.note_length_divisor-1))) // allow accidentals, but not on first or last melody note in bar
+			{
+			
+				float rnd = randomUniform(RANDOM_PART_MELODY);
+				if (rnd<.05)
+					note_to_play += 1;
+				else
+				if (rnd>.90)
+					note_to_play -= 1;
+			}
+		}
+				
+		if (doDebug) DEBUG("    melody note_to_play=%d %s", note_to_play, note_desig[note_to_play%MAX_NOTES]);
+
+		if (true)	// do it even if melody notes will not be played, so arp will have roots
+		{   
+			if ((theMeanderState.theMelodyParms.destutter) && (note_to_play==theMeanderState.theMelodyParms.last[0].note) && (theMeanderState.theMelodyParms.last_stutter_step==step))   // seems like gate always fires
+			{
+				theMeanderState.theMelodyParms.stutter_detected=true;
+				theMeanderState.theMelodyParms.last_stutter_step=step;
+			}
+			else
+			{
+				theMeanderState.theMelodyParms.last_stutter_step=step;
+				theMeanderState.theMelodyParms.stutter_detected=false;
+										
+				theMeanderState.theMelodyParms.last[0].note=note_to_play;
+				theMeanderState.theMelodyParms.last[0].noteType=NOTE_TYPE_MELODY;
+				theMeanderState.theMelodyParms.last[0].length=theMeanderState.theMelodyParms.note_length_divisor;
+				theMeanderState.theMelodyParms.last[0].time32s=barts_count;
+				theMeanderState.theMelodyParms.last[0].countInBar=bar_note_count;
+
+				if (theMeanderState.theMelodyParms.enabled)
+					recordPlayedNote(theMeanderState.theMelodyParms.last[0]);
+			
+
+				if (theMeanderState.theMelodyParms.enabled)
+				{						
+					setOutputChannels(OUT_MELODY_CV_OUTPUT, 1);  // set polyphony  may need to deal with unset channel voltages
+					setOutputVoltage(OUT_MELODY_CV_OUTPUT, ((note_to_play/12.0) -4.0) ,0);  // (note, channel) -4 since midC=c4=0vsetOutputVoltage(OUT_MELODY_CV_OUTPUT, (note_to_play -4 + theMeanderState.theMelodyParms.target_octave,0);  // (note, channel) -4 since midC=c4=0v
+		    	}
+
+				// output some fBm noise
+				setOutputChannels(OUT_FBM_MELODY_OUTPUT, 1);  // set polyphony  
+				setOutputVoltage(OUT_FBM_MELODY_OUTPUT, (float)clamp((10.f*fBmrand), 0.f, 10.f) ,0); // rescale fBm output to 0-10V so it can be used better for CV
+
+				float durationFactor=1.0;
+				if (theMeanderState.theMelodyParms.enable_staccato)
+					durationFactor=0.5;
+				else
+					durationFactor=0.95;
+				float note_duration=durationFactor*4/(frequency*theMeanderState.theMelodyParms.note_length_divisor);
+
+				// adjust melody note duration if arp enabled
+				
+				if (theMeanderState.theArpParms.enabled)
+					note_duration=durationFactor*4/(frequency*theMeanderState.theArpParms.note_length_divisor);
+				
+
+				if (theMeanderState.theMelodyParms.enabled)
+				triggerGate(OUT_MELODY_GATE_OUTPUT, note_duration);  // Test 1s duration  need to use .process to detect this and then send it to output
+			}
+		}
+	}
+
+	void doArp() 
+	{
+		MeanderProfiler::Scope profile(profiler, PROFILE_ARP);
+		if (doDebug) DEBUG("doArp()");
+	
+	    if (theMeanderState.theArpParms.note_count>=theMeanderState.theArpParms.count)
+	  		return;
+
+		int arp_note=0;
+
+		
+		if ((theMeanderState.theArpParms.pattern>=-1)&&(theMeanderState.theArpParms.pattern<=1))
+			arp_note=theMeanderState.theArpParms.note_count*theMeanderState.theArpParms.pattern;
+		else
+		if (theMeanderState.theArpParms.pattern==2)
+		{
+			if (theMeanderState.theArpParms.note_count<=((theMeanderState.theArpParms.count)/2))
+			arp_note=theMeanderState.theArpParms.note_count;
+			else
+			arp_note=theMeanderState.theArpParms.count-theMeanderState.theArpParms.note_count-1;
+		}
+		else
+		if (theMeanderState.theArpParms.pattern==-2)
+		{
+			if (theMeanderState.theArpParms.note_count<=((theMeanderState.theArpParms.count)/2))
+			arp_note-=theMeanderState.theArpParms.note_count;
+			else
+			arp_note=-theMeanderState.theArpParms.count+theMeanderState.theArpParms.note_count-1;
+		}
+		else
+			arp_note=theMeanderState.theArpParms.note_count*theMeanderState.theArpParms.pattern;
+
+		if (theMeanderState.theArpParms.pattern!=0)
+		++arp_note; // above the melody note
+
+		++theMeanderState.theArpParms.note_count;
+
+		float volume=theMeanderState.theMelodyParms.volume;
+		float volume_factor=pow((1.0-theMeanderState.theArpParms.decay), theMeanderState.theArpParms.note_count);
+		volume *= volume_factor;
+
+		
+		if (doDebug) DEBUG("theMeanderState.theMelodyParms.last_chord_note_index=%d", theMeanderState.theMelodyParms.last_chord_note_index);
+		if (doDebug) DEBUG("num_step_chord_notes[%d]=%d", theMeanderState.theMelodyParms.last_step, num_step_chord_notes[theMeanderState.theMelodyParms.last_step]);
+				
+		int note_to_play=100; // bogus
+
+		if (theMeanderState.theArpParms.chordal) // use step_chord_notes
+		{
+           note_to_play=step_chord_notes[theMeanderState.theMelodyParms.last_step][(theMeanderState.theMelodyParms.last_chord_note_index + arp_note)% num_step_chord_notes[theMeanderState.theMelodyParms.last_step]];
+		}
+		else 
+		if (theMeanderState.theArpParms.scaler) // use root_key_notes rather than step_chord_notes.  Scale note index comes from scale_note_index[]
+		{   
+			if (false)  // old brute force search from beginning
+			{
+				for (int x=0; x<num_root_key_notes[root_key]; ++x)
+				{
+					if (root_key_notes[root_key][x]==theMeanderState.theMelodyParms.last[0].note)
+					{
+						note_to_play=root_key_notes[root_key][x+arp_note];
+						if (doDebug) DEBUG("note fount at index=%d root_key_notes[root_key][x]=%d", x, root_key_notes[root_key][x]);
+						break;
+					}
+				}
+			}
+		
+			if (true)  // O(1) inverse map built by buildInverseMaps()
+			{
+				int note_to_search_for=clamp(theMeanderState.theMelodyParms.last[0].note, 0, 127);
+				int scale_index=scale_note_index[note_to_search_for];
+				if (doDebug) DEBUG("note %d found at scale index %d", note_to_search_for, scale_index);
+				note_to_play=root_key_notes[root_key][scale_index+arp_note];
+			}
+			
+		}
+		
+		
+	
+		if (((theMeanderState.theMelodyParms.enabled)||(theMeanderState.theArpParms.enabled))&&theMeanderState.theArpParms.note_count<32)
+		{
+			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].note=note_to_play;
+			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].noteType=NOTE_TYPE_ARP;
+			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].length=theMeanderState.theArpParms.note_length_divisor;
+			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].time32s=barts_count;
+			theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count].countInBar=bar_note_count;
+			recordPlayedNote(theMeanderState.theArpParms.last[theMeanderState.theArpParms.note_count]);
+		}
+	
+		setOutputChannels(OUT_MELODY_CV_OUTPUT, 1);  // set polyphony  may need to deal with unset channel voltages
+		setOutputVoltage(OUT_MELODY_CV_OUTPUT, ((note_to_play/12.0) -4.0) ,0);  // (note, channel) -4 since midC=c4=0vsetOutputVoltage(OUT_MELODY_CV_OUTPUT, (note_to_play -4 + theMeanderState.theMelodyParms.target_octave,0);  // (note, channel) -4 since midC=c4=0v
+		setOutputVoltage(OUT_MELODY_VOLUME_OUTPUT, volume);  // this is strictly for arp decay
+		resetGate(OUT_MELODY_GATE_OUTPUT);  // kill the pulse in case it is active
+		float durationFactor=1.0;
+		if (theMeanderState.theMelodyParms.enable_staccato)
+			durationFactor=0.5;
+		else
+			durationFactor=0.95;
+		float note_duration=durationFactor*4/(frequency*theMeanderState.theArpParms.note_length_divisor);
+		triggerGate(OUT_MELODY_GATE_OUTPUT, note_duration);  
+	}
+ 
+
+	void doBass()
+	{
+		MeanderProfiler::Scope profile(profiler, PROFILE_BASS);
+		if (doDebug) DEBUG("doBass()");
+
+	    setOutputVoltage(OUT_BASS_VOLUME_OUTPUT, theMeanderState.theBassParms.volume);
+				
+		if (theMeanderState.theBassParms.enabled) 
+		{
+			++theMeanderState.theBassParms.bar_bass_counted_note;
+			if ((theMeanderState.theBassParms.syncopate)&&(theMeanderState.theBassParms.bar_bass_counted_note==2))  // experimenting with bass patterns
+			  return;
+			if ((theMeanderState.theBassParms.shuffle)&&((theMeanderState.theBassParms.bar_bass_counted_note%3)==2))  // experimenting with bass patterns
+			return;
+
+			if (theMeanderState.theBassParms.octave_enabled)
+				setOutputChannels(OUT_BASS_CV_OUTPUT, 2);  // set polyphony  may need to deal with unset channel voltages
+			else
+				setOutputChannels(OUT_BASS_CV_OUTPUT, 1);  // set polyphony  may need to deal with unset channel voltages
+			if (doDebug) DEBUG("    bass note to play=%d %s", theMeanderState.last_harmony_chord_root_note, note_desig[theMeanderState.last_harmony_chord_root_note%MAX_NOTES]);
+				
+			theMeanderState.theBassParms.last[0].note=theMeanderState.last_harmony_chord_root_note+ (theMeanderState.theBassParms.target_octave*12);  
+			theMeanderState.theBassParms.last[0].noteType=NOTE_TYPE_BASS;
+			theMeanderState.theBassParms.last[0].length=1;  // need bass notes per measure
+			theMeanderState.theBassParms.last[0].time32s=barts_count;
+			theMeanderState.theBassParms.last[0].countInBar=bar_note_count;
+			recordPlayedNote(theMeanderState.theBassParms.last[0]);
+
+			setOutputVoltage(OUT_BASS_CV_OUTPUT, (theMeanderState.last_harmony_chord_root_note/12.0)-4.0 +theMeanderState.theBassParms.target_octave ,0);  //(note, channel)	
+				
+			if (theMeanderState.theBassParms.octave_enabled)
+			{
+		
+				theMeanderState.theBassParms.last[1].note=theMeanderState.theBassParms.last[0].note+12; 
+				theMeanderState.theBassParms.last[1].noteType=NOTE_TYPE_BASS;
+				theMeanderState.theBassParms.last[1].length=1;  // need bass notes per measure
+				theMeanderState.theBassParms.last[1].time32s=barts_count;
+				theMeanderState.theBassParms.last[1].countInBar=bar_note_count;
+				recordPlayedNote(theMeanderState.theBassParms.last[1]);
+
+			 	setOutputVoltage(OUT_BASS_CV_OUTPUT, (theMeanderState.last_harmony_chord_root_note/12.0)-3.0 +theMeanderState.theBassParms.target_octave ,1);
+			}
+
+			if (!theMeanderState.theBassParms.accent)  // need to redo with new gate procedure
+			{
+				theMeanderState.theBassParms.note_accented=false; 
+			}
+			else
+			{
+				if (theMeanderState.theBassParms.bar_bass_counted_note==1)  // experimenting with bass patterns
+					theMeanderState.theBassParms.note_accented=true; 
+				else
+					theMeanderState.theBassParms.note_accented=false; 
+			}	
+			
+			float durationFactor=1.0;
+			if (theMeanderState.theBassParms.enable_staccato)
+				durationFactor=0.5;
+			else
+				durationFactor=0.95;
+			
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BAR_OUTPUT)
+				durationFactor*=1.0;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEAT_OUTPUT)
+				durationFactor*=.25;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX2_OUTPUT)
+				durationFactor*=.125;
+			else	
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX4_OUTPUT)
+				durationFactor*=.0625;	
+			else
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port==OUT_CLOCK_BEATX8_OUTPUT)
+				durationFactor*=.03125;	
+			else
+			if ( prog_step_input_connected) // something is connected to the circle STEP input but we do not know what. Assume it is an 16X BPM frequency
+		   		durationFactor *= .01562;  
+			
+			float note_duration=durationFactor*time_sig_top/(frequency*theMeanderState.theBassParms.note_length_divisor);
+
+		    triggerGate(OUT_BASS_GATE_OUTPUT, note_duration);  
+		}
+	}
+
+	// The generator calls due on the tick being generated, in the order they run.  A tick's generation is split so a
+	// host can spread it over several samples: beginClockTick() steps the clock counters and queues the calls,
+	// runNextGenerator() makes one call, and endClockTick() finishes the tick.  At most one call per part is due.
+	enum GeneratorCalls { GENERATE_HARMONY, GENERATE_BASS, GENERATE_MELODY, GENERATE_ARP };
+	int pending_generators[4]={};
+	int pending_generator_count=0;
+	int next_pending_generator=0;
+	int pending_barChordNumber=0;
+
+	void queueGenerator(int generator)
+	{
+		if (pending_generator_count<4)
+			pending_generators[pending_generator_count++]=generator;
+	}
+
+	// false once every call queued for the tick has been made
+	bool runNextGenerator()
+	{
+		if (next_pending_generator>=pending_generator_count)
+			return false;
+		switch (pending_generators[next_pending_generator++])
+		{
+			case GENERATE_HARMONY: doHarmony(pending_barChordNumber, theMeanderState.theHarmonyParms.enabled); break;
+			case GENERATE_BASS:    doBass();   break;
+			case GENERATE_MELODY:  doMelody(); break;
+			case GENERATE_ARP:     doArp();    break;
+		}
+		return true;
+	}
+
+	// called once per 32nd note clock tick while running, drives all of the generators
+	void processClockTick()
+	{
+		beginClockTick();
+		while (runNextGenerator())
+			;
+		endClockTick();
+	}
+
+	void beginClockTick()
+	{
+		bool melodyPlayed=false;   // set to prevent arp note being played on the melody beat
+		pending_barChordNumber=(int)((int)(barts_count*theMeanderState.theHarmonyParms.note_length_divisor)/(int)32);
+		pending_generator_count=0;
+		next_pending_generator=0;
+	
+		// bar
+		if (barts_count == 0) 
+		{
+			theMeanderState.theMelodyParms.bar_melody_counted_note=0;
+			theMeanderState.theBassParms.bar_bass_counted_note=0;
+			bar_note_count=0;
+			if ((theMeanderState.theHarmonyParms.note_length_divisor==1)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_HARMONY);
+			if ((theMeanderState.theBassParms.note_length_divisor==1)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_BASS);
+			if ((theMeanderState.theMelodyParms.note_length_divisor==1)&&(!theMeanderState.userControllingMelody))
+			{
+				queueGenerator(GENERATE_MELODY);
+				melodyPlayed=true;
+			}
+			triggerClockPulse(1);
+		}
+				
+        // i2ts
+		if (i2ts_count == 0)
+		{
+			if ((theMeanderState.theHarmonyParms.note_length_divisor==2)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_HARMONY);
+			if ((theMeanderState.theBassParms.note_length_divisor==2)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_BASS);
+			if ((theMeanderState.theMelodyParms.note_length_divisor==2)&&(!theMeanderState.userControllingMelody))
+			{
+				queueGenerator(GENERATE_MELODY);
+				melodyPlayed=true;
+			}
+			i2ts_count++;
+
+			if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+				triggerClockPulse(2);
+		}
+		else
+		if (i2ts_count == (i2ts_count_limit-1))
+		{
+			i2ts_count = 0;    
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+				triggerClockPulse(2);
+		}
+		else
+		{
+			i2ts_count++;
+		}
+						
+
+		// i4ts
+		if (i4ts_count == 0)
+		{
+			if ((theMeanderState.theHarmonyParms.note_length_divisor==4)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_HARMONY);
+			if ((theMeanderState.theBassParms.note_length_divisor==4)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_BASS);
+			if ((theMeanderState.theMelodyParms.note_length_divisor==4)&&(!theMeanderState.userControllingMelody))
+			{
+				queueGenerator(GENERATE_MELODY);
+				melodyPlayed=true;
+			}
+			if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==4)&&(!melodyPlayed))
+				queueGenerator(GENERATE_ARP);
+
+			i4ts_count++;
+
+			if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+			 	triggerClockPulse(4);
+		}
+		else
+		if (i4ts_count == (i4ts_count_limit-1))
+		{
+			i4ts_count = 0;  
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+			 	triggerClockPulse(4);
+		}
+		else
+		{
+			i4ts_count++;
+		}
+		
+			  
+ 		// i8ts
+		if (i8ts_count == 0)
+		{
+			if ((theMeanderState.theHarmonyParms.note_length_divisor==8)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_HARMONY);
+			if ((theMeanderState.theBassParms.note_length_divisor==8)&&(!theMeanderState.userControllingHarmonyFromCircle))
+				queueGenerator(GENERATE_BASS);
+			if ((theMeanderState.theMelodyParms.note_length_divisor==8)&&(!theMeanderState.userControllingMelody))
+			{
+				queueGenerator(GENERATE_MELODY);
+				melodyPlayed=true;
+			}
+			if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==8)&&(!melodyPlayed))
+				queueGenerator(GENERATE_ARP);
+
+			i8ts_count++;
+
+			if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+				triggerClockPulse(8);
+		}
+		else
+		if (i8ts_count == (i8ts_count_limit-1))
+		{
+			i8ts_count = 0; 
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+			  triggerClockPulse(8);
+		}
+		else
+		{
+			i8ts_count++; 
+		}
+		
+		
+		// i16ts
+		if (i16ts_count == 0)
+		{
+			if ((theMeanderState.theMelodyParms.note_length_divisor==16)&&(!theMeanderState.userControllingMelody))
+			{
+				queueGenerator(GENERATE_MELODY);  
+				melodyPlayed=true;  
+			}
+			if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==16)&&(!melodyPlayed))
+				queueGenerator(GENERATE_ARP);
+
+			i16ts_count++;
+
+			if (!theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+				triggerClockPulse(16);
+		}
+		else
+		if (i16ts_count == (i16ts_count_limit-1))
+		{
+			i16ts_count = 0;
+			if (theMeanderState.theHarmonyParms.STEP_inport_connected_to_Meander_trigger_port)
+				triggerClockPulse(16);
+		}
+		else
+		{
+			i16ts_count++;
+		}
+		
+
+		//32nds  ***********************************
+
+		 // do on each 1/32nd clock tick
+		
+		if ((theMeanderState.theMelodyParms.note_length_divisor==32)&&(!theMeanderState.userControllingMelody))
+		{
+			queueGenerator(GENERATE_MELODY);   
+			melodyPlayed=true; 
+		}
+		if ((theMeanderState.theArpParms.enabled)&&(theMeanderState.theArpParms.note_length_divisor==32)&&(!melodyPlayed))
+			queueGenerator(GENERATE_ARP); 
+	}
+
+	// after the tick's generator calls
+	void endClockTick()
+	{
+		// output some fBm noise
+		double fBmrand=fBmValue(RANDOM_PART_ARP, theMeanderState.theArpParms.seed, theMeanderState.theArpParms.period, theMeanderState.theArpParms.noctaves); 
+		setOutputChannels(OUT_FBM_ARP_OUTPUT, 1);  // set polyphony  
+		setOutputVoltage(OUT_FBM_ARP_OUTPUT, (float)clamp((10.f*fBmrand), 0.f, 10.f) ,0);  // rescale fBm output to 0-10V so it can be used better for CV
+		
+		if (barts_count == (barts_count_limit-1))  // do this after all processing so bar_count does not get incremented too early
+		{
+			barts_count = 0;  
+			theMeanderState.theMelodyParms.bar_melody_counted_note=0;
+			theMeanderState.theBassParms.bar_bass_counted_note=0;
+			bar_note_count=0;
+			if (!theMeanderState.userControllingHarmonyFromCircle)  // don't mess up bar count
+			++bar_count; 
+		}
+		else
+		{
+			barts_count++;  
+		}
+		
+		triggerClockPulse(32);  // retrigger the pulse after all done in this loop
+	}
+
+	// zero the clock counters, as on stop and reset
+	void resetClockCounters()
+	{
+		i16ts_count = 0;  
+		i8ts_count = 0;  
+		i4ts_count = 0; 
+		i2ts_count = 0; 
+		barts_count = 0;    
+		
+		theMeanderState.theMelodyParms.bar_melody_counted_note=0;
+		theMeanderState.theArpParms.note_count=0;
+		theMeanderState.theBassParms.bar_bass_counted_note=0;
+	}
+
+	// Fast-forward an engine that has not played yet to the start of bar, by running every tick before it with
+	// onNotePlayed() muted.  This is not a jump: the cost grows with bar, about 0.3 ms per 100 bars.  It has to replay
+	// them because the random draws are keyed on bar_count, which doHarmony() moves for some presets, the random home
+	// and Markov progressions are walks from the last step, and the voicing and the melody follow the last notes
+	// played.  None of that can be computed from the bar alone yet.
+	bool seeking=false;
+
+	void seekToBar(int bar)
+	{
+		seeking=true;
+		for (long long tick=0; tick<(long long)bar*barts_count_limit; ++tick)
+			processClockTick();
+		seeking=false;
+	}
+
+	// rebuild everything that depends on root_key, mode and the harmony preset.  The key and mode tables are all
+	// precomputed, and the presets do not depend on key or mode, so only the harmony steps are set up again here.
+	void rebuildCircle()
+	{
+		MeanderProfiler::Scope profile(profiler, PROFILE_CIRCLE_REBUILD);
+		if (doDebug) DEBUG("circleChanged");	
+		selectKeyModeTables();
+		setup_harmony();  // calculate harmony notes
+		circleChanged=false;
+	}
+
+	void setHarmonyPreset(int preset)
+	{
+		harmony_type=preset;
+		theMeanderState.theHarmonyParms.markov_history=-1;
+		init_harmony(); // reinitialize in case user has changed harmony parms
+		copyHarmonyTypeToActiveHarmonyType(harmony_type);
+		circleChanged=true;  // trigger off reconstruction and setup
+		setup_harmony();  // calculate harmony notes
+	}
+
+	// switch to another preset bank, keeping the preset number if the new bank has that many
+	void setHarmonyPresetBank(const HarmonyPresetBank* bank)
+	{
+		harmonyPresetBank=(bank) ? bank : &theBuiltinHarmonyPresetBank;
+		setHarmonyPreset(harmony_type);
+	}
+};  // end struct MeanderEngine
@@ -0,0 +1,83 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Gate and trigger outputs as integer sample countdowns.  Durations are converted to samples once, when the gate
+// starts, and process() only visits the gates that are active, so with nothing sounding a pass is a couple of
+// mask operations.  process() reports which outputs change on this sample so the caller only writes those.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+enum MeanderGateIds
+{
+	GATE_HARMONY,
+	GATE_MELODY,
+	GATE_BASS,
+	GATE_CLOCK_BAR,     // 1ts
+	GATE_CLOCK_BEAT,    // 4ts
+	GATE_CLOCK_BEATX2,  // 8ts
+	GATE_CLOCK_BEATX4,  // 16ts
+	GATE_CLOCK_BEATX8,  // 32ts
+	GATE_RUN,
+	GATE_RESET,
+	NUM_GATES
+};
+
+struct MeanderGates
+{
+	int32_t remaining[NUM_GATES]={};  // samples left, only meaningful while the gate's active bit is set
+	uint32_t active_mask=0;            // gates still counting down
+	uint32_t high_mask=0;              // gates that are high on the current sample
+	float sample_rate=0.f;
+
+	void setSampleRate(float sampleRate)
+	{
+		sample_rate=sampleRate;
+	}
+
+	int32_t toSamples(float seconds)
+	{
+		int32_t samples=(int32_t)std::ceil(seconds*sample_rate);
+		return (samples<1) ? 1 : samples;
+	}
+
+	// like dsp::PulseGenerator::trigger(), never shortens a gate that is already longer
+	void trigger(int gate, float seconds)
+	{
+		int32_t samples=toSamples(seconds);
+		if (!(active_mask & (1u<<gate)) || (samples>remaining[gate]))
+			remaining[gate]=samples;
+		active_mask|=(1u<<gate);
+	}
+
+	void reset(int gate)
+	{
+		active_mask&=~(1u<<gate);
+	}
+
+	bool isHigh(int gate)
+	{
+		return (high_mask>>gate)&1u;
+	}
+
+	// once per sample.  Returns the gates whose output changes on this sample.
+	uint32_t process()
+	{
+		uint32_t previous=high_mask;
+		high_mask=active_mask;
+		uint32_t counting=active_mask;
+		while (counting)
+		{
+			int gate=__builtin_ctz(counting);
+			counting&=counting-1;
+			if (--remaining[gate]<=0)
+				active_mask&=~(1u<<gate);  // still high on this sample, low from the next
+		}
+		return previous^high_mask;
+	}
+};
@@ -0,0 +1,114 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Minimal stand-ins for the few Rack helpers MeanderEngine.hpp uses, so the engine can be compiled without the
+// Rack SDK by defining MEANDER_HEADLESS.  Only what the engine needs is here: Vec, clamp, mm2px, random and DEBUG.
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+
+namespace rack {
+
+namespace math {
+
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+inline float clamp(float x, float a, float b) { return std::fmax(std::fmin(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+
+struct Vec
+{
+	float x = 0.f;
+	float y = 0.f;
+
+	Vec() {}
+	Vec(float xy) : x(xy), y(xy) {}
+	Vec(float x, float y) : x(x), y(y) {}
+
+	Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+	Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+	Vec mult(float s) const { return Vec(x * s, y * s); }
+	Vec div(float s) const { return Vec(x / s, y / s); }
+	float norm() const { return std::hypot(x, y); }
+	Vec normalize() const { return div(norm()); }
+};
+
+}  // namespace math
+
+using math::Vec;
+using math::clamp;
+
+static const float SVG_DPI = 75.f;
+static const float MM_PER_IN = 25.4f;
+
+inline float mm2px(float mm) { return mm * (SVG_DPI / MM_PER_IN); }
+inline math::Vec mm2px(math::Vec mm) { return mm.mult(SVG_DPI / MM_PER_IN); }
+
+namespace random {
+
+// xoroshiro128+, same generator Rack uses, but with an explicit seed so offline renders can be repeated
+struct Xoroshiro128Plus
+{
+	uint64_t state[2] = {0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL};
+
+	static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+	void seed(uint64_t s)
+	{
+		// splitmix64 so that small seeds still give well mixed state
+		for (int i = 0; i < 2; ++i) {
+			uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			state[i] = z ^ (z >> 31);
+		}
+	}
+	uint64_t next()
+	{
+		uint64_t s0 = state[0];
+		uint64_t s1 = state[1];
+		uint64_t result = s0 + s1;
+		s1 ^= s0;
+		state[0] = rotl(s0, 55) ^ s1 ^ (s1 << 14);
+		state[1] = rotl(s1, 36);
+		return result;
+	}
+};
+
+inline Xoroshiro128Plus& local()
+{
+	static Xoroshiro128Plus rng;
+	return rng;
+}
+
+inline void init() {}
+inline void seed(uint64_t s) { local().seed(s); }
+inline uint32_t u32() { return (uint32_t)(local().next() >> 32); }
+inline float uniform() { return (u32() >> 8) / 16777216.f; }
+
+}  // namespace random
+
+inline void debugLog(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "[debug] ");
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
+
+}  // namespace rack
+
+#define DEBUG(...) rack::debugLog(__VA_ARGS__)
+
+using namespace rack;
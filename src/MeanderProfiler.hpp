@@ -0,0 +1,304 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Section timers for process(), so the cause of an xrun in a running patch can be found without a profiler.  Off by
+// default, when a section costs one relaxed load.  When on, a section reads the CPU cycle counter (steady_clock where
+// there is none) as it starts and ends, and counts the cost into the section's histogram with relaxed atomic
+// increments, so the UI thread can read the mean, 99th percentile and maximum while the audio thread keeps counting.
+// process() only runs on one thread at a time, so an increment is a relaxed load and store, not a locked add.  For
+// that to hold the audio thread is the only writer: turning timing on only asks for the counts to be cleared, and
+// process() clears them and sets the start time at its top, see startIfRequested().
+// Sections nest: the clock tick includes the generators it runs, and the control scan includes the circle rebuild.
+//
+// MeanderFrameProfiler does the same for the panel's drawing, on the UI thread, over a rolling window of frames.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MEANDER_PROFILE_RDTSC
+#endif
+
+enum MeanderProfileSections
+{
+	PROFILE_PROCESS,         // all of process()
+	PROFILE_CLOCK_TICK,      // clock input, playing the tick and generating ahead
+	PROFILE_HARMONY,         // doHarmony()
+	PROFILE_MELODY,          // doMelody()
+	PROFILE_ARP,             // doArp()
+	PROFILE_BASS,            // doBass()
+	PROFILE_TOGGLES,         // the enable toggles and the circle step buttons
+	PROFILE_CONTROL_SCAN,    // the lowFreqClock scan of the controls and inputs
+	PROFILE_CIRCLE_REBUILD,  // rebuildCircle()
+	NUM_PROFILE_SECTIONS
+};
+
+const char* profileSectionNames[NUM_PROFILE_SECTIONS]={"process()", "clock tick", "doHarmony()", "doMelody()", "doArp()",
+	"doBass()", "toggles", "control scan", "circle rebuild"};
+const char* profileSectionKeys[NUM_PROFILE_SECTIONS]={"process", "clock_tick", "doHarmony", "doMelody", "doArp",
+	"doBass", "toggles", "control_scan", "circle_rebuild"};  // for dataToJson()
+
+struct MeanderProfiler
+{
+	static const int BINS=128;  // 4 per octave of ticks, the last also holds anything over 2^32
+
+	struct Section
+	{
+		std::atomic<uint32_t> bins[BINS];
+		std::atomic<uint64_t> ticks;
+		std::atomic<uint64_t> max;
+	};
+
+	// costs in ns
+	struct Stats
+	{
+		uint64_t count=0;
+		double mean=0.0;
+		double p99=0.0;
+		double max=0.0;
+	};
+
+	std::atomic<bool> enabled;
+	std::atomic<bool> clearRequested;  // by enable(), until the audio thread has cleared the counts
+	Section sections[NUM_PROFILE_SECTIONS];
+	uint64_t startTicks=0;  // when the counts were cleared, to convert ticks to ns.  Read once clearRequested is false
+	std::chrono::steady_clock::time_point startTime;
+
+	MeanderProfiler()
+	{
+		enabled=false;
+		clearRequested=false;
+		clear();
+		startTicks=now();
+		startTime=std::chrono::steady_clock::now();
+	}
+
+	static uint64_t now()
+	{
+#if defined(MEANDER_PROFILE_RDTSC)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	static int binOf(uint64_t ticks)
+	{
+		if (ticks<4)
+			return (int)ticks;
+		int octave=63-__builtin_clzll(ticks);
+		int bin=(octave-1)*4+(int)((ticks>>(octave-2))&3);
+		return (bin<BINS) ? bin : BINS-1;
+	}
+
+	// the fewest ticks that fall in bin
+	static uint64_t binStart(int bin)
+	{
+		if (bin<4)
+			return bin;
+		return (uint64_t)(4+bin%4)<<(bin/4-1);
+	}
+
+	void clear()
+	{
+		for (Section& section : sections)
+		{
+			for (std::atomic<uint32_t>& bin : section.bins)
+				bin.store(0, std::memory_order_relaxed);
+			section.ticks.store(0, std::memory_order_relaxed);
+			section.max.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// from the UI thread.  Turning timing on starts the counts again, once process() gets to it.
+	void enable(bool on)
+	{
+		if (on && !enabled)
+			clearRequested.store(true, std::memory_order_relaxed);
+		enabled=on;
+	}
+
+	// from the audio thread, at the top of process() before any section starts
+	void startIfRequested()
+	{
+		if (!clearRequested.load(std::memory_order_acquire))
+			return;
+		clear();
+		startTicks=now();
+		startTime=std::chrono::steady_clock::now();
+		clearRequested.store(false, std::memory_order_release);  // publishes the cleared counts and the start time
+	}
+
+	// 0 when timing is off, so end() records nothing
+	uint64_t begin()
+	{
+		return enabled.load(std::memory_order_relaxed) ? now() : 0;
+	}
+
+	void end(int section, uint64_t start)
+	{
+		if (!start)
+			return;
+		uint64_t ticks=now()-start;
+		Section& s=sections[section];
+		std::atomic<uint32_t>& bin=s.bins[binOf(ticks)];
+		bin.store(bin.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+		s.ticks.store(s.ticks.load(std::memory_order_relaxed)+ticks, std::memory_order_relaxed);
+		if (ticks>s.max.load(std::memory_order_relaxed))
+			s.max.store(ticks, std::memory_order_relaxed);
+	}
+
+	// times the rest of the enclosing block, whichever way it returns
+	struct Scope
+	{
+		MeanderProfiler& profiler;
+		int section;
+		uint64_t start;
+
+		Scope(MeanderProfiler& theProfiler, int theSection) : profiler(theProfiler), section(theSection), start(theProfiler.begin()) {}
+		~Scope() { profiler.end(section, start); }
+	};
+
+	// cycle counter ticks are measured against steady_clock over the time since timing was turned on
+	double nsPerTick() const
+	{
+#if defined(MEANDER_PROFILE_RDTSC)
+		double ns=std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now()-startTime).count();
+		uint64_t ticks=now()-startTicks;
+		return (ticks>0) ? ns/ticks : 0.0;
+#else
+		return 1.0;
+#endif
+	}
+
+	// nothing while a clear is still waiting for process()
+	Stats stats(int section) const
+	{
+		const Section& s=sections[section];
+		Stats stats;
+		if (clearRequested.load(std::memory_order_acquire))
+			return stats;
+		uint32_t bins[BINS];
+		for (int i=0; i<BINS; ++i)
+		{
+			bins[i]=s.bins[i].load(std::memory_order_relaxed);
+			stats.count+=bins[i];
+		}
+		if (!stats.count)
+			return stats;
+		double scale=nsPerTick();
+		uint64_t max=s.max.load(std::memory_order_relaxed);
+		stats.mean=scale*s.ticks.load(std::memory_order_relaxed)/stats.count;
+		stats.max=scale*max;
+		uint64_t target=(stats.count*99+99)/100, seen=0;
+		for (int i=0; i<BINS; ++i)
+			if ((seen+=bins[i])>=target)
+			{
+				uint64_t top=(i+1<BINS) ? binStart(i+1) : max;  // the top of the bin
+				stats.p99=scale*((top<max) ? top : max);
+				break;
+			}
+		return stats;
+	}
+
+	// one line for the menu, e.g. "doMelody()  mean 1.24us  p99 3.10us  max 12.8us"
+	void describe(int section, char* text, size_t size) const
+	{
+		Stats s=stats(section);
+		if (!s.count)
+			snprintf(text, size, "%s  not run yet", profileSectionNames[section]);
+		else
+			snprintf(text, size, "%s  mean %.3gus  p99 %.3gus  max %.3gus", profileSectionNames[section], s.mean/1000.0,
+				s.p99/1000.0, s.max/1000.0);
+	}
+};
+
+enum MeanderFrameSections
+{
+	FRAME_CIRCLE,        // DrawCircle5ths()
+	FRAME_DEGREES,       // DrawDegreesSemicircle()
+	FRAME_PARAM_LINES,   // the parameter lines in updatePanel()
+	FRAME_STAFF_NOTES,   // the notes on the staves
+	FRAME_PANEL_REST,    // the rest of updatePanel(): jack borders, staves, key signatures, note and chord names
+	FRAME_TOTAL,         // the whole frame
+	NUM_FRAME_SECTIONS
+};
+
+const char* frameSectionNames[NUM_FRAME_SECTIONS]={"DrawCircle5ths", "DrawDegreesSemicircle", "param lines", "staff notes",
+	"rest of panel", "frame"};
+
+// Draw times of the circle of 5ths panel, in ms.  Each mark() charges the time since the last mark to a section, so the
+// sections add up to the frame.
+struct MeanderFrameProfiler
+{
+	static const int FRAMES=64;  // rolling window
+	typedef std::chrono::steady_clock Clock;
+
+	bool enabled=false;
+	double times[FRAMES][NUM_FRAME_SECTIONS]={};
+	int frame=0;   // next slot in times
+	int frames=0;  // filled slots
+	Clock::time_point frameStart;
+	Clock::time_point lastMark;
+
+	static double ms(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end-start).count();
+	}
+
+	void beginFrame()
+	{
+		if (!enabled)
+			return;
+		for (double& time : times[frame])
+			time=0.0;
+		frameStart=lastMark=Clock::now();
+	}
+
+	void mark(int section)
+	{
+		if (!enabled)
+			return;
+		Clock::time_point now=Clock::now();
+		times[frame][section]+=ms(lastMark, now);
+		lastMark=now;
+	}
+
+	void endFrame()
+	{
+		if (!enabled)
+			return;
+		times[frame][FRAME_TOTAL]=ms(frameStart, Clock::now());
+		frame=(frame+1)%FRAMES;
+		if (frames<FRAMES)
+			++frames;
+	}
+
+	void enable(bool on)
+	{
+		if (on && !enabled)
+			frame=frames=0;
+		enabled=on;
+	}
+
+	// over the window, e.g. "DrawCircle5ths  0.412 ms  max 0.803"
+	void describe(int section, char* text, size_t size) const
+	{
+		double sum=0.0, max=0.0;
+		for (int i=0; i<frames; ++i)
+		{
+			sum+=times[i][section];
+			if (times[i][section]>max)
+				max=times[i][section];
+		}
+		snprintf(text, size, "%s  %.3f ms  max %.3f", frameSectionNames[section], (frames) ? sum/frames : 0.0, max);
+	}
+};
@@ -0,0 +1,90 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Lookahead event scheduling.  The engine's generators run a few 32nd note ticks ahead of playback and everything
+// they output is queued here, stamped with the tick it belongs to.  Playback then only has to pop the events whose
+// tick has arrived.  Generation and playback both run in process(), on the audio thread, so the queue is a plain
+// ring with no synchronization.
+//
+// This is not a producer thread filling a lock-free queue a bar ahead.  The generators read state that process()
+// changes as it runs: the controls and CV inputs from the lowFreqClock scan, and live step, circle and degree input.
+// A generator thread would need all of that passed to it as messages, and live input would be heard a bar late.
+// Instead the audio thread generates 2 ticks ahead, one generator call per sample, see Meander::generateStep(), which
+// bounds the cost of a sample but does not take generation off the audio thread.
+
+#pragma once
+
+#include <cstdint>
+
+// Fixed size FIFO ring.  SIZE must be a power of 2.  Indices run freely and are masked on access, so full and empty
+// are told apart without a spare slot.
+template <typename T, uint32_t SIZE>
+struct EventRing
+{
+	static_assert((SIZE & (SIZE - 1)) == 0, "EventRing SIZE must be a power of 2");
+
+	T items[SIZE];
+	uint32_t head=0;  // next to pop
+	uint32_t tail=0;  // next to push
+
+	// returns false if full
+	bool push(const T& item)
+	{
+		if (tail - head >= SIZE)
+			return false;
+		items[tail & (SIZE - 1)] = item;
+		++tail;
+		return true;
+	}
+
+	// NULL if empty
+	const T* front()
+	{
+		if (head == tail)
+			return NULL;
+		return &items[head & (SIZE - 1)];
+	}
+
+	void pop()
+	{
+		++head;
+	}
+
+	// drops everything pushed so far
+	void clear()
+	{
+		head = tail;
+	}
+
+	uint32_t size()
+	{
+		return tail - head;
+	}
+};
+
+enum ScheduledEventTypes
+{
+	EVENT_OUTPUT_CHANNELS,
+	EVENT_OUTPUT_VOLTAGE,
+	EVENT_LIGHT_BRIGHTNESS,
+	EVENT_GATE_TRIGGER,
+	EVENT_GATE_RESET,
+	EVENT_CLOCK_PULSE
+};
+
+// one MeanderEngine output hook call, to be replayed when playback reaches tick
+struct ScheduledEvent
+{
+	long long tick;
+	int type;     // ScheduledEventTypes
+	int id;       // output, light or clock division
+	int channel;
+	float value;  // voltage, brightness or gate duration
+};
+
+#define MAX_SCHEDULED_EVENTS 1024
+
+typedef EventRing<ScheduledEvent, MAX_SCHEDULED_EVENTS> ScheduledEventQueue;
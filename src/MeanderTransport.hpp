@@ -0,0 +1,95 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Internal 32nd note clock.  Rather than stepping an LFO and polling for its edge every sample, the transport knows
+// the sample position of the next tick and only counts samples until it arrives.  Tick positions are computed from
+// a 64-bit sample position and the number of ticks since the last rate change, not accumulated, so there is no
+// drift however long a session runs.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+struct MeanderTransport
+{
+	uint64_t sample_position=0;    // samples since reset
+	uint64_t next_tick_sample=0;   // sample position of the next tick
+	uint64_t last_tick_sample=0;
+	uint64_t clock_fall_sample=0;  // halfway through the current tick, where the clock output square goes low
+	uint64_t anchor_sample=0;      // tick anchor_tick fell on anchor_sample, moved on each rate change
+	long long anchor_tick=0;
+	long long tick_count=0;        // ticks since reset
+
+	double samples_per_tick=1.0;
+	float ticks_per_second=0.f;
+	float sample_rate=0.f;
+
+	uint64_t tickSample(long long tick)
+	{
+		return anchor_sample + (uint64_t)std::llround((tick-anchor_tick)*samples_per_tick);
+	}
+
+	// cheap to call every sample, only does any work when the rate actually changes
+	void setRate(float ticksPerSecond, float sampleRate)
+	{
+		if ((ticksPerSecond==ticks_per_second)&&(sampleRate==sample_rate))
+			return;
+		if ((ticksPerSecond<=0.f)||(sampleRate<=0.f))
+			return;
+		ticks_per_second=ticksPerSecond;
+		sample_rate=sampleRate;
+		samples_per_tick=(double)sampleRate/ticksPerSecond;
+
+		if (tick_count>0)  // the new rate takes effect from the last tick
+		{
+			anchor_tick=tick_count-1;
+			anchor_sample=last_tick_sample;
+			next_tick_sample=tickSample(tick_count);
+			if (next_tick_sample<sample_position)
+				next_tick_sample=sample_position;
+			clock_fall_sample=last_tick_sample+(next_tick_sample-last_tick_sample)/2;
+		}
+	}
+
+	// the next sample will be tick 0
+	void reset()
+	{
+		sample_position=0;
+		next_tick_sample=0;
+		last_tick_sample=0;
+		clock_fall_sample=0;
+		anchor_sample=0;
+		anchor_tick=0;
+		tick_count=0;
+	}
+
+	// advance one sample, true if a tick falls on it
+	bool process()
+	{
+		bool tick=(sample_position>=next_tick_sample);
+		if (tick)
+		{
+			last_tick_sample=sample_position;
+			++tick_count;
+			next_tick_sample=tickSample(tick_count);
+			clock_fall_sample=last_tick_sample+(next_tick_sample-last_tick_sample)/2;
+		}
+		++sample_position;
+		return tick;
+	}
+
+	// true on the one sample where the clock output square falls, call after process()
+	bool clockFalls()
+	{
+		return (sample_position-1)==clock_fall_sample;
+	}
+
+	uint64_t samplesUntilTick()
+	{
+		return next_tick_sample-sample_position;
+	}
+};
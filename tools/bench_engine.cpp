@@ -0,0 +1,247 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Whole-engine benchmark.  Builds the module against the Rack stub in tools/rackstub, so needs no Rack SDK, and times
+// every Meander::process() call with everything enabled: all four parts, all outputs patched and the fBm outputs smooth
+// on 16 channels.  For each harmony preset, mode and tempo from min_bpm to max_bpm, a fresh module runs for some
+// seconds of audio, then doHarmony(), doMelody(), doArp(), doBass(), setup_harmony() and the circleChanged rebuild
+// are each called and timed directly.  Reports the mean, 99th percentile and maximum cost, overall and by tempo, mode
+// and preset, so a spike on one preset shows as well as the average.  Build with "make bench_engine".
+//
+// usage: bench_engine [--presets first-last] [--modes first-last] [--tempos n] [--seconds s] [--calls n] [--rate hz]
+//
+// --tempos is how many tempos, evenly spaced from min_bpm to max_bpm.  --calls is how many times each function is
+// called per configuration.
+
+#include "../src/Meander.cpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+Plugin *pluginInstance;
+
+// Costs in ns, in bins 1% wide, so the percentiles need no stored samples.
+struct CostHistogram
+{
+	static constexpr double GROWTH = 1.01;
+	std::vector<uint64_t> bins = std::vector<uint64_t>(2048, 0);
+	uint64_t count = 0;
+	double sum = 0.0, max = 0.0;
+
+	void add(double ns)
+	{
+		ns = std::max(ns, 1.0);
+		int bin = std::min((int)(std::log(ns) / std::log(GROWTH)), (int)bins.size() - 1);
+		++bins[bin];
+		++count;
+		sum += ns;
+		max = std::max(max, ns);
+	}
+
+	void add(const CostHistogram& other)
+	{
+		for (size_t i = 0; i < bins.size(); ++i)
+			bins[i] += other.bins[i];
+		count += other.count;
+		sum += other.sum;
+		max = std::max(max, other.max);
+	}
+
+	double mean() const { return count ? sum / count : 0.0; }
+
+	double percentile(double p) const
+	{
+		uint64_t target = (uint64_t)std::ceil(p / 100.0 * count), seen = 0;
+		for (size_t i = 0; i < bins.size(); ++i)
+			if ((seen += bins[i]) >= target && bins[i])
+				return std::min(std::pow(GROWTH, i + 1), max);  // the top of the bin
+		return max;
+	}
+
+	void print(const char* name) const
+	{
+		printf("  %-28s %10.1f %10.1f %10.1f\n", name, mean(), percentile(99.0), max);
+	}
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_ns(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// the smallest cost of reading the clock twice, taken off every timing
+static double clock_overhead()
+{
+	double best = 1e30;
+	for (int i = 0; i < 10000; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		best = std::min(best, elapsed_ns(start, Clock::now()));
+	}
+	return best;
+}
+
+static bool parse_range(const char* arg, int& first, int& last)
+{
+	if (sscanf(arg, "%d-%d", &first, &last) == 2)
+		return true;
+	first = last = atoi(arg);
+	return true;
+}
+
+static Meander* enabled_module(int preset, int mode, float tempo)
+{
+	Meander* module = new Meander();
+	module->theMeanderState.theHarmonyParms.enabled = true;
+	module->theMeanderState.theMelodyParms.enabled = true;
+	module->theMeanderState.theArpParms.enabled = true;
+	module->theMeanderState.theBassParms.enabled = true;
+	module->fBm_cv_smooth = true;
+	module->fBm_cv_channels = PORT_MAX_CHANNELS;
+	for (Output& output : module->outputs)
+		output.connected = true;
+	module->params[Meander::CONTROL_HARMONYPRESETS_PARAM].setValue(preset);
+	module->params[Meander::CONTROL_SCALE_PARAM].setValue(mode);
+	module->params[Meander::CONTROL_TEMPOBPM_PARAM].setValue(tempo);
+	return module;
+}
+
+int main(int argc, char** argv)
+{
+	ConfigureGlobals();
+	Meander probe;
+	int firstPreset = 1, lastPreset = probe.numHarmonyPresets();
+	int firstMode = 0, lastMode = MAX_MODES - 1;
+	int tempoCount = 5;
+	float seconds = 2.f;
+	int calls = 16;
+	float sampleRate = 48000.f;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* opt = argv[i];
+		const char* arg = argv[i + 1];
+		if (!strcmp(opt, "--presets"))
+			parse_range(arg, firstPreset, lastPreset);
+		else if (!strcmp(opt, "--modes"))
+			parse_range(arg, firstMode, lastMode);
+		else if (!strcmp(opt, "--tempos"))
+			tempoCount = std::max(1, atoi(arg));
+		else if (!strcmp(opt, "--seconds"))
+			seconds = atof(arg);
+		else if (!strcmp(opt, "--calls"))
+			calls = std::max(1, atoi(arg));
+		else if (!strcmp(opt, "--rate"))
+			sampleRate = atof(arg);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", opt);
+			return 1;
+		}
+	}
+	firstPreset = clamp(firstPreset, 1, probe.numHarmonyPresets());
+	lastPreset = clamp(lastPreset, firstPreset, probe.numHarmonyPresets());
+	firstMode = clamp(firstMode, 0, MAX_MODES - 1);
+	lastMode = clamp(lastMode, firstMode, MAX_MODES - 1);
+
+	std::vector<float> tempos;
+	for (int t = 0; t < tempoCount; ++t)
+		tempos.push_back((tempoCount == 1) ? probe.min_bpm :
+			probe.min_bpm + (probe.max_bpm - probe.min_bpm) * t / (tempoCount - 1));
+
+	Module::ProcessArgs args;
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	args.frame = 0;
+	long samples = (long)(seconds * sampleRate);
+	double overhead = clock_overhead();
+
+	CostHistogram total;
+	std::vector<CostHistogram> byPreset(lastPreset + 1), byMode(MAX_MODES), byTempo(tempos.size());
+	const char* functionNames[] = {"doHarmony()", "doMelody()", "doArp()", "doBass()", "setup_harmony()",
+		"circleChanged rebuild"};
+	CostHistogram functions[6];
+	double worst = 0.0;
+	int worstPreset = 0, worstMode = 0;
+	float worstTempo = 0.f;
+	long worstSample = 0;
+
+	printf("process() with everything enabled: presets %d-%d x modes %d-%d x %d tempos, %g s each at %g Hz\n",
+		firstPreset, lastPreset, firstMode, lastMode, (int)tempos.size(), seconds, sampleRate);
+	printf("clock overhead %.1f ns, taken off every timing\n\n", overhead);
+
+	for (int preset = firstPreset; preset <= lastPreset; ++preset)
+		for (int mode = firstMode; mode <= lastMode; ++mode)
+			for (size_t t = 0; t < tempos.size(); ++t)
+			{
+				Meander* module = enabled_module(preset, mode, tempos[t]);
+				CostHistogram run;
+				for (long s = 0; s < samples; ++s)
+				{
+					Clock::time_point start = Clock::now();
+					module->process(args);
+					double ns = elapsed_ns(start, Clock::now()) - overhead;
+					run.add(ns);
+					if (ns > worst)
+					{
+						worst = ns;
+						worstPreset = preset;
+						worstMode = mode;
+						worstTempo = tempos[t];
+						worstSample = s;
+					}
+				}
+				total.add(run);
+				byPreset[preset].add(run);
+				byMode[mode].add(run);
+				byTempo[t].add(run);
+
+				for (int c = 0; c < calls; ++c)
+				{
+					for (int f = 0; f < 6; ++f)
+					{
+						Clock::time_point start = Clock::now();
+						switch (f)
+						{
+						case 0: module->doHarmony(1 + c % 4, true); break;
+						case 1: module->doMelody(); break;
+						case 2: module->doArp(); break;
+						case 3: module->doBass(); break;
+						case 4: module->setup_harmony(); break;
+						case 5: module->rebuildCircle(); break;
+						}
+						functions[f].add(elapsed_ns(start, Clock::now()) - overhead);
+					}
+				}
+				delete module;
+			}
+
+	printf("                                  mean ns     p99 ns     max ns\n");
+	total.print("process()");
+	printf("worst sample: preset %d, %s, %g BPM, sample %ld\n\n", worstPreset, mode_names[worstMode], worstTempo,
+		worstSample);
+
+	printf("process() by tempo\n");
+	for (size_t t = 0; t < tempos.size(); ++t)
+		byTempo[t].print((std::to_string((int)std::round(tempos[t])) + " BPM").c_str());
+	printf("process() by mode\n");
+	for (int mode = firstMode; mode <= lastMode; ++mode)
+		byMode[mode].print(mode_names[mode]);
+	printf("process() by preset\n");
+	for (int preset = firstPreset; preset <= lastPreset; ++preset)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "%2d %.24s", preset, probe.harmonyPresetBank->presets[preset].harmony_type_desc);
+		byPreset[preset].print(name);
+	}
+	printf("\nper call, %d calls per configuration\n", calls);
+	for (int f = 0; f < 6; ++f)
+		functions[f].print(functionNames[f]);
+	return 0;
+}
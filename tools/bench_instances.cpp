@@ -0,0 +1,60 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Multi-instance benchmark.  Creates 1..N Meander modules and runs process() on all of them for a fixed amount
+// of audio time, then reports the cost per instance per sample.  Since each module owns its own MeanderEngine, the
+// per-instance figure should stay flat as the instance count grows.
+//
+// usage: bench_instances [max_instances=32] [seconds=10] [sample_rate=44100]
+
+#include "../src/Meander.cpp"
+
+#include <chrono>
+#include <vector>
+
+Plugin *pluginInstance;
+
+int main(int argc, char** argv)
+{
+	int max_instances = (argc > 1) ? atoi(argv[1]) : 32;
+	float seconds = (argc > 2) ? atof(argv[2]) : 10.0f;
+	float sampleRate = (argc > 3) ? atof(argv[3]) : 44100.0f;
+
+	rack::random::init();
+	ConfigureGlobals();
+
+	Module::ProcessArgs args;
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.0f / sampleRate;
+
+	long num_samples = (long)(seconds * sampleRate);
+
+	printf("instances  total ms  ns/instance/sample  %% of realtime/instance\n");
+	for (int n = 1; n <= max_instances; n *= 2)
+	{
+		std::vector<Meander*> instances;
+		for (int i = 0; i < n; ++i)
+			instances.push_back(new Meander());
+
+		auto start = std::chrono::steady_clock::now();
+		for (long s = 0; s < num_samples; ++s)
+		{
+			for (Meander* m : instances)
+				m->process(args);
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double total_ns = std::chrono::duration<double, std::nano>(end - start).count();
+		double per_sample_ns = total_ns / ((double)n * num_samples);
+		double realtime_pct = 100.0 * per_sample_ns * 1e-9 * sampleRate;
+		printf("%9d  %8.1f  %18.2f  %22.4f\n", n, total_ns * 1e-6, per_sample_ns, realtime_pct);
+
+		for (Meander* m : instances)
+			delete m;
+	}
+
+	return 0;
+}
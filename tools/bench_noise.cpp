@@ -0,0 +1,403 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Noise benchmark.  Times the fBm noise in src/Common-Noise.hpp in ns per point, in double and float, and checks
+// that the batch versions give exactly the same values as the scalar FastfBm1DNoise() of the same precision.  Also
+// times fBm1DWavetable and FastfBm1DNoiseRamp() and reports their error against FastfBm1DNoise(), and times the simplex
+// noise against the Perlin noise it can replace in 2D to 4D, and the table-free hash noise against pnoise1 in speed and
+// statistics.  Needs no Rack SDK, build with "make bench_noise".
+//
+// usage: bench_noise [points=4096] [repeats=200]
+
+#include "../src/Common-Noise.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static double sink = 0.0;  // keeps the timed loops from being optimized away
+
+template <class F>
+static double time_ns(int points, int repeats, F f)
+{
+	double best = 1e30;
+	for (int r = 0; r < repeats; ++r)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best = std::min(best, ns);
+	}
+	return best / points;
+}
+
+// Times FastfBm1DNoise() and every batch version of it in precision T, for each octave count.  Returns false if a
+// batch version does not give exactly the scalar values.
+template <typename T>
+static bool bench_fBm1D(const char* precision, int points, int repeats, std::vector<T>& expected)
+{
+	std::vector<T> x(points);
+	std::vector<T> out(points);
+	std::vector<int> octaves(points);
+	srand(1);
+	for (int i = 0; i < points; ++i)
+		x[i] = (T)(4096.0 * rand() / RAND_MAX);
+
+	struct BatchVersion
+	{
+		const char* name;
+		fBm1DBatchFunction<T> batch;
+	};
+	std::vector<BatchVersion> versions = {{"batch scalar", FastfBm1DNoiseBatchScalar}};
+#ifdef NOISE_X86_SIMD
+	versions.push_back({"batch SSE2", FastfBm1DNoiseBatchSSE2});
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		versions.push_back({"batch AVX2", FastfBm1DNoiseBatchAVX2});
+#endif
+
+	printf("%-6s ns/point  scalar", precision);
+	for (const BatchVersion& version : versions)
+		printf("  %13s", version.name);
+	printf("\n");
+
+	bool identical = true;
+	for (int n = 6; n >= 0; --n)  // 0 is a random octave count 1-6 for every point, and what is left in expected
+	{
+		for (int i = 0; i < points; ++i)
+			octaves[i] = (n > 0) ? n : 1 + (i * 7919) % 6;
+		double scalar = time_ns(points, repeats, [&]() {
+			for (int i = 0; i < points; ++i)
+				expected[i] = FastfBm1DNoise(x[i], octaves[i]);
+			sink += expected[points - 1];
+		});
+		if (n > 0)
+			printf("octaves %d     %8.2f", n, scalar);
+		else
+			printf("octaves 1-6   %8.2f", scalar);
+		for (const BatchVersion& version : versions)
+		{
+			double ns = time_ns(points, repeats, [&]() {
+				version.batch(x.data(), octaves.data(), out.data(), points, theDefaultNoiseContext);
+				sink += out[points - 1];
+			});
+			identical = identical && (memcmp(out.data(), expected.data(), points * sizeof(T)) == 0);
+			printf("  %8.2f %4.1fx", ns, scalar / ns);
+		}
+		printf("\n");
+	}
+	printf("\n");
+	return identical;
+}
+
+// Times fBm1DWavetable::build() and lookup(), and the error of lookup() against FastfBm1DNoise() for each octave
+// count, separately over the exact part of the table and over the blend into its wrap.
+static void bench_wavetable(int points, int repeats)
+{
+	const double origin = 1234.5678;
+	const double blendStart = fBm1DWavetable::UNITS - fBm1DWavetable::BLEND_UNITS;
+	fBm1DWavetable wavetable;
+	double buildMs = time_ns(1, std::max(repeats / 20, 1), [&]() { wavetable.build(origin); }) / 1e6;
+	printf("wavetable %d units x %d samples, %d KB, build %.2f ms\n", fBm1DWavetable::UNITS,
+		fBm1DWavetable::SAMPLES_PER_UNIT, (int)(wavetable.tables.size() * sizeof(float) / 1024), buildMs);
+
+	std::vector<double> u(points);
+	srand(2);
+	for (int i = 0; i < points; ++i)
+		u[i] = fBm1DWavetable::UNITS * (double)rand() / RAND_MAX;
+
+	printf("octaves  ns/point  scalar  speedup   max error  rms error   max error in blend\n");
+	for (int n = 1; n <= 6; ++n)
+	{
+		double lookup = time_ns(points, repeats, [&]() {
+			float sum = 0.f;
+			for (int i = 0; i < points; ++i)
+				sum += wavetable.lookup(u[i], n);
+			sink += sum;
+		});
+		double scalar = time_ns(points, repeats, [&]() {
+			double sum = 0.0;
+			for (int i = 0; i < points; ++i)
+				sum += FastfBm1DNoise(origin + u[i], n);
+			sink += sum;
+		});
+		double maxError = 0.0, sumSquares = 0.0, maxBlend = 0.0;
+		int exact = 0;
+		for (int i = 0; i < points; ++i)
+		{
+			double error = std::fabs(wavetable.lookup(u[i], n) - FastfBm1DNoise(origin + u[i], n));
+			if (u[i] < blendStart)
+			{
+				maxError = std::max(maxError, error);
+				sumSquares += error * error;
+				++exact;
+			}
+			else
+				maxBlend = std::max(maxBlend, error);
+		}
+		printf("%7d  %8.2f  %6.2f  %6.1fx  %10.5f  %9.5f  %19.5f\n", n, lookup, scalar, scalar / lookup, maxError,
+			std::sqrt(sumSquares / std::max(exact, 1)), maxBlend);
+	}
+	printf("\n");
+}
+
+// Times FastfBm1DNoiseRamp() in 64 point blocks at a typical audio-rate step, and its error against
+// FastfBm1DNoise() at the same points.
+static void bench_ramp(int points, int repeats)
+{
+	const int block = 64;
+	const double dx = 2.3e-5;  // fBm period 1 at 120 BPM and 44.1 kHz, the fastest the knobs allow short of 300 BPM
+	int blocks = std::max(points / block, 1);
+	std::vector<float> out(blocks * block);
+
+	printf("ramp, blocks of %d  ns/point  max error\n", block);
+	for (int n = 1; n <= 6; ++n)
+	{
+		double ns = time_ns(blocks * block, repeats, [&]() {
+			for (int b = 0; b < blocks; ++b)
+				FastfBm1DNoiseRamp(1234.5678 + b * block * dx, dx, n, &out[b * block], block);
+			sink += out[0];
+		});
+		double maxError = 0.0;
+		for (int i = 0; i < blocks * block; ++i)
+			maxError = std::max(maxError, std::fabs(out[i] - FastfBm1DNoise(1234.5678 + i * dx, n)));
+		printf("octaves %d          %8.2f  %9.2g\n", n, ns, maxError);
+	}
+	printf("\n");
+}
+
+// Times one N dimensional noise function over the points in xs, N values apiece, and prints ns/sample with the
+// range and rms of the values.
+template <int N, class F>
+static void bench_noiseND(const char* name, const std::vector<double>& xs, int repeats, F f)
+{
+	int points = (int)xs.size() / N;
+	double ns = time_ns(points, repeats, [&]() {
+		double sum = 0.0;
+		for (int i = 0; i < points; ++i)
+			sum += f(&xs[i * N]);
+		sink += sum;
+	});
+	double lo = 1e30, hi = -1e30, sumSquares = 0.0;
+	for (int i = 0; i < points; ++i)
+	{
+		double v = f(&xs[i * N]);
+		lo = std::min(lo, v);
+		hi = std::max(hi, v);
+		sumSquares += v * v;
+	}
+	printf("  %-26s %8.2f  %7.3f %7.3f  %6.3f\n", name, ns, lo, hi, std::sqrt(sumSquares / points));
+}
+
+// Simplex against Perlin in 2D, 3D and 4D, the single noise and 4 octave fBm, in double.
+static void bench_simplex(int points, int repeats)
+{
+	std::vector<double> xs(points * 4);
+	srand(3);
+	for (double& x : xs)
+		x = 64.0 * rand() / RAND_MAX;
+	bool reset = true;
+
+	printf("simplex vs Perlin          ns/sample      min     max     rms\n");
+	printf("2D\n");
+	bench_noiseND<2>("pnoise2", xs, repeats, [](const double* v) { return pnoise2(v); });
+	bench_noiseND<2>("snoise2", xs, repeats, [](const double* v) { return snoise2(v); });
+	bench_noiseND<2>("FastfBm2DNoise Perlin", xs, repeats, [&](const double* v) { reset = true; return FastfBm2DNoise(v[0], v[1], 4, &reset); });
+	bench_noiseND<2>("FastfBm2DNoise simplex", xs, repeats, [&](const double* v) {
+		reset = true;
+		return FastfBm2DNoise(v[0], v[1], 4, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+	});
+	printf("3D\n");
+	bench_noiseND<3>("pnoise3", xs, repeats, [](const double* v) { return pnoise3(v); });
+	bench_noiseND<3>("npnoise3", xs, repeats, [](const double* v) { return npnoise3(v); });
+	bench_noiseND<3>("snoise3", xs, repeats, [](const double* v) { return snoise3(v); });
+	bench_noiseND<3>("FastfBm3DNoise Perlin", xs, repeats, [&](const double* v) { reset = true; return FastfBm3DNoise(v[0], v[1], v[2], 4, &reset); });
+	bench_noiseND<3>("FastfBm3DNoise simplex", xs, repeats, [&](const double* v) {
+		reset = true;
+		return FastfBm3DNoise(v[0], v[1], v[2], 4, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+	});
+	printf("4D\n");
+	bench_noiseND<4>("npnoise4", xs, repeats, [](const double* v) { return npnoise4(v); });
+	bench_noiseND<4>("snoise4", xs, repeats, [](const double* v) { return snoise4(v); });
+	bench_noiseND<4>("FastfBm4DNoise Perlin", xs, repeats, [&](const double* v) {
+		reset = true;
+		return FastfBm4DNoise(v[0], v[1], v[2], v[3], 4, &reset);
+	});
+	bench_noiseND<4>("FastfBm4DNoise simplex", xs, repeats, [&](const double* v) {
+		reset = true;
+		return FastfBm4DNoise(v[0], v[1], v[2], v[3], 4, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+	});
+	printf("\n");
+}
+
+// The distribution and correlation of a noise sampled every dx along x.
+struct NoiseStats
+{
+	double mean = 0.0, sd = 0.0, lo = 1e30, hi = -1e30;
+	double correlation[3] = {};  // autocorrelation at lags 0.25, 0.5 and 1
+	std::vector<double> sorted;
+
+	NoiseStats(const std::vector<double>& v, double dx)
+	{
+		int n = (int)v.size();
+		for (double x : v)
+		{
+			mean += x;
+			lo = std::min(lo, x);
+			hi = std::max(hi, x);
+		}
+		mean /= n;
+		for (double x : v)
+			sd += (x - mean) * (x - mean);
+		double variance = sd / n;
+		sd = std::sqrt(variance);
+		const double lags[3] = {0.25, 0.5, 1.0};
+		for (int l = 0; l < 3; ++l)
+		{
+			int lag = (int)std::lround(lags[l] / dx);
+			double sum = 0.0;
+			for (int i = 0; i + lag < n; ++i)
+				sum += (v[i] - mean) * (v[i + lag] - mean);
+			correlation[l] = sum / (n - lag) / variance;
+		}
+		sorted = v;
+		std::sort(sorted.begin(), sorted.end());
+	}
+
+	// Kolmogorov-Smirnov distance, the largest difference between the two distribution functions
+	double distance(const NoiseStats& other) const
+	{
+		double d = 0.0;
+		size_t i = 0, j = 0;
+		while (i < sorted.size() && j < other.sorted.size())
+		{
+			if (sorted[i] <= other.sorted[j])
+				++i;
+			else
+				++j;
+			d = std::max(d, std::fabs((double)i / sorted.size() - (double)j / other.sorted.size()));
+		}
+		return d;
+	}
+
+	void print(const char* name) const
+	{
+		printf("  %-22s %7.4f %6.4f %7.3f %6.3f   %6.3f %6.3f %6.3f", name, mean, sd, lo, hi, correlation[0], correlation[1],
+			correlation[2]);
+	}
+};
+
+// hnoise1 against pnoise1, and their fBm, in speed and in statistics over every lattice cell of 8 seeds each.
+static void bench_hash(int points, int repeats)
+{
+	std::vector<double> x(points);
+	std::vector<int> octaves(points, 6);
+	std::vector<double> out(points);
+	srand(4);
+	for (int i = 0; i < points; ++i)
+		x[i] = 4096.0 * rand() / RAND_MAX;
+
+	printf("hash noise vs pnoise1       ns/sample\n");
+	double ns = time_ns(points, repeats, [&]() {
+		double sum = 0.0;
+		for (int i = 0; i < points; ++i)
+			sum += pnoise1(&x[i]);
+		sink += sum;
+	});
+	double hashNs = time_ns(points, repeats, [&]() {
+		double sum = 0.0;
+		for (int i = 0; i < points; ++i)
+			sum += hnoise1(&x[i], 1234u);
+		sink += sum;
+	});
+	printf("  pnoise1 / hnoise1           %8.2f %8.2f\n", ns, hashNs);
+	ns = time_ns(points, repeats, [&]() {
+		double sum = 0.0;
+		for (int i = 0; i < points; ++i)
+			sum += FastfBm1DNoise(x[i], 6);
+		sink += sum;
+	});
+	hashNs = time_ns(points, repeats, [&]() {
+		double sum = 0.0;
+		for (int i = 0; i < points; ++i)
+			sum += FastfBm1DHashNoise(x[i], 6, 1234u);
+		sink += sum;
+	});
+	printf("  6 octave fBm, scalar        %8.2f %8.2f\n", ns, hashNs);
+	ns = time_ns(points, repeats, [&]() {
+		FastfBm1DNoiseBatch(x.data(), octaves.data(), out.data(), points);
+		sink += out[0];
+	});
+	hashNs = time_ns(points, repeats, [&]() {
+		FastfBm1DHashNoiseBlock(x.data(), 6, out.data(), points, 1234u);
+		sink += out[0];
+	});
+	printf("  6 octave fBm, batch/block   %8.2f %8.2f\n", ns, hashNs);
+	bool identical = true;
+	for (int i = 0; i < points; ++i)
+		identical = identical && (out[i] == FastfBm1DHashNoise(x[i], 6, 1234u));
+	printf("  block results %s the scalar results\n", identical ? "are identical to" : "DIFFER from");
+
+	// pnoise1 repeats every 256, so 8 permutations of 256 cells each against 8 hash seeds over the same span
+	const double dx = 1.0 / 64.0;
+	const int cells = 256, seeds = 8;
+	for (int n : {1, 6})
+	{
+		std::vector<double> perlin, hash;
+		NoiseContext context;
+		for (int seed = 0; seed < seeds; ++seed)
+		{
+			context.reseed(seed);
+			for (int i = 0; i < cells / dx; ++i)
+			{
+				perlin.push_back(FastfBm1DNoise(i * dx, n, context));
+				hash.push_back(FastfBm1DHashNoise(i * dx, n, (uint32_t)seed * 7919u + 1u));
+			}
+		}
+		NoiseStats perlinStats(perlin, dx), hashStats(hash, dx);
+		printf("%d octave%s                   mean     sd     min    max   corr .25     .5      1     KS\n", n,
+			(n == 1) ? " " : "s");
+		perlinStats.print("FastfBm1DNoise");
+		printf("\n");
+		hashStats.print("FastfBm1DHashNoise");
+		printf(" %6.4f\n", perlinStats.distance(hashStats));
+	}
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	int points = (argc > 1) ? atoi(argv[1]) : 4096;
+	int repeats = (argc > 2) ? atoi(argv[2]) : 200;
+	points = std::max(points, 1);
+	repeats = std::max(repeats, 1);
+
+	initPerlin();
+
+	double x = 0.0;
+	int octaves = 1;
+	FastfBm1DNoiseBatch(&x, &octaves, &x, 0);
+	printf("FastfBm1DNoiseBatch() uses %s\n\n", fBm1DBatchISA);
+
+	std::vector<double> doubles(points);
+	std::vector<float> floats(points);
+	bool identical = bench_fBm1D("double", points, repeats, doubles);
+	identical = bench_fBm1D("float", points, repeats, floats) && identical;
+	bench_wavetable(points, repeats);
+	bench_ramp(points, repeats);
+	bench_simplex(points, repeats);
+	bench_hash(points, repeats);
+
+	double maxError = 0.0;
+	for (int i = 0; i < points; ++i)
+		maxError = std::max(maxError, std::fabs(floats[i] - doubles[i]));
+	printf("float differs from double by at most %.2g\n", maxError);
+	printf("batch results %s the scalar results\n", identical ? "are identical to" : "DIFFER from");
+	return (identical && (sink != 0.5)) ? 0 : 1;
+}
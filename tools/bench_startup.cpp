@@ -0,0 +1,89 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Startup benchmark.  Reports the one time plugin load cost (ConfigureGlobals), the cost of constructing a Meander
+// module, and the cost of loading one from a patch: construct, restore params and dataFromJson(), then run process()
+// until the first low frequency clock tick has applied the patch (key, mode, preset) and rebuilt the circle.
+//
+// usage: bench_startup [iterations=1000] [sample_rate=44100]
+
+#include "../src/Meander.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+Plugin *pluginInstance;
+
+static double elapsed_us(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* label, std::vector<double>& us)
+{
+	std::sort(us.begin(), us.end());
+	double sum = 0.0;
+	for (double u : us)
+		sum += u;
+	printf("%-14s  %10.2f  %10.2f  %10.2f  %10.2f\n", label, sum / us.size(), us[us.size() / 2], us[(us.size() * 99) / 100], us.back());
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 1000;
+	float sampleRate = (argc > 2) ? atof(argv[2]) : 44100.0f;
+	iterations = std::max(iterations, 1);
+
+	rack::random::init();
+
+	auto start = std::chrono::steady_clock::now();
+	ConfigureGlobals();
+	printf("plugin load (ConfigureGlobals): %.2f us\n\n", elapsed_us(start));
+
+	Module::ProcessArgs args;
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.0f / sampleRate;
+
+	// a patch to load: not the default key, mode or preset, so loading it has to rebuild everything
+	Meander* saved = new Meander();
+	saved->params[Meander::CONTROL_ROOT_KEY_PARAM].setValue(3);
+	saved->params[Meander::CONTROL_SCALE_PARAM].setValue(4);
+	saved->params[Meander::CONTROL_HARMONYPRESETS_PARAM].setValue(3);
+	saved->theMeanderState.theHarmonyParms.enable_all_7ths = true;
+	std::vector<float> savedParams;
+	for (Param& p : saved->params)
+		savedParams.push_back(p.getValue());
+	json_t* savedJ = saved->dataToJson();
+	delete saved;
+
+	std::vector<double> construct_us, load_us;
+	for (int i = 0; i < iterations; ++i)
+	{
+		start = std::chrono::steady_clock::now();
+		Meander* m = new Meander();
+		construct_us.push_back(elapsed_us(start));
+		delete m;
+
+		start = std::chrono::steady_clock::now();
+		m = new Meander();
+		for (size_t p = 0; p < savedParams.size(); ++p)
+			m->params[p].setValue(savedParams[p]);
+		m->dataFromJson(savedJ);
+		for (uint32_t s = 0; s <= m->lowFreqClock.getDivision(); ++s)
+			m->process(args);
+		load_us.push_back(elapsed_us(start));
+		delete m;
+	}
+	json_decref(savedJ);
+
+	printf("%d iterations, microseconds\n", iterations);
+	printf("                      mean      median         p99         max\n");
+	report("construct", construct_us);
+	report("patch load", load_us);
+
+	return 0;
+}
@@ -0,0 +1,664 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Offline Markov trainer.  Reads Standard MIDI Files, finds the chord in each bar using Meander's chord types and
+// scale degree model, and writes the degree to degree transitions as tables Meander loads directly:
+//   <out>.mkc   order 1-3 compiled chain, see loadMarkovChain()
+//   <out>.json  7x7 first order matrix, see loadMarkovMatrix()
+//   <out>.txt   a preset bank with one preset for each of the above
+// and prints the first order matrix as a C array in the same shape as MarkovProgressionTransitionMatrixBach1.
+// Directories are walked as they are read and each worker thread only holds the file it is parsing, so memory stays
+// bounded however large the corpus is.  Needs no Rack SDK, build with "make markov_train".
+//
+// usage: markov_train [--order 1-3] [--sevenths] [--estimate-key] [--threads n] [--out path] [--name name] dir|file...
+//
+// Without --sevenths the chain's symbols are the 7 degrees, with it they are the 7 triads followed by the 7 7th chords.
+// The key is taken from the file's key signature, or estimated from the notes if there is none or with --estimate-key.
+
+#define MEANDER_HEADLESS
+#include "../src/MeanderEngine.hpp"
+
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const size_t MAX_MIDI_FILE_SIZE=16*1024*1024;  // bigger files are skipped
+static const int MAX_BARS_PER_FILE=16384;
+static const size_t MAX_NOTES_PER_FILE=1<<20;
+
+struct TrainOptions
+{
+	int order=2;
+	bool sevenths=false;
+	bool estimateKey=false;
+	int threads=0;
+	std::string out="trained";
+	std::string name;
+};
+
+// Hands out MIDI file paths to the workers, reading one directory at a time as the list runs dry
+struct MidiFileWalker
+{
+	std::mutex lock;
+	std::vector<std::string> directories;
+	std::vector<std::string> files;
+
+	static bool isMidiFile(const std::string &path)
+	{
+		size_t dot=path.rfind('.');
+		if (dot==std::string::npos)
+			return false;
+		std::string extension=path.substr(dot+1);
+		for (char &c : extension)
+			c=(char)tolower((unsigned char)c);
+		return (extension=="mid")||(extension=="midi")||(extension=="smf");
+	}
+
+	void add(const std::string &path)
+	{
+		struct stat info;
+		if (stat(path.c_str(), &info)!=0)
+			fprintf(stderr, "markov_train: cannot read %s\n", path.c_str());
+		else
+		if (S_ISDIR(info.st_mode))
+			directories.push_back(path);
+		else
+			files.push_back(path);  // named explicitly, so taken whatever its extension
+	}
+
+	bool next(std::string &path)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		while ((files.empty())&&(!directories.empty()))
+		{
+			std::string directory=directories.back();
+			directories.pop_back();
+			DIR* dir=opendir(directory.c_str());
+			if (!dir)
+				continue;
+			while (struct dirent* entry=readdir(dir))
+			{
+				if (entry->d_name[0]=='.')
+					continue;
+				std::string child=directory+"/"+entry->d_name;
+				struct stat info;
+				if (stat(child.c_str(), &info)!=0)
+					continue;
+				if (S_ISDIR(info.st_mode))
+					directories.push_back(child);
+				else
+				if (isMidiFile(child))
+					files.push_back(child);
+			}
+			closedir(dir);
+		}
+		if (files.empty())
+			return false;
+		path=files.back();
+		files.pop_back();
+		return true;
+	}
+};
+
+struct TrainStats
+{
+	long files=0;
+	long skipped=0;
+	long bars=0;
+	long chords=0;
+	long transitions=0;
+
+	void add(const TrainStats &other)
+	{
+		files+=other.files;
+		skipped+=other.skipped;
+		bars+=other.bars;
+		chords+=other.chords;
+		transitions+=other.transitions;
+	}
+};
+
+// Everything one worker needs, reused from file to file
+struct MidiAnalyzer
+{
+	struct NoteSpan
+	{
+		int64_t start;
+		int64_t end;
+		int pitch_class;
+	};
+	struct Meter
+	{
+		int64_t tick;
+		int64_t ticks_per_bar;
+		int64_t bar;  // bar number at tick
+	};
+
+	const TrainOptions &options;
+	int num_symbols;
+	MarkovChainCounts counts;
+	TrainStats stats;
+
+	std::vector<uint8_t> data;
+	std::vector<NoteSpan> notes;
+	std::vector<Meter> meters;
+	std::vector<float> bar_weights;  // [bar*12+pitch class] sounding ticks
+	std::vector<int> sequence;
+	int64_t active[16][128];
+	int key_signature;  // -1 none, else tonic pitch class + 12 if minor
+	int division;
+
+	MidiAnalyzer(const TrainOptions &trainOptions) : options(trainOptions)
+	{
+		num_symbols=(options.sevenths) ? 14 : 7;
+		counts.init(options.order, num_symbols);
+	}
+
+	static bool readVarLen(const uint8_t* &p, const uint8_t* end, uint32_t &value)
+	{
+		value=0;
+		for (int i=0; i<4; ++i)
+		{
+			if (p>=end)
+				return false;
+			uint8_t byte=*p++;
+			value=(value<<7)|(byte&0x7f);
+			if (!(byte&0x80))
+				return true;
+		}
+		return false;
+	}
+
+	static uint32_t readBigEndian(const uint8_t* p, int bytes)
+	{
+		uint32_t value=0;
+		for (int i=0; i<bytes; ++i)
+			value=(value<<8)|p[i];
+		return value;
+	}
+
+	void noteOff(int channel, int key, int64_t tick)
+	{
+		if (active[channel][key]<0)
+			return;
+		if ((tick>active[channel][key])&&(notes.size()<MAX_NOTES_PER_FILE))
+			notes.push_back({active[channel][key], tick, key%12});
+		active[channel][key]=-1;
+	}
+
+	bool parseTrack(const uint8_t* p, const uint8_t* end)
+	{
+		for (int channel=0; channel<16; ++channel)
+			for (int key=0; key<128; ++key)
+				active[channel][key]=-1;
+		int64_t tick=0;
+		uint8_t running=0;
+		bool ok=true;
+		while (p<end)
+		{
+			uint32_t delta;
+			if (!readVarLen(p, end, delta))
+			{
+				ok=false;
+				break;
+			}
+			tick+=delta;
+			if (p>=end)
+			{
+				ok=false;
+				break;
+			}
+			uint8_t status=*p;
+			if (status>=0x80)
+				++p;
+			else
+			if (running)
+				status=running;
+			else
+			{
+				ok=false;
+				break;
+			}
+
+			if ((status==0xff)||(status==0xf0)||(status==0xf7))
+			{
+				running=0;
+				uint8_t type=0;
+				if (status==0xff)
+				{
+					if (p>=end)
+					{
+						ok=false;
+						break;
+					}
+					type=*p++;
+				}
+				uint32_t length;
+				if ((!readVarLen(p, end, length))||(length>(uint32_t)(end-p)))
+				{
+					ok=false;
+					break;
+				}
+				if ((status==0xff)&&(type==0x58)&&(length>=2)&&(p[0]>0)&&(p[1]<=6))  // time signature
+				{
+					int64_t ticksPerBar=(int64_t)division*4*p[0]/(1<<p[1]);
+					if (ticksPerBar>0)
+						meters.push_back({tick, ticksPerBar, 0});
+				}
+				else
+				if ((status==0xff)&&(type==0x59)&&(length>=2)&&(key_signature<0))  // key signature
+				{
+					int sharps=(int8_t)p[0];
+					if ((sharps>=-7)&&(sharps<=7))
+					{
+						int tonic=((sharps*7)%12+12)%12;
+						key_signature=(p[1]) ? (tonic+9)%12+12 : tonic;
+					}
+				}
+				p+=length;
+				if ((status==0xff)&&(type==0x2f))
+					break;
+				continue;
+			}
+			if (status>=0xf0)  // system common or real time messages do not belong in a file
+			{
+				ok=false;
+				break;
+			}
+
+			running=status;
+			int dataBytes=(((status&0xf0)==0xc0)||((status&0xf0)==0xd0)) ? 1 : 2;
+			if (end-p<dataBytes)
+			{
+				ok=false;
+				break;
+			}
+			int channel=status&0x0f;
+			int key=p[0]&0x7f;
+			int velocity=(dataBytes>1) ? p[1]&0x7f : 0;
+			p+=dataBytes;
+			if (channel==9)  // GM drums
+				continue;
+			if (((status&0xf0)==0x90)&&(velocity>0))
+			{
+				noteOff(channel, key, tick);  // retriggered
+				active[channel][key]=tick;
+			}
+			else
+			if (((status&0xf0)==0x80)||((status&0xf0)==0x90))
+				noteOff(channel, key, tick);
+		}
+		for (int channel=0; channel<16; ++channel)
+			for (int key=0; key<128; ++key)
+				noteOff(channel, key, tick);
+		return ok;
+	}
+
+	bool parseMidi(size_t size)
+	{
+		notes.clear();
+		meters.clear();
+		key_signature=-1;
+		const uint8_t* p=data.data();
+		const uint8_t* end=p+size;
+		if ((size<14)||(memcmp(p, "MThd", 4)!=0))
+			return false;
+		uint32_t headerLength=readBigEndian(p+4, 4);
+		if ((headerLength<6)||(headerLength>size-8))
+			return false;
+		int format=(int)readBigEndian(p+8, 2);
+		division=(int)readBigEndian(p+12, 2);
+		if ((format>2)||(division==0)||(division&0x8000))  // SMPTE time has no bars
+			return false;
+		p+=8+headerLength;
+
+		int tracks=0;
+		while (end-p>=8)
+		{
+			uint32_t length=readBigEndian(p+4, 4);
+			const uint8_t* chunk=p+8;
+			if (length>(uint32_t)(end-chunk))
+				length=(uint32_t)(end-chunk);  // truncated files are common, use what is there
+			if (memcmp(p, "MTrk", 4)==0)
+			{
+				if ((!parseTrack(chunk, chunk+length))&&(notes.empty()))
+					return false;
+				++tracks;
+			}
+			p=chunk+length;
+		}
+		return (tracks>0)&&(!notes.empty());
+	}
+
+	// Lay the meters end to end, a change part way through a bar starts a new bar
+	void numberBars()
+	{
+		std::stable_sort(meters.begin(), meters.end(), [](const Meter &a, const Meter &b) { return a.tick<b.tick; });
+		if ((meters.empty())||(meters[0].tick>0))
+		{
+			Meter common={0, (int64_t)division*4, 0};  // 4/4 until told otherwise
+			meters.insert(meters.begin(), common);
+		}
+		for (size_t i=1; i<meters.size(); ++i)
+		{
+			const Meter &previous=meters[i-1];
+			meters[i].bar=previous.bar+(meters[i].tick-previous.tick+previous.ticks_per_bar-1)/previous.ticks_per_bar;
+		}
+	}
+
+	void addNoteToBars(const NoteSpan &note)
+	{
+		size_t m=0;
+		while ((m+1<meters.size())&&(meters[m+1].tick<=note.start))
+			++m;
+		int64_t tick=note.start;
+		while (tick<note.end)
+		{
+			while ((m+1<meters.size())&&(meters[m+1].tick<=tick))
+				++m;
+			const Meter &meter=meters[m];
+			int64_t bar=meter.bar+(tick-meter.tick)/meter.ticks_per_bar;
+			if (bar>=MAX_BARS_PER_FILE)
+				return;
+			int64_t barEnd=meter.tick+(bar-meter.bar+1)*meter.ticks_per_bar;
+			if ((m+1<meters.size())&&(meters[m+1].tick<barEnd))
+				barEnd=meters[m+1].tick;
+			int64_t end=std::min(barEnd, note.end);
+			if ((size_t)bar*12+12>bar_weights.size())
+				bar_weights.resize((size_t)(bar+1)*12, 0.f);
+			bar_weights[(size_t)bar*12+note.pitch_class]+=(float)(end-tick)/meter.ticks_per_bar;
+			tick=end;
+		}
+	}
+
+	// Krumhansl-Kessler key profiles, returns tonic pitch class + 12 if minor
+	static int estimateKey(const float* totals)
+	{
+		static const float majorProfile[12]={6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f};
+		static const float minorProfile[12]={6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f};
+		int best=0;
+		float bestScore=-1e30f;
+		for (int key=0; key<24; ++key)
+		{
+			const float* profile=(key<12) ? majorProfile : minorProfile;
+			float score=0.f;
+			for (int pc=0; pc<12; ++pc)
+				score+=totals[(pc+key)%12]*profile[pc];
+			if (score>bestScore)
+			{
+				bestScore=score;
+				best=key;
+			}
+		}
+		return best;
+	}
+
+	// Best matching Meander chord type on any root, -1 if the bar is too ambiguous to call.  Extra chord tones
+	// cost a little so a triad wins unless its 7th is really there.
+	static int detectChord(const float* weights, int &chordType)
+	{
+		static const int candidateTypes[]={0, 1, 6, 2, 3, 4, 5};  // the circle's chord types
+		float total=0.f;
+		for (int pc=0; pc<12; ++pc)
+			total+=weights[pc];
+		if (total<=0.f)
+			return -1;
+		int bestRoot=-1;
+		float bestScore=-1e30f;
+		for (int root=0; root<12; ++root)
+			for (int type : candidateTypes)
+			{
+				float inside=0.f;
+				for (int k=0; k<chord_type_num_notes[type]; ++k)
+					inside+=weights[(root+chord_type_intervals[type][k])%12];
+				float score=inside-0.5f*(total-inside)-0.15f*total*(chord_type_num_notes[type]-3)+0.1f*weights[root];
+				if ((inside>=0.5f*total)&&(score>bestScore))
+				{
+					bestScore=score;
+					bestRoot=root;
+					chordType=type;
+				}
+			}
+		return bestRoot;
+	}
+
+	void flushSequence()
+	{
+		if (sequence.size()>=2)
+		{
+			counts.addSequence(sequence.data(), (int)sequence.size(), 1.);
+			stats.transitions+=(long)sequence.size()-1;
+		}
+		sequence.clear();
+	}
+
+	void analyze(const std::string &path)
+	{
+		FILE* file=fopen(path.c_str(), "rb");
+		if (!file)
+		{
+			++stats.skipped;
+			return;
+		}
+		fseek(file, 0, SEEK_END);
+		long size=ftell(file);
+		fseek(file, 0, SEEK_SET);
+		bool ok=(size>0)&&((size_t)size<=MAX_MIDI_FILE_SIZE);
+		if (ok)
+		{
+			data.resize((size_t)size);
+			ok=(fread(data.data(), 1, (size_t)size, file)==(size_t)size);
+		}
+		fclose(file);
+		if ((!ok)||(!parseMidi((size_t)size)))
+		{
+			++stats.skipped;
+			return;
+		}
+		++stats.files;
+
+		numberBars();
+		bar_weights.clear();
+		for (const NoteSpan &note : notes)
+			addNoteToBars(note);
+		int bars=(int)(bar_weights.size()/12);
+		stats.bars+=bars;
+
+		float totals[12]={};
+		for (int bar=0; bar<bars; ++bar)
+			for (int pc=0; pc<12; ++pc)
+				totals[pc]+=bar_weights[bar*12+pc];
+		int key=((key_signature<0)||(options.estimateKey)) ? estimateKey(totals) : key_signature;
+		int tonic=key%12;
+		int mode=(key<12) ? 1 : 4;  // Ionian or Aeolian, Meander's mode numbering
+		int degreeOf[12];  // scale degree 0-6 of each pitch class relative to the tonic, -1 if not in the mode
+		for (int pc=0; pc<12; ++pc)
+			degreeOf[pc]=-1;
+		for (int degree=0, semitones=0; degree<mode_step_intervals[mode][0]; ++degree)
+		{
+			degreeOf[semitones]=degree;
+			semitones+=mode_step_intervals[mode][degree+1];
+		}
+
+		sequence.clear();
+		for (int bar=0; bar<bars; ++bar)
+		{
+			int chordType=0;
+			int root=detectChord(&bar_weights[bar*12], chordType);
+			int degree=(root<0) ? -1 : degreeOf[(root-tonic+12)%12];
+			if (degree<0)  // a rest, an unclear bar or a chromatic chord ends the phrase
+			{
+				flushSequence();
+				continue;
+			}
+			++stats.chords;
+			bool seventh=(chordType>=2)&&(chordType<=5);
+			int symbol=((options.sevenths)&&(seventh)) ? degree+7 : degree;
+			if ((sequence.empty())||(sequence.back()!=symbol))  // a held chord is one step
+				sequence.push_back(symbol);
+		}
+		flushSequence();
+	}
+};
+
+static void addCounts(MarkovChainCounts &total, const MarkovChainCounts &other)
+{
+	for (int k=0; k<=total.order; ++k)
+		for (size_t i=0; i<total.counts[k].size(); ++i)
+			total.counts[k][i]+=other.counts[k][i];
+}
+
+static std::string baseName(const std::string &path)
+{
+	size_t slash=path.find_last_of("/\\");
+	return (slash==std::string::npos) ? path : path.substr(slash+1);
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: markov_train [--order 1-3] [--sevenths] [--estimate-key] [--threads n] [--out path] [--name name] dir|file...\n");
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	TrainOptions options;
+	MidiFileWalker walker;
+	for (int i=1; i<argc; ++i)
+	{
+		std::string arg=argv[i];
+		bool hasValue=(i+1<argc);
+		if ((arg=="--order")&&(hasValue))
+			options.order=atoi(argv[++i]);
+		else
+		if (arg=="--sevenths")
+			options.sevenths=true;
+		else
+		if (arg=="--estimate-key")
+			options.estimateKey=true;
+		else
+		if ((arg=="--threads")&&(hasValue))
+			options.threads=atoi(argv[++i]);
+		else
+		if ((arg=="--out")&&(hasValue))
+			options.out=argv[++i];
+		else
+		if ((arg=="--name")&&(hasValue))
+			options.name=argv[++i];
+		else
+		if ((arg.size()>1)&&(arg[0]=='-'))
+			usage();
+		else
+			walker.add(arg);
+	}
+	if ((options.order<1)||(options.order>MAX_MARKOV_ORDER)||((walker.directories.empty())&&(walker.files.empty())))
+		usage();
+	if (options.threads<=0)
+		options.threads=std::max(1, (int)std::thread::hardware_concurrency());
+	if (options.name.empty())
+		options.name=baseName(options.out);
+
+	std::vector<MidiAnalyzer*> analyzers;
+	std::vector<std::thread> workers;
+	for (int t=0; t<options.threads; ++t)
+	{
+		MidiAnalyzer* analyzer=new MidiAnalyzer(options);
+		analyzers.push_back(analyzer);
+		workers.push_back(std::thread([analyzer, &walker]() {
+			std::string path;
+			while (walker.next(path))
+				analyzer->analyze(path);
+		}));
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+
+	MarkovChainCounts counts;
+	TrainStats stats;
+	counts.init(options.order, analyzers[0]->num_symbols);
+	for (MidiAnalyzer* analyzer : analyzers)
+	{
+		addCounts(counts, analyzer->counts);
+		stats.add(analyzer->stats);
+		delete analyzer;
+	}
+	fprintf(stderr, "markov_train: %ld files (%ld skipped), %ld bars, %ld chords, %ld transitions\n", stats.files, stats.skipped, stats.bars, stats.chords, stats.transitions);
+	if (stats.transitions==0)
+	{
+		fprintf(stderr, "markov_train: no chord transitions found\n");
+		return 1;
+	}
+
+	// first order degree matrix, 7ths folded onto their degree
+	const int n=counts.num_symbols;
+	double matrix[7][7]={};
+	for (int from=0; from<n; ++from)
+		for (int to=0; to<n; ++to)
+			if ((from%7)!=(to%7))
+				matrix[from%7][to%7]+=counts.counts[1][(size_t)from*n+to];
+	for (int from=0; from<7; ++from)
+	{
+		double total=0;
+		for (int to=0; to<7; ++to)
+			total+=matrix[from][to];
+		for (int to=0; (total>0)&&(to<7); ++to)
+			matrix[from][to]/=total;
+	}
+
+	MarkovChain chain;
+	std::string chainPath=options.out+".mkc";
+	std::string matrixPath=options.out+".json";
+	std::string bankPath=options.out+".txt";
+	if ((!compileMarkovChain(counts, chain))||(!saveMarkovChain(chain, chainPath)))
+	{
+		fprintf(stderr, "markov_train: cannot write %s\n", chainPath.c_str());
+		return 1;
+	}
+
+	FILE* file=fopen(matrixPath.c_str(), "w");
+	if (!file)
+	{
+		fprintf(stderr, "markov_train: cannot write %s\n", matrixPath.c_str());
+		return 1;
+	}
+	fprintf(file, "{\"name\": \"%s\", \"matrix\": [\n", options.name.c_str());
+	for (int from=0; from<7; ++from)
+	{
+		fprintf(file, "\t[");
+		for (int to=0; to<7; ++to)
+			fprintf(file, "%.4f%s", matrix[from][to], (to<6) ? ", " : "");
+		fprintf(file, "]%s\n", (from<6) ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	fclose(file);
+
+	file=fopen(bankPath.c_str(), "w");
+	if (!file)
+	{
+		fprintf(stderr, "markov_train: cannot write %s\n", bankPath.c_str());
+		return 1;
+	}
+	fprintf(file, "# trained by markov_train from %ld files, %ld transitions\n", stats.files, stats.transitions);
+	fprintf(file, "%s 1st order | I - VII | 1 2 3 4 5 6 7 | markov %s\n", options.name.c_str(), baseName(matrixPath).c_str());
+	fprintf(file, "%s order %d | I - VII%s | %s | markov %s\n", options.name.c_str(), options.order, (options.sevenths) ? " & 7ths" : "",
+		(options.sevenths) ? "1 2 3 4 5 6 7 17 27 37 47 57 67 77" : "1 2 3 4 5 6 7", baseName(chainPath).c_str());
+	fclose(file);
+
+	static const char* degreeNames[7]={"I", "II", "III", "IV", "V", "VI", "VII"};
+	printf("float MarkovProgressionTransitionMatrix%s[8][8]={  // 8x8 so degrees can be 1 indexed\n", options.name.c_str());
+	printf("\t{0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00, 0.00},  // dummy\n");
+	for (int from=0; from<7; ++from)
+	{
+		printf("\t{0.00");
+		for (int to=0; to<7; ++to)
+			printf(", %.2f", matrix[from][to]);
+		printf("}%s  // %s\n", (from<6) ? "," : "};", degreeNames[from]);
+	}
+	printf("//   dummy  I     II    III   IV    V     VI    VII \n");
+	return 0;
+}
@@ -0,0 +1,287 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Golden event-stream check.  Runs the whole module, built against the Rack stub in tools/rackstub, for a fixed number
+// of bars in each of a few fixed configurations, and records every note the generators add to
+// played_notes_circular_buffer and every change of an output's voltage or channel count, by sample.  Compares each
+// stream with its golden file in tools/golden and prints the first difference, so a change to the clock, the
+// generators or the noise can be checked for identical musical output.  It also checks that the headless engine's
+// wavetable fBm follows the computed fBm over more bars than its tables hold at the arp's period of 1: the same notes,
+// and the arp fBm output within 0.01V.  Exits 1 if anything differs.  Build and run with "make golden".
+//
+// usage: meander_golden [--update] [--dir golden] [--only name]
+//
+// --update rewrites the golden files from this build.  Do that only for a change that is meant to alter the music.
+// The voltages are printed to 4 places, so a compiler that rounds float arithmetic differently can still match.
+
+#include "../src/Meander.cpp"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+Plugin *pluginInstance;
+
+static const char* outputNames[Meander::NUM_OUTPUTS] = {
+	"run", "reset", "tempo", "clock", "melody_gate", "harmony_gate", "bass_gate", "fbm_harmony", "melody_cv",
+	"fbm_melody", "bass_cv", "harmony_cv", "beatx2", "bar", "beatx4", "beatx8", "beat", "bass_trigger",
+	"harmony_trigger", "melody_trigger", "fbm_arp", "melody_volume", "harmony_volume", "bass_volume", "poly_scale"};
+
+struct GoldenConfig
+{
+	const char* name;
+	int preset;
+	int circlePosition;
+	int mode;
+	uint64_t seed;
+	float bpm;
+	int bars;
+};
+
+// a spread of presets, keys, modes and tempos, arp included
+static const GoldenConfig configs[] = {
+	{"preset14_C_ionian_120", 14, 0, 1, 1, 120.f, 8},
+	{"preset1_A_aeolian_200", 1, 3, 4, 7, 200.f, 8},
+	{"preset30_Eb_lydian_90", 30, 9, 0, 42, 90.f, 6},
+	{"preset58_F_locrian_300", 58, 11, 6, 1234, 300.f, 12},
+};
+
+struct GoldenMeander : Meander
+{
+	long sample = 0;
+	std::ostringstream* stream = nullptr;
+
+	void onNotePlayed(const struct note &playedNote) override
+	{
+		static const char* typeNames[] = {"chord", "melody", "arp", "bass", "external"};
+		const char* type = (playedNote.noteType >= 0 && playedNote.noteType <= NOTE_TYPE_EXTERNAL) ?
+			typeNames[playedNote.noteType] : "?";
+		char line[128];
+		snprintf(line, sizeof(line), "%ld note %s %d t%d len%d n%d\n", sample, type, playedNote.note, playedNote.time32s,
+			playedNote.length, playedNote.countInBar);
+		*stream << line;
+	}
+};
+
+static std::string run(const GoldenConfig& config)
+{
+	const float sampleRate = 48000.f;
+	std::ostringstream stream;
+	GoldenMeander* module = new GoldenMeander();
+	module->stream = &stream;
+	module->random_seed = config.seed;
+	module->setNoiseSeed(config.seed);
+	module->theMeanderState.theArpParms.enabled = true;
+	for (Output& output : module->outputs)
+		output.connected = true;
+	module->params[Meander::CONTROL_HARMONYPRESETS_PARAM].setValue(config.preset);
+	module->params[Meander::CONTROL_ROOT_KEY_PARAM].setValue(config.circlePosition);
+	module->params[Meander::CONTROL_SCALE_PARAM].setValue(config.mode);
+	module->params[Meander::CONTROL_TEMPOBPM_PARAM].setValue(config.bpm);
+
+	Module::ProcessArgs args;
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	args.frame = 0;
+	long samples = (long)(config.bars * 4 * 60.f / config.bpm * sampleRate);  // 4/4
+
+	std::vector<Output> last(module->outputs.size());
+	for (module->sample = 0; module->sample < samples; ++module->sample)
+	{
+		module->process(args);
+		for (size_t id = 0; id < module->outputs.size(); ++id)
+		{
+			Output& output = module->outputs[id];
+			char line[128];
+			if (output.channels != last[id].channels)
+			{
+				snprintf(line, sizeof(line), "%ld %s channels %d\n", module->sample, outputNames[id], output.channels);
+				stream << line;
+			}
+			for (int c = 0; c < std::max(output.channels, 1); ++c)
+				if (output.voltages[c] != last[id].voltages[c])
+				{
+					snprintf(line, sizeof(line), "%ld %s %d %.4f\n", module->sample, outputNames[id], c, output.voltages[c]);
+					stream << line;
+				}
+			last[id] = output;
+		}
+	}
+	delete module;
+	return stream.str();
+}
+
+struct NoteEngine : MeanderEngine
+{
+	int bar = 0;
+	int tick = 0;
+	std::ostringstream* stream = nullptr;
+	std::vector<float> fBmArp;  // the arp fBm output, each tick
+
+	void onNotePlayed(const struct note &playedNote) override
+	{
+		char line[64];
+		snprintf(line, sizeof(line), "%d %d %d %d\n", bar, tick, playedNote.noteType, playedNote.note);
+		*stream << line;
+	}
+
+	void setOutputVoltage(int outputId, float voltage, int channel) override
+	{
+		if (outputId == OUT_FBM_ARP_OUTPUT)
+			fBmArp.push_back(voltage);
+	}
+};
+
+struct WavetableConfig
+{
+	const char* name;
+	int preset;
+	uint64_t seed;
+	int bars;
+};
+
+// the tables hold 30 bars of the arp's fBm at its default period of 1, so these play well past their end
+static const WavetableConfig wavetableConfigs[] = {
+	{"wavetable_preset1_96bars", 1, 7, 96},
+	{"wavetable_preset31_96bars", 31, 3, 96},
+};
+
+// every note of config.bars with the arp on, with the fBm from the wavetables or computed, and the arp fBm output
+static std::string render(const WavetableConfig& config, bool wavetable, std::vector<float>& fBmArp)
+{
+	std::ostringstream stream;
+	NoteEngine* engine = new NoteEngine();
+	engine->stream = &stream;
+	engine->MeanderMusicStructuresInitialize();
+	engine->harmonyPresetBank = &theBuiltinHarmonyPresetBank;
+	engine->setNoiseSeed(config.seed);
+	engine->setHarmonyPreset(config.preset);
+	engine->rebuildCircle();
+	engine->random_seed = config.seed;
+	engine->theMeanderState.theArpParms.enabled = true;
+	engine->fBm_wavetable = wavetable;
+	if (wavetable)
+		engine->buildfBmWavetables(engine->noise);
+	engine->barts_count_limit = (32 * engine->time_sig_top / engine->time_sig_bottom);
+	for (engine->bar = 0; engine->bar < config.bars; ++engine->bar)
+		for (engine->tick = 0; engine->tick < engine->barts_count_limit; ++engine->tick)
+			engine->processClockTick();
+	fBmArp = engine->fBmArp;
+	delete engine;
+	return stream.str();
+}
+
+static bool read_file(const std::string& path, std::string& contents)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::ostringstream buffer;
+	buffer << file.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+// the first line where two streams differ, 1 based, or 0 if they are the same
+static int first_difference(const std::string& a, const std::string& b, std::string& lineA, std::string& lineB)
+{
+	std::istringstream streamA(a), streamB(b);
+	for (int line = 1;; ++line)
+	{
+		bool moreA = (bool)std::getline(streamA, lineA);
+		bool moreB = (bool)std::getline(streamB, lineB);
+		if (!moreA && !moreB)
+			return 0;
+		if (!moreA)
+			lineA = "(end)";
+		if (!moreB)
+			lineB = "(end)";
+		if (!moreA || !moreB || lineA != lineB)
+			return line;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool update = false;
+	std::string dir = "golden";
+	const char* only = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--update"))
+			update = true;
+		else if (!strcmp(argv[i], "--dir") && i + 1 < argc)
+			dir = argv[++i];
+		else if (!strcmp(argv[i], "--only") && i + 1 < argc)
+			only = argv[++i];
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	ConfigureGlobals();
+	int failures = 0;
+	for (const GoldenConfig& config : configs)
+	{
+		if (only && strcmp(only, config.name))
+			continue;
+		std::string path = dir + "/" + config.name + ".txt";
+		std::string events = run(config);
+		if (update)
+		{
+			std::ofstream file(path, std::ios::binary);
+			file << events;
+			printf("%-28s wrote %s\n", config.name, path.c_str());
+			continue;
+		}
+		std::string golden, lineA, lineB;
+		if (!read_file(path, golden))
+		{
+			printf("%-28s MISSING %s\n", config.name, path.c_str());
+			++failures;
+			continue;
+		}
+		int line = first_difference(golden, events, lineA, lineB);
+		if (line)
+		{
+			printf("%-28s DIFFERS at line %d\n    golden: %s\n    now:    %s\n", config.name, line, lineA.c_str(),
+				lineB.c_str());
+			++failures;
+		}
+		else
+			printf("%-28s same (%d lines)\n", config.name, (int)std::count(events.begin(), events.end(), '\n'));
+	}
+	for (const WavetableConfig& config : wavetableConfigs)
+	{
+		if (update || (only && strcmp(only, config.name)))
+			continue;
+		std::vector<float> fBmComputed, fBmRead;
+		std::string computed = render(config, false, fBmComputed), read = render(config, true, fBmRead), lineA, lineB;
+		int line = first_difference(computed, read, lineA, lineB);
+		if (line)
+		{
+			printf("%-28s DIFFERS at line %d\n    computed:  %s\n    wavetable: %s\n", config.name, line, lineA.c_str(),
+				lineB.c_str());
+			++failures;
+			continue;
+		}
+		size_t tick = 0;
+		while ((tick < fBmComputed.size()) && (std::fabs(fBmComputed[tick] - fBmRead[tick]) <= 0.01f))
+			++tick;
+		if (tick < fBmComputed.size())
+		{
+			printf("%-28s DIFFERS at bar %d tick %d\n    computed:  fbm_arp %.4f\n    wavetable: fbm_arp %.4f\n", config.name,
+				(int)tick / 32, (int)tick % 32, fBmComputed[tick], fBmRead[tick]);
+			++failures;
+		}
+		else
+			printf("%-28s same (%d notes, %d fbm_arp values)\n", config.name,
+				(int)std::count(computed.begin(), computed.end(), '\n'), (int)fBmComputed.size());
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Offline renderer.  Runs the headless MeanderEngine for N bars with a given harmony preset, key, mode and seed,
+// and prints one line per note event.  Needs no Rack SDK, build with "make meander_render".  The same arguments
+// always give the same output, and --from starts at any bar, generating the bars before it silently.
+//
+// usage: meander_render [--preset n] [--key C|G|...|0-11] [--mode Ionian|0-6] [--seed n] [--bars n] [--bpm n]
+//                       [--from bar] [--bank file] [--fbm computed|wavetable] [--noise-seed n]
+//
+// key is a circle of fifths position or note name, mode uses Meander's ordering: 0=Lydian 1=Ionian 2=Mixolydian
+// 3=Dorian 4=Aeolian 5=Phrygian 6=Locrian.  --bank takes the presets from a preset bank file rather than the built-in ones.
+// --fbm wavetable reads the fBm from the precomputed tables, as the module's "fBm noise" menu does.  --noise-seed
+// shuffles the noise permutation as a new module instance does; the default 0 is the reference permutation.
+
+#define MEANDER_HEADLESS
+#include "../src/MeanderEngine.hpp"
+
+#include <cstdlib>
+
+struct RenderEngine : MeanderEngine
+{
+	int bar=0;
+	int tick=0;
+	float secondsPerTick=0.f;
+
+	void onNotePlayed(const struct note &playedNote) override
+	{
+		static const char* typeNames[]={"chord","melody","arp","bass","external"};
+		const char* type=(playedNote.noteType>=0 && playedNote.noteType<=NOTE_TYPE_EXTERNAL) ? typeNames[playedNote.noteType] : "?";
+		printf("%d\t%d\t%.4f\t%s\t%d\t%s\n", bar, tick, (bar*barts_count_limit+tick)*secondsPerTick, type, playedNote.note, noteNames[playedNote.note%MAX_NOTES]);
+	}
+};
+
+static int lookupName(const char* arg, const char* const* names, int count, int (*match)(const char*, const char*))
+{
+	for (int i=0; i<count; ++i)
+		if (match(arg, names[i])==0)
+			return i;
+	return atoi(arg);
+}
+
+static int modePrefixMatch(const char* arg, const char* name)
+{
+	return strncasecmp(arg, name, strlen(arg));
+}
+
+int main(int argc, char** argv)
+{
+	int preset=14;
+	int circlePosition=0;
+	int modeIndex=1;
+	uint64_t seed=1;
+	int bars=16;
+	int fromBar=0;
+	float bpm=120.f;
+	const HarmonyPresetBank* bank=&theBuiltinHarmonyPresetBank;
+	bool fBmWavetable=false;
+	uint64_t noiseSeed=0;
+
+	init_vars();
+
+	for (int i=1; i+1<argc; i+=2)
+	{
+		const char* opt=argv[i];
+		const char* arg=argv[i+1];
+		if (!strcmp(opt, "--preset"))
+			preset=atoi(arg);
+		else if (!strcmp(opt, "--key"))
+			circlePosition=lookupName(arg, CircleNoteNames, MAX_NOTES, strcasecmp);
+		else if (!strcmp(opt, "--mode"))
+		{
+			const char* names[MAX_MODES];
+			for (int m=0; m<MAX_MODES; ++m)
+				names[m]=mode_names[m];
+			modeIndex=lookupName(arg, names, MAX_MODES, modePrefixMatch);
+		}
+		else if (!strcmp(opt, "--seed"))
+			seed=strtoull(arg, NULL, 10);
+		else if (!strcmp(opt, "--bars"))
+			bars=atoi(arg);
+		else if (!strcmp(opt, "--bpm"))
+			bpm=atof(arg);
+		else if (!strcmp(opt, "--from"))
+			fromBar=std::max(0, atoi(arg));
+		else if (!strcmp(opt, "--bank"))
+		{
+			bank=loadHarmonyPresetBank(arg);
+			if (!bank)
+			{
+				fprintf(stderr, "no presets in %s\n", arg);
+				return 1;
+			}
+		}
+		else if (!strcmp(opt, "--fbm"))
+			fBmWavetable=!strcasecmp(arg, "wavetable");
+		else if (!strcmp(opt, "--noise-seed"))
+			noiseSeed=strtoull(arg, NULL, 10);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", opt);
+			return 1;
+		}
+	}
+
+	preset=clamp(preset, 1, bank->size());
+	circlePosition=clamp(circlePosition, 0, MAX_NOTES-1);
+	modeIndex=clamp(modeIndex, 0, MAX_MODES-1);
+
+	RenderEngine* engine=new RenderEngine();
+	engine->MeanderMusicStructuresInitialize();
+	engine->circle_root_key=circlePosition;
+	engine->root_key=circle_of_fifths[circlePosition];
+	engine->mode=modeIndex;
+	engine->harmonyPresetBank=bank;
+	engine->fBm_wavetable=fBmWavetable;
+	engine->setNoiseSeed(noiseSeed);
+	engine->setHarmonyPreset(preset);
+	engine->rebuildCircle();
+	engine->random_seed=seed;
+	if (fBmWavetable)
+		engine->buildfBmWavetables(engine->noise);
+
+	engine->tempo=bpm;
+	engine->barts_count_limit=(32*engine->time_sig_top/engine->time_sig_bottom);
+	engine->secondsPerTick=60.f/(bpm*8.f);  // 32nd notes, 8 per quarter note beat
+
+	printf("# preset=%d key=%s mode=%s seed=%llu bars=%d-%d bpm=%g\n", preset, CircleNoteNames[circlePosition], mode_names[modeIndex], (unsigned long long)seed, fromBar, fromBar+bars-1, bpm);
+	printf("# bar\ttick\tseconds\ttype\tnote\tname\n");
+
+	engine->seekToBar(fromBar);
+	for (engine->bar=fromBar; engine->bar<fromBar+bars; ++engine->bar)
+	{
+		for (engine->tick=0; engine->tick<engine->barts_count_limit; ++engine->tick)
+			engine->processClockTick();
+	}
+
+	delete engine;
+	return 0;
+}
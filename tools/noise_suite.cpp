@@ -0,0 +1,293 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Noise throughput and quality suite.  For every noise and fBm function in src/Common-Noise.hpp, at every octave count
+// 1-6 for the fBm, reports the ns per sample and the range, mean, variance and spectral slope of the output.  Each
+// is sampled along x, every 1/256 of a lattice unit, as a modulation source is, the other coordinates held fixed.
+// The slope is of log power against log frequency from 0.5 to 16 cycles per unit: 1/f^2, a slope of -2, is what
+// summing octaves at half the amplitude per doubling of frequency aims for.
+//
+// Rows for the alternative backends (simplex, hash, wavetable, ramp, batch) are compared with the noise they would
+// replace: the speedup, and "same" when the mean is within 0.02, the variance within 15% and the slope within 0.3,
+// else "DIFFERS".  A backend should be both faster and "same" before the generators switch to it.
+// Needs no Rack SDK, build with "make noise_suite".
+//
+// usage: noise_suite [points=4096] [repeats=50] [name filter]
+
+#include "../src/Common-Noise.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+static const double DX = 1.0 / 256.0;      // sample spacing along x
+static const int SEGMENT = 8192;           // spectrum segment, 32 units
+static const int SEGMENTS = 16;
+static const int SAMPLES = SEGMENT * SEGMENTS;
+static const double X0 = 17.371;           // where the trace starts, off the lattice
+static const double FIXED[4] = {0.0, 3.217, 5.733, 9.151};  // the coordinates held fixed
+
+static double sink = 0.0;  // keeps the timed loops from being optimized away
+
+struct Result
+{
+	std::string name;
+	int octaves;
+	double ns, lo, hi, mean, variance, slope;
+};
+
+static std::vector<Result> results;
+
+// in-place radix 2 FFT, size a power of 2
+static void fft(std::vector<std::complex<double>>& a)
+{
+	int n = (int)a.size();
+	for (int i = 1, j = 0; i < n; ++i)
+	{
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(a[i], a[j]);
+	}
+	for (int len = 2; len <= n; len <<= 1)
+	{
+		std::complex<double> w(std::cos(-2.0 * M_PI / len), std::sin(-2.0 * M_PI / len));
+		for (int i = 0; i < n; i += len)
+		{
+			std::complex<double> wk(1.0, 0.0);
+			for (int k = 0; k < len / 2; ++k)
+			{
+				std::complex<double> u = a[i + k], v = a[i + k + len / 2] * wk;
+				a[i + k] = u + v;
+				a[i + k + len / 2] = u - v;
+				wk *= w;
+			}
+		}
+	}
+}
+
+// the least squares slope of log power against log frequency, the power averaged over Hann windowed segments
+static double spectral_slope(const std::vector<double>& trace, double mean)
+{
+	std::vector<double> power(SEGMENT / 2, 0.0);
+	std::vector<std::complex<double>> a(SEGMENT);
+	for (int s = 0; s < SEGMENTS; ++s)
+	{
+		for (int i = 0; i < SEGMENT; ++i)
+			a[i] = (trace[s * SEGMENT + i] - mean) * (0.5 - 0.5 * std::cos(2.0 * M_PI * i / SEGMENT));
+		fft(a);
+		for (int k = 1; k < SEGMENT / 2; ++k)
+			power[k] += std::norm(a[k]);
+	}
+	double units = SEGMENT * DX;
+	int first = (int)(0.5 * units), last = (int)(16.0 * units);
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	int n = 0;
+	for (int k = first; k <= last; ++k)
+	{
+		if (power[k] <= 0.0)
+			continue;
+		double x = std::log(k / units), y = std::log(power[k]);
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+		++n;
+	}
+	return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+// Runs one function: f(coords, count, out, octaves) fills out[i] for the points coords[0][i]..coords[3][i].  Times it
+// over the first points samples of the trace, best of repeats, then measures the whole trace.  With a reference,
+// compares against that row at the same octave count.
+template <class F>
+static void row(const char* name, int octaves, int points, int repeats, F f, const char* reference = nullptr)
+{
+	static std::vector<double> coords[4];
+	static std::vector<double> trace(SAMPLES);
+	if (coords[0].empty())
+		for (int d = 0; d < 4; ++d)
+		{
+			coords[d].resize(SAMPLES);
+			for (int i = 0; i < SAMPLES; ++i)
+				coords[d][i] = (d == 0) ? X0 + i * DX : FIXED[d];
+		}
+	const double* c[4] = {coords[0].data(), coords[1].data(), coords[2].data(), coords[3].data()};
+	points = std::min(points, SAMPLES);
+
+	double best = 1e30;
+	for (int r = 0; r < repeats; ++r)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f(c, points, trace.data(), octaves);
+		best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+		sink += trace[points - 1];
+	}
+
+	f(c, SAMPLES, trace.data(), octaves);
+	Result result = {name, octaves, best / points, 1e30, -1e30, 0.0, 0.0, 0.0};
+	for (double v : trace)
+	{
+		result.lo = std::min(result.lo, v);
+		result.hi = std::max(result.hi, v);
+		result.mean += v;
+	}
+	result.mean /= SAMPLES;
+	for (double v : trace)
+		result.variance += (v - result.mean) * (v - result.mean);
+	result.variance /= SAMPLES;
+	result.slope = spectral_slope(trace, result.mean);
+	results.push_back(result);
+
+	printf("%-32s %3s %9.2f  %7.3f %7.3f  %7.4f %7.4f  %6.2f", name, (octaves > 0) ? std::to_string(octaves).c_str() : "-",
+		result.ns, result.lo, result.hi, result.mean, result.variance, result.slope);
+	if (reference)
+		for (const Result& other : results)
+			if (other.name == reference && other.octaves == octaves)
+			{
+				bool same = std::fabs(result.mean - other.mean) < 0.02 &&
+					std::fabs(result.variance / other.variance - 1.0) < 0.15 && std::fabs(result.slope - other.slope) < 0.3;
+				printf("  %5.2fx %-7s vs %s", other.ns / result.ns, same ? "same" : "DIFFERS", reference);
+			}
+	printf("\n");
+}
+
+// a point by point function of the N coordinates, f(v, octaves), as a row function
+template <int N, class G>
+static auto per_point(G g) -> std::function<void(const double**, int, double*, int)>
+{
+	return [g](const double** c, int count, double* out, int octaves) {
+		for (int i = 0; i < count; ++i)
+		{
+			double v[4];
+			for (int d = 0; d < N; ++d)
+				v[d] = c[d][i];
+			out[i] = g(v, octaves);
+		}
+	};
+}
+
+static bool wanted(const char* filter, const char* name)
+{
+	return !filter || strstr(name, filter);
+}
+
+int main(int argc, char** argv)
+{
+	int points = (argc > 1) ? atoi(argv[1]) : 4096;
+	int repeats = (argc > 2) ? atoi(argv[2]) : 50;
+	const char* filter = (argc > 3) ? argv[3] : nullptr;
+	points = std::max(points, 1);
+	repeats = std::max(repeats, 1);
+
+	initPerlin();
+	bool reset = true;  // the 2D-4D fBm renormalize when this is set and the octave count changes
+
+	printf("%-32s %3s %9s  %7s %7s  %7s %7s  %6s\n", "function", "oct", "ns/sample", "min", "max", "mean", "var", "slope");
+
+	// the single noises
+	struct Noise
+	{
+		const char* name;
+		std::function<void(const double**, int, double*, int)> f;
+		const char* reference;
+	};
+	std::vector<Noise> noises = {
+		{"pnoise1", per_point<1>([](const double* v, int) { return pnoise1(v); }), nullptr},
+		{"hnoise1", per_point<1>([](const double* v, int) { return hnoise1(v, 1u); }), "pnoise1"},
+		{"pnoise2", per_point<2>([](const double* v, int) { return pnoise2(v); }), nullptr},
+		{"snoise2", per_point<2>([](const double* v, int) { return snoise2(v); }), "pnoise2"},
+		{"pnoise3", per_point<3>([](const double* v, int) { return pnoise3(v); }), nullptr},
+		{"npnoise3", per_point<3>([](const double* v, int) { return npnoise3(v); }), "pnoise3"},
+		{"snoise3", per_point<3>([](const double* v, int) { return snoise3(v); }), "pnoise3"},
+		{"npnoise4", per_point<4>([](const double* v, int) { return npnoise4(v); }), nullptr},
+		{"snoise4", per_point<4>([](const double* v, int) { return snoise4(v); }), "npnoise4"},
+	};
+	for (const Noise& noise : noises)
+		if (wanted(filter, noise.name))
+			row(noise.name, 0, points, repeats, noise.f, noise.reference);
+	printf("\n");
+
+	// the fBm, by octave count
+	fBm1DWavetable wavetable;
+	wavetable.build(X0);
+	std::vector<int> octaveCounts(SAMPLES);
+	std::vector<Noise> fBms = {
+		{"fBm1DNoise", per_point<1>([](const double* v, int n) { return fBm1DNoise(v[0], 2.0, 2.0, n); }), nullptr},
+		{"FastfBm1DNoise", per_point<1>([](const double* v, int n) { return FastfBm1DNoise(v[0], n); }), nullptr},
+		{"FastfBm1DNoiseBatch", [&](const double** c, int count, double* out, int n) {
+			std::fill(octaveCounts.begin(), octaveCounts.begin() + count, n);
+			FastfBm1DNoiseBatch(c[0], octaveCounts.data(), out, count);
+		}, "FastfBm1DNoise"},
+		{"fBm1DWavetable", [&](const double** c, int count, double* out, int n) {
+			for (int i = 0; i < count; ++i)
+				out[i] = wavetable.lookup(c[0][i] - X0, n);
+		}, "FastfBm1DNoise"},
+		{"FastfBm1DNoiseRamp", [](const double** c, int count, double* out, int n) {
+			for (int i = 0; i < count; i += 64)
+				FastfBm1DNoiseRamp(c[0][i], DX, n, out + i, std::min(64, count - i));
+		}, "FastfBm1DNoise"},
+		{"FastfBm1DHashNoise", per_point<1>([](const double* v, int n) { return FastfBm1DHashNoise(v[0], n, 1u); }),
+			"FastfBm1DNoise"},
+		{"FastfBm1DHashNoiseBlock", [](const double** c, int count, double* out, int n) {
+			FastfBm1DHashNoiseBlock(c[0], n, out, count, 1u);
+		}, "FastfBm1DNoise"},
+		{"fBm2DNoise", per_point<2>([&](const double* v, int n) { return fBm2DNoise(v[0], v[1], 2.0, 2.0, n, &reset); }),
+			nullptr},
+		{"fBm2DNoise simplex", per_point<2>([&](const double* v, int n) {
+			return fBm2DNoise(v[0], v[1], 2.0, 2.0, n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "fBm2DNoise"},
+		{"FastfBm2DNoise", per_point<2>([&](const double* v, int n) { return FastfBm2DNoise(v[0], v[1], n, &reset); }),
+			nullptr},
+		{"FastfBm2DNoise simplex", per_point<2>([&](const double* v, int n) {
+			return FastfBm2DNoise(v[0], v[1], n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "FastfBm2DNoise"},
+		{"fBm3DNoise", per_point<3>([&](const double* v, int n) {
+			return fBm3DNoise(v[0], v[1], v[2], 2.0, 2.0, n, &reset);
+		}), nullptr},
+		{"fBm3DNoise simplex", per_point<3>([&](const double* v, int n) {
+			return fBm3DNoise(v[0], v[1], v[2], 2.0, 2.0, n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "fBm3DNoise"},
+		{"FastfBm3DNoise", per_point<3>([&](const double* v, int n) {
+			return FastfBm3DNoise(v[0], v[1], v[2], n, &reset);
+		}), nullptr},
+		{"FastfBm3DNoise simplex", per_point<3>([&](const double* v, int n) {
+			return FastfBm3DNoise(v[0], v[1], v[2], n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "FastfBm3DNoise"},
+		{"fBm4DNoise", per_point<4>([&](const double* v, int n) {
+			return fBm4DNoise(v[0], v[1], v[2], v[3], 2.0, 2.0, n, &reset);
+		}), nullptr},
+		{"fBm4DNoise simplex", per_point<4>([&](const double* v, int n) {
+			return fBm4DNoise(v[0], v[1], v[2], v[3], 2.0, 2.0, n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "fBm4DNoise"},
+		{"FastfBm4DNoise", per_point<4>([&](const double* v, int n) {
+			return FastfBm4DNoise(v[0], v[1], v[2], v[3], n, &reset);
+		}), nullptr},
+		{"FastfBm4DNoise simplex", per_point<4>([&](const double* v, int n) {
+			return FastfBm4DNoise(v[0], v[1], v[2], v[3], n, &reset, theDefaultNoiseContext, NOISE_SIMPLEX);
+		}), "FastfBm4DNoise"},
+	};
+	for (const Noise& fBm : fBms)
+	{
+		if (!wanted(filter, fBm.name))
+			continue;
+		for (int n = 1; n <= 6; ++n)
+		{
+			reset = true;  // each row's first call sets this octave count's normalization
+			row(fBm.name, n, points, repeats, fBm.f, fBm.reference);
+		}
+		printf("\n");
+	}
+	return (sink != 0.5) ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+// The osdialog calls Meander.cpp makes, declared for tools/rackstub.  See rack.hpp.
+#pragma once
+typedef enum { OSDIALOG_INFO, OSDIALOG_WARNING, OSDIALOG_ERROR } osdialog_message_level;
+typedef enum { OSDIALOG_OK, OSDIALOG_OK_CANCEL, OSDIALOG_YES_NO } osdialog_message_buttons;
+typedef enum { OSDIALOG_OPEN, OSDIALOG_OPEN_DIR, OSDIALOG_SAVE } osdialog_file_action;
+typedef struct osdialog_filters osdialog_filters;
+int osdialog_message(osdialog_message_level, osdialog_message_buttons, const char*);
+char* osdialog_file(osdialog_file_action, const char*, const char*, osdialog_filters*);
+osdialog_filters* osdialog_filters_parse(const char*);
+void osdialog_filters_free(osdialog_filters*);
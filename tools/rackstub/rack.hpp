@@ -0,0 +1,389 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// A small stand-in for the parts of the VCV Rack v1 API that src/Meander.cpp uses, so the tools can build and run the
+// whole module, process() included, without the Rack SDK.  Ports, params, lights and the dsp helpers behave as in
+// Rack; the widgets, NanoVG and jansson are declarations only, enough to compile the panel code that the tools never
+// run.  Build with -Irackstub and link rackstub/rackstub.cpp.  Not for the plugin build.
+
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <list>
+#include <algorithm>
+
+#define DEBUG(...) do { } while (0)
+#define INFO(...) do { } while (0)
+#define WARN(...) do { } while (0)
+
+// jansson
+struct json_t;
+typedef long long json_int_t;
+json_t* json_object();
+json_t* json_object_get(json_t*, const char*);
+int json_object_set_new(json_t*, const char*, json_t*);
+json_t* json_boolean(bool);
+bool json_is_true(json_t*);
+json_t* json_integer(json_int_t);
+json_int_t json_integer_value(const json_t*);
+json_t* json_real(double);
+double json_real_value(const json_t*);
+json_t* json_string(const char*);
+const char* json_string_value(const json_t*);
+void json_decref(json_t*);
+
+// NanoVG
+struct NVGcontext;
+struct NVGcolor { float r, g, b, a; };
+NVGcolor nvgRGBA(int, int, int, int);
+NVGcolor nvgRGB(int, int, int);
+NVGcolor nvgTransRGBA(NVGcolor, int);
+void nvgFillColor(NVGcontext*, NVGcolor);
+void nvgStrokeColor(NVGcontext*, NVGcolor);
+void nvgText(NVGcontext*, float, float, const char*, const char*);
+void nvgFontSize(NVGcontext*, float);
+void nvgFontFaceId(NVGcontext*, int);
+void nvgTextLetterSpacing(NVGcontext*, float);
+void nvgTextAlign(NVGcontext*, int);
+void nvgBeginPath(NVGcontext*);
+void nvgClosePath(NVGcontext*);
+void nvgMoveTo(NVGcontext*, float, float);
+void nvgLineTo(NVGcontext*, float, float);
+void nvgArc(NVGcontext*, float, float, float, float, float, int);
+void nvgRect(NVGcontext*, float, float, float, float);
+void nvgRoundedRect(NVGcontext*, float, float, float, float, float);
+void nvgCircle(NVGcontext*, float, float, float);
+void nvgStrokeWidth(NVGcontext*, float);
+void nvgStroke(NVGcontext*);
+void nvgFill(NVGcontext*);
+void nvgSave(NVGcontext*);
+void nvgRestore(NVGcontext*);
+enum { NVG_ALIGN_LEFT=1, NVG_ALIGN_CENTER=2, NVG_ALIGN_RIGHT=4, NVG_ALIGN_TOP=8, NVG_ALIGN_MIDDLE=16, NVG_ALIGN_BOTTOM=32,
+	NVG_ALIGN_BASELINE=64, NVG_CW=2, NVG_CCW=1 };
+
+namespace rack {
+
+template <typename T> T clamp(T x, T a, T b) { return std::min(std::max(x, a), b); }
+inline float clamp(float x, double a, double b) { return std::min(std::max(x, (float)a), (float)b); }
+
+namespace math {
+struct Vec
+{
+	float x = 0, y = 0;
+	Vec() {}
+	Vec(float x, float y) : x(x), y(y) {}
+	Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+	Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+	Vec mult(float s) const { return Vec(x * s, y * s); }
+	Vec div(float s) const { return Vec(x / s, y / s); }
+	float norm() const { return std::hypot(x, y); }
+	Vec normalize() const { return div(norm()); }
+};
+struct Rect
+{
+	Vec pos, size;
+	Rect() {}
+	Rect(Vec pos, Vec size) : pos(pos), size(size) {}
+	Rect(float x, float y, float w, float h) : pos(x, y), size(w, h) {}
+	Vec getCenter() const { return pos.plus(size.mult(0.5f)); }
+};
+inline float rescale(float x, float a, float b, float c, float d) { return c + (x - a) / (b - a) * (d - c); }
+using rack::clamp;
+}
+using math::Vec;
+using math::Rect;
+inline float mm2px(float mm) { return mm * 75.f / 25.4f; }
+inline Vec mm2px(Vec v) { return v.mult(75.f / 25.4f); }
+
+namespace random {
+void init();
+float uniform();
+float normal();
+uint32_t u32();
+}
+
+namespace dsp {
+struct SchmittTrigger
+{
+	bool state = true;
+	void reset() { state = true; }
+	bool process(float in)
+	{
+		if (state)
+		{
+			if (in <= 0.f)
+				state = false;
+		}
+		else if (in >= 1.f)
+		{
+			state = true;
+			return true;
+		}
+		return false;
+	}
+};
+struct PulseGenerator
+{
+	float remaining = 0.f;
+	void reset() { remaining = 0.f; }
+	bool process(float deltaTime)
+	{
+		if (remaining > 0.f)
+		{
+			remaining -= deltaTime;
+			return true;
+		}
+		return false;
+	}
+	void trigger(float duration = 1e-3f) { remaining = std::max(remaining, duration); }
+};
+struct ClockDivider
+{
+	uint32_t clock = 0, division = 1;
+	void reset() { clock = 0; }
+	void setDivision(uint32_t d) { division = d; }
+	uint32_t getDivision() { return division; }
+	uint32_t getClock() { return clock; }
+	bool process()
+	{
+		if (++clock >= division)
+		{
+			clock = 0;
+			return true;
+		}
+		return false;
+	}
+};
+}
+
+namespace engine {
+static const int PORT_MAX_CHANNELS = 16;
+struct Param
+{
+	float value = 0.f;
+	float getValue() { return value; }
+	void setValue(float v) { value = v; }
+};
+struct Port
+{
+	float voltages[PORT_MAX_CHANNELS] = {};
+	int channels = 0;
+	bool connected = false;  // set by the tool to patch a cable
+	void setVoltage(float v, int c = 0) { voltages[c] = v; }
+	float getVoltage(int c = 0) { return voltages[c]; }
+	void setChannels(int c) { channels = c; }
+	int getChannels() { return channels; }
+	bool isConnected() { return connected; }
+};
+struct Input : Port {};
+struct Output : Port {};
+struct Light
+{
+	float value = 0.f;
+	void setBrightness(float b) { value = b; }
+	float getBrightness() { return value; }
+};
+struct ParamQuantity
+{
+	float minValue = 0.f, maxValue = 1.f, defaultValue = 0.f;
+	std::string label, unit;
+	virtual ~ParamQuantity() {}
+};
+struct Module
+{
+	int64_t id = 0;
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+
+	struct ProcessArgs { float sampleRate; float sampleTime; int64_t frame; };
+	struct SampleRateChangeEvent { float sampleRate; float sampleTime; };
+
+	void config(int numParams, int numInputs, int numOutputs, int numLights)
+	{
+		params.resize(numParams);
+		inputs.resize(numInputs);
+		outputs.resize(numOutputs);
+		lights.resize(numLights);
+		paramQuantities.resize(numParams);
+	}
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configParam(int paramId, float, float, float defaultValue, std::string = "", std::string = "",
+		float = 0.f, float = 1.f, float = 0.f)
+	{
+		params[paramId].value = defaultValue;
+		return nullptr;
+	}
+	virtual ~Module() {}
+	virtual void process(const ProcessArgs&) {}
+	virtual json_t* dataToJson() { return nullptr; }
+	virtual void dataFromJson(json_t*) {}
+	virtual void onReset() {}
+	virtual void onRandomize() {}
+	virtual void onSampleRateChange() {}
+};
+struct Engine
+{
+	float getSampleRate();
+	float getSampleTime();
+};
+}
+using engine::PORT_MAX_CHANNELS;
+using engine::Module;
+using engine::Param;
+using engine::Input;
+using engine::Output;
+using engine::Light;
+using engine::ParamQuantity;
+
+struct Font { int handle; };
+struct Svg {};
+namespace window {
+struct Window
+{
+	std::shared_ptr<Font> uiFont;
+	std::shared_ptr<Font> loadFont(std::string);
+	std::shared_ptr<Svg> loadSvg(std::string);
+};
+}
+
+namespace widget {
+struct Widget
+{
+	math::Rect box;
+	Widget* parent = nullptr;
+	struct DrawArgs { NVGcontext* vg; math::Rect clipBox; };
+	virtual ~Widget() {}
+	virtual void draw(const DrawArgs&) {}
+	virtual void step() {}
+	void addChild(Widget*);
+	template <class T> T* getAncestorOfType() { return nullptr; }
+};
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+struct FramebufferWidget : Widget {};
+}
+using widget::Widget;
+using widget::TransparentWidget;
+using widget::OpaqueWidget;
+
+namespace ui {
+struct ActionEvent {};
+struct Menu : widget::OpaqueWidget { void addChild(Widget*); };
+struct MenuEntry : widget::OpaqueWidget {};
+struct MenuLabel : MenuEntry { std::string text; };
+struct MenuSeparator : MenuEntry {};
+struct MenuItem : MenuEntry
+{
+	std::string text, rightText;
+	virtual void onAction(const ActionEvent&) {}
+	virtual void step() {}
+	virtual Menu* createChildMenu() { return nullptr; }
+};
+}
+using ui::Menu;
+using ui::MenuItem;
+using ui::MenuLabel;
+using ui::MenuEntry;
+using ui::MenuSeparator;
+namespace event {
+using ui::ActionEvent;
+using Action = ui::ActionEvent;
+}
+
+namespace app {
+struct ParamWidget : widget::OpaqueWidget {};
+struct PortWidget : widget::OpaqueWidget {};
+struct Knob : ParamWidget { bool snap = false; float minAngle, maxAngle; };
+struct SvgPort : PortWidget { void setSvg(std::shared_ptr<Svg>); };
+struct LightWidget : widget::TransparentWidget {};
+struct ModuleLightWidget : LightWidget {};
+struct LedDisplay : widget::OpaqueWidget {};
+struct ModuleWidget : widget::OpaqueWidget
+{
+	engine::Module* module = nullptr;
+	void setModule(engine::Module* m) { module = m; }
+	void setPanel(std::shared_ptr<Svg>);
+	void addParam(ParamWidget*);
+	void addInput(PortWidget*);
+	void addOutput(PortWidget*);
+	void addChild(widget::Widget*);
+	virtual void appendContextMenu(ui::Menu*) {}
+	void step() override {}
+	void draw(const DrawArgs&) override {}
+};
+struct CableWidget : widget::OpaqueWidget { struct { int64_t id; }* cable; };
+struct RackWidget { std::list<CableWidget*> getCablesOnPort(PortWidget*); };
+struct Scene { RackWidget* rack; };
+struct App { engine::Engine* engine; window::Window* window; Scene* scene; };
+}
+using app::ModuleWidget;
+using app::ParamWidget;
+using app::PortWidget;
+using app::SvgPort;
+using app::LightWidget;
+using app::LedDisplay;
+using app::CableWidget;
+using app::Knob;
+app::App* appGet();
+#define APP rack::appGet()
+
+// componentlibrary
+struct LEDButton : app::ParamWidget {};
+struct Trimpot : app::Knob {};
+struct RoundBlackKnob : app::Knob {};
+struct RoundSmallBlackKnob : app::Knob {};
+struct ScrewSilver : app::SvgPort {};
+struct PJ301MPort : app::SvgPort {};
+template <class TBase> struct MediumLight : TBase {};
+struct RedLight : app::ModuleLightWidget {};
+struct GreenLight : app::ModuleLightWidget {};
+static const float RACK_GRID_WIDTH = 15.f;
+static const float RACK_GRID_HEIGHT = 380.f;
+void bndSetFont(int);
+
+// helpers
+template <class T> T* createWidget(Vec) { return new T; }
+template <class T> T* createParamCentered(Vec, engine::Module*, int) { return new T; }
+template <class T> T* createInputCentered(Vec, engine::Module*, int) { return new T; }
+template <class T> T* createOutputCentered(Vec, engine::Module*, int) { return new T; }
+template <class T> T* createLightCentered(Vec, engine::Module*, int) { return new T; }
+template <class T> T* createMenuItem(std::string text, std::string rightText = "")
+{
+	T* item = new T;
+	item->text = text;
+	item->rightText = rightText;
+	return item;
+}
+template <class T = ui::MenuLabel> T* createMenuLabel(std::string text)
+{
+	T* label = new T;
+	label->text = text;
+	return label;
+}
+#define CHECKMARK(x) ((x) ? "✔" : "")
+
+struct Model {};
+struct Plugin { void addModel(Model*); };
+template <class TModule, class TModuleWidget> Model* createModel(std::string) { return new Model; }
+
+namespace asset {
+std::string plugin(Plugin*, std::string);
+std::string user(std::string);
+}
+namespace system { std::string getDirectory(std::string); }
+namespace string { std::string filename(const std::string&); }
+
+}  // namespace rack
+
+using namespace rack;
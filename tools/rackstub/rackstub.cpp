@@ -0,0 +1,42 @@
+/*  Copyright (C) 2019-2020 Ken Chaffin
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// The few Rack, jansson and osdialog functions the module calls while it runs.  The json functions build nothing, so
+// dataToJson() runs but saves nothing.
+
+#include <rack.hpp>
+#include <osdialog.h>
+#include <random>
+
+static std::mt19937 rng(1234);  // fixed, so runs repeat
+
+namespace rack {
+namespace random {
+void init() {}
+float uniform() { return std::uniform_real_distribution<float>(0.f, 1.f)(rng); }
+float normal() { return std::normal_distribution<float>()(rng); }
+uint32_t u32() { return rng(); }
+}
+std::string string::filename(const std::string& path) { return path; }
+}
+
+json_t* json_object() { return nullptr; }
+json_t* json_object_get(json_t*, const char*) { return nullptr; }
+int json_object_set_new(json_t*, const char*, json_t*) { return 0; }
+json_t* json_boolean(bool) { return nullptr; }
+bool json_is_true(json_t*) { return false; }
+json_t* json_integer(json_int_t) { return nullptr; }
+json_int_t json_integer_value(const json_t*) { return 0; }
+json_t* json_real(double) { return nullptr; }
+double json_real_value(const json_t*) { return 0.0; }
+json_t* json_string(const char*) { return nullptr; }
+const char* json_string_value(const json_t*) { return ""; }
+void json_decref(json_t*) {}
+
+int osdialog_message(osdialog_message_level, osdialog_message_buttons, const char*) { return 0; }
+char* osdialog_file(osdialog_file_action, const char*, const char*, osdialog_filters*) { return nullptr; }
+osdialog_filters* osdialog_filters_parse(const char*) { return nullptr; }
+void osdialog_filters_free(osdialog_filters*) {}